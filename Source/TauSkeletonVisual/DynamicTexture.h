@@ -17,10 +17,9 @@ struct FDynamicTextureBuffer
 
 	void SetPixelBuffer(uint8_t* Value, int32 bufferCount)
 	{
-		PixelBuffer.Empty();
-		for (int i = 0; i < bufferCount; i++) {
-			PixelBuffer.Add(Value[i]);
-		}
+		// Same size every update, so the copy reuses the existing allocation
+		PixelBuffer.SetNumUninitialized(bufferCount, false);
+		FMemory::Memcpy(PixelBuffer.GetData(), Value, bufferCount);
 	}
 
 	FDynamicTextureBuffer()
@@ -7,6 +7,18 @@
 #include "UObject/UObjectGlobals.h"
 #include "Math/Vector.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+#include "TriangleGeometryKernels.h"
+#include "TauPredicates.h"
+#include "TauFloatEnvironment.h"
+#include "TauAllocationAudit.h"
+#include "TauSkeletonVisual.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Robust Circumcenters"), STAT_TauRobustCircumcenters, STATGROUP_TauSkeleton);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Exact Predicate Evaluations"), STAT_TauExactPredicates, STATGROUP_TauSkeleton);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Degenerate Triangles"), STAT_TauDegenerateTriangles, STATGROUP_TauSkeleton);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Non-Finite Tau Samples"), STAT_TauNonFiniteSamples, STATGROUP_TauSkeleton);
 
 // Classes below from circumcenter.cpp in MeshKit   https://bitbucket.org/fathomteam/meshkit.git
 #include <stdlib.h>
@@ -188,16 +200,9 @@ void tetcircumcenter(double a[3], double b[3], double c[3], double d[3],
 	zcrossbc = xba * yca - xca * yba;
 
 	/* Calculate the denominator of the formulae. */
-#ifdef EXACT
   /* Use orient3d() from http://www.cs.cmu.edu/~quake/robust.html     */
-  /*   to ensure a correctly signed (and reasonably accurate) result, */
-  /*   avoiding any possibility of division by zero.                  */
-	denominator = 0.5 / orient3d(b, c, d, a);
-#else
-  /* Take your chances with floating-point roundoff. */
-	printf(" Warning: IEEE floating points used: Define -DEXACT in makefile \n");
-	denominator = 0.5 / (xba * xcrosscd + yba * ycrosscd + zba * zcrosscd);
-#endif
+  /*   to ensure a correctly signed (and reasonably accurate) result. */
+	denominator = 0.5 / TauPredicates::Orient3D(b, c, d, a);
 
 	/* Calculate offset (from `a') of circumcenter. */
 	xcirca = (balength * xcrosscd + calength * xcrossdb + dalength * xcrossbc) *
@@ -269,15 +274,9 @@ void tricircumcenter(double a[2], double b[2], double c[2], double circumcenter[
 	calength = xca * xca + yca * yca;
 
 	/* Calculate the denominator of the formulae. */
-#ifdef EXACT
   /* Use orient2d() from http://www.cs.cmu.edu/~quake/robust.html     */
-  /*   to ensure a correctly signed (and reasonably accurate) result, */
-  /*   avoiding any possibility of division by zero.                  */
-	denominator = 0.5 / orient2d(b, c, a);
-#else
-  /* Take your chances with floating-point roundoff. */
-	denominator = 0.5 / (xba * yca - yba * xca);
-#endif
+  /*   to ensure a correctly signed (and reasonably accurate) result. */
+	denominator = 0.5 / TauPredicates::Orient2D(b, c, a);
 
 	/* Calculate offset (from `a') of circumcenter. */
 	xcirca = (yca * balength - yba * calength) * denominator;
@@ -342,38 +341,24 @@ void tricircumcenter3d(double a[3], double b[3], double c[3], double circumcente
 	calength = xca * xca + yca * yca + zca * zca;
 
 	/* Cross product of these edges. */
-#ifdef EXACT
-  /* Use orient2d() from http://www.cs.cmu.edu/~quake/robust.html     */
-  /*   to ensure a correctly signed (and reasonably accurate) result, */
-  /*   avoiding any possibility of division by zero.                  */
+  /* orient2d() from http://www.cs.cmu.edu/~quake/robust.html, via     */
+  /*   TauPredicates, ensures a correctly signed (and accurate) result. */
+	double A[2], B[2], C[2];
 
 	A[0] = b[1]; A[1] = b[2];
 	B[0] = c[1]; B[1] = c[2];
 	C[0] = a[1]; C[1] = a[2];
-	xcrossbc = orient2d(A, B, C);
+	xcrossbc = TauPredicates::Orient2D(A, B, C);
 
 	A[0] = c[0]; A[1] = c[2];
 	B[0] = b[0]; B[1] = b[2];
 	C[0] = a[0]; C[1] = a[2];
-	ycrossbc = orient2d(A, B, C);
+	ycrossbc = TauPredicates::Orient2D(A, B, C);
 
 	A[0] = b[0]; A[1] = b[1];
 	B[0] = c[0]; B[1] = c[1];
 	C[0] = a[0]; C[1] = a[1];
-	zcrossbc = orient2d(A, B, C);
-
-	/*
-	xcrossbc = orient2d(b[1], b[2], c[1], c[2], a[1], a[2]);
-	ycrossbc = orient2d(b[2], b[0], c[2], c[0], a[2], a[0]);
-	zcrossbc = orient2d(b[0], b[1], c[0], c[1], a[0], a[1]);
-	*/
-#else
-	printf(" Warning: IEEE floating points used: Define -DEXACT in makefile \n");
-	/* Take your chances with floating-point roundoff. */
-	xcrossbc = yba * zca - yca * zba;
-	ycrossbc = zba * xca - zca * xba;
-	zcrossbc = xba * yca - xca * yba;
-#endif
+	zcrossbc = TauPredicates::Orient2D(A, B, C);
 
 	/* Calculate the denominator of the formulae. */
 	denominator = 0.5 / (xcrossbc * xcrossbc + ycrossbc * ycrossbc +
@@ -444,1219 +429,555 @@ void TriCircumCenter3D(double* a, double* b, double* c, double* result)
 	result[2] += a[2];
 }
 
-FJointBufferThread::FJointBufferThread(TArray<FName>_BoneNames, TArray<FVector>_Locations, TArray<FRotator>_Rotations, TArray<float>_Confidences, std::vector<UTauBuffer*>_PreviousTriangleTauBuffers, UNuitrackSkeletonJointBuffer* _JointBuffer)
+/**
+ * Stage of a joint buffer frame on the task graph. Unlike FFunctionGraphTask it holds no TFunction,
+ * so the whole task comes from the task graph's recycled small-task memory.
+ */
+class FJointBufferTask
+{
+public:
+	FJointBufferTask(FJointBufferThread* InThread, FJointBufferThread::FTaskFunction InFunction, FJointBufferFrame* InFrame)
+		: Thread(InThread)
+		, Function(InFunction)
+		, Frame(InFrame)
+	{
+	}
+
+	static ESubsequentsMode::Type GetSubsequentsMode() { return ESubsequentsMode::TrackSubsequents; }
+	ENamedThreads::Type GetDesiredThread() { return ENamedThreads::AnyThread; }
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FJointBufferTask, STATGROUP_TaskGraphTasks); }
+
+	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+	{
+		FTauAllocationAuditRegion AuditRegion;
+		(Thread->*Function)(Frame);
+	}
+
+private:
+	FJointBufferThread* Thread;
+	FJointBufferThread::FTaskFunction Function;
+	FJointBufferFrame* Frame;
+};
+
+// Takes chunks of a range job alongside the thread that started it. Nothing waits on the task itself.
+class FTriangleRangeHelperTask
+{
+public:
+	explicit FTriangleRangeHelperTask(FTriangleRangeJob* InJob)
+		: Job(InJob)
+	{
+	}
+
+	static ESubsequentsMode::Type GetSubsequentsMode() { return ESubsequentsMode::FireAndForget; }
+	ENamedThreads::Type GetDesiredThread() { return ENamedThreads::AnyThread; }
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FTriangleRangeHelperTask, STATGROUP_TaskGraphTasks); }
+
+	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+	{
+		FTauAllocationAuditRegion AuditRegion;
+		Job->Help();
+	}
+
+private:
+	FTriangleRangeJob* Job;
+};
+
+void FTriangleRangeJob::RunChunks()
 {
-	if (_JointBuffer) {
-		SocketBoneNames = _BoneNames;
-		SocketLocations = _Locations;
-		SocketRotations = _Rotations;
-		SocketConfidences = _Confidences;
-		JointBuffer = _JointBuffer;
-		TriangleTauBuffers = _PreviousTriangleTauBuffers;
+	for (;;) {
+		const int32 Chunk = FPlatformAtomics::InterlockedIncrement(&NextChunk) - 1;
+		if (Chunk >= ChunkCount) {
+			break;
+		}
+		FTauDenormalScope DenormalScope;
+		(*Body)(Chunk * GrainSize, FMath::Min((Chunk + 1) * GrainSize, TriangleCount));
+	}
+}
+
+void FTriangleRangeJob::Help()
+{
+	// Counted as active before taking a chunk, so the caller cannot return while this helper still runs Body
+	FPlatformAtomics::InterlockedIncrement(&ActiveHelpers);
+	RunChunks();
+	FPlatformAtomics::InterlockedDecrement(&ActiveHelpers);
+	FPlatformAtomics::InterlockedDecrement(&References);
+}
+
+FJointBufferThread::FJointBufferThread(UNuitrackSkeletonJointBuffer* _JointBuffer, bool _bUseSharedWorkerPool)
+{
+	JointBuffer = _JointBuffer;
+	bUseSharedWorkerPool = _bUseSharedWorkerPool;
+	Topology = JointBuffer->GetCompiledTopology();
+	SmoothingSamplesCount = FMath::Max(JointBuffer->SmoothingSamplesCount, 1);
+	DegenerateQuality = FMath::Max(JointBuffer->DegenerateTriangleQuality, 0.f);
+	TauStatePool = JointBuffer->GetTauStatePool();
+	TauStates = nullptr;
+	PublishedNonFiniteSamples = 0;
+	bPoolDispatchQueued = false;
+	bStopThread = false;
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	bHasPendingFrame = false;
+	PendingFramePostTime = 0;
+	LastWakeLatency = 0;
+	TotalWakeLatency = 0;
+	WokenFrameCount = 0;
+	PublishedSequence = 0;
+	LastComputeSeconds = 0;
+	bPipelinedStages = false;
+	PendingTauMathMode = ETauMathMode::Precise;
+	NextFrameIndex = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Stage = 0; Stage < (int32)EJointBufferStage::Count; Stage++) {
+		StageBusyCycles[Stage] = 0;
 	}
 }
 
 FJointBufferThread::~FJointBufferThread()
 {
-	TriangleTauBuffers.clear();
+	// Hands the block back for the next user instead of freeing it
+	TauStates = nullptr;
+	TauStatePool->Release(TauStateHandle);
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
 }
 
 
 bool FJointBufferThread::Init()
 {
 	bStopThread = false;
-	bProcessComplete = false;
 	return true;
 }
 
 uint32 FJointBufferThread::Run()
 {
+	StartTime = FPlatformTime::Seconds();
 
-
-	while (!bStopThread && !bProcessComplete) {
-		ProcessSocketRawData();
-		JointBuffer->TriangleIndexesQueue.Enqueue(TriangleIndexes);
-		JointBuffer->TrianglePositionsQueue.Enqueue(TrianglePositions);
-		JointBuffer->TriangleIndexBoneNamesQueue.Enqueue(TriangleIndexBoneNames);
-		JointBuffer->TriangleRotationsQueue.Enqueue(TriangleRotations);
-		JointBuffer->TriangleCentroidsQueue.Enqueue(TriangleCentroids);
-		JointBuffer->TriangleCircumcentersQueue.Enqueue(TriangleCircumcenters);
-		JointBuffer->EulerLinesQueue.Enqueue(EulerLines);
-		JointBuffer->TriangleTauBuffersQueue.Enqueue(TriangleTauBuffers);
-		bProcessComplete = true;
+	while (!bStopThread) {
+		WorkEvent->Wait();
+		if (bStopThread) {
+			break;
+		}
+		FTauAllocationAuditRegion AuditRegion;
+		RunPendingFrame();
 	}
 
+	WaitForOutstandingTasks();
 	return 0;
 }
 
 void FJointBufferThread::Stop()
 {
-
+	bStopThread = true;
+	WorkEvent->Trigger();
 }
 
-void FJointBufferThread::ProcessSocketRawData()
+void FJointBufferThread::RunPendingFrame()
 {
-	if (SocketBoneNames.Num() < 1) {
-		return;
+	// Reuse the oldest slot once its tau stage has finished with it
+	FJointBufferFrame& Frame = Frames[NextFrameIndex];
+	if (Frame.CompletionEvent.IsValid()) {
+		// A pool task must not block on another pool task, so it runs again once the slot is free.
+		// The pending frame stays where it is and may still be replaced by a newer one meanwhile.
+		if (bUseSharedWorkerPool && !Frame.CompletionEvent->IsComplete()) {
+			DispatchPoolFrame(Frame.CompletionEvent);
+			return;
+		}
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(Frame.CompletionEvent);
+		Frame.CompletionEvent = nullptr;
 	}
 
-	UpdateTriangles(SocketBoneNames, SocketLocations, SocketRotations);
-	UpdateDebugLines();
-	UpdateEulerLines();
-	UpdateTracking();
-}
-
-
-
-/*
-[0] = joints[JointType::JOINT_HEAD]
-[1] = joints[JointType::JOINT_NECK]
-[2] = joints[JointType::JOINT_TORSO]
-[3] joints[JointType::JOINT_WAIST]
-
-[4] joints[JointType::JOINT_LEFT_SHOULDER]
-[5] joints[JointType::JOINT_LEFT_ELBOW]
-[6] joints[JointType::JOINT_LEFT_WRIST]
-[7] joints[JointType::JOINT_LEFT_HAND]
-
-[8] joints[JointType::JOINT_RIGHT_SHOULDER]
-[9] joints[JointType::JOINT_RIGHT_ELBOW]
-[10] joints[JointType::JOINT_RIGHT_WRIST]
-[11] joints[JointType::JOINT_RIGHT_HAND]
-
-[12] joints[JointType::JOINT_LEFT_HIP]
-[13] joints[JointType::JOINT_LEFT_KNEE]
-[14] joints[JointType::JOINT_LEFT_ANKLE]
-
-[15] joints[JointType::JOINT_RIGHT_HIP]
-[16] joints[JointType::JOINT_RIGHT_KNEE]
-[17] joints[JointType::JOINT_RIGHT_ANKLE]
-*/
-void FJointBufferThread::UpdateTriangles(TArray<FName>BoneNames, TArray<FVector>Locations, TArray<FRotator>Rotations)
-{
-	TriangleIndexes = {
-		1,
-		12,
-		15,
-		1,
-		14,
-		17,
-		3,
-		4,
-		8,
-		3,
-		7,
-		11,
-		3,
-		12,
-		15,
-		1,
-		8,
-		2,
-		1,
-		8,
-		3,
-		1,
-		9,
-		10,
-		1,
-		9,
-		17,
-		3,
-		8,
-		1,
-		3,
-		8,
-		10,
-		3,
-		15,
-		17,
-		3,
-		9,
-		10,
-		15,
-		8,
-		12,
-		15,
-		8,
-		9,
-		15,
-		8,
-		10,
-		15,
-		1,
-		8,
-		15,
-		9,
-		10,
-		15,
-		16,
-		13,
-		15,
-		16,
-		17,
-		16,
-		8,
-		9,
-		16,
-		8,
-		13,
-		16,
-		15,
-		12,
-		16,
-		17,
-		14,
-		17,
-		8,
-		4,
-		17,
-		16,
-		13,
-		// Left Side Head
-1,		// Head
-4,		// Left Shoulder
-2,		// Neck
-
-1,		// Head
-4,		// Left Shoulder
-3,		// Spine 1
-
-1,		// Head
-5,		// Left Arm
-6,	// Left  Wrist
-
-1,		// Head
-5,		// Left Arm
-14,	// Left Foot
-
-
-//Left Side Chest
-3,		// Spine 1
-4,		// Left Shoulder
-5,		// Left Arm
-
-3,		// Spine 1
-4,		// Left Shoulder
-6,		// Left Wrist
-
-3,		// Spine 1
-12,	// Left Leg Up
-14,	// Left Foot
-
-3,		// Spine 1
-5,		// Left Arm
-6,	// Left Hand
-
-// Left Side Hip
-12,	// Left Leg Up 
-4,		// Left Shoulder
-15,	// Right Leg Up
-
-12,	// Left Leg Up 
-4,		// Left Shoulder
-5,		// Left Arm
-
-12,	// Left Leg Up 
-4,		// Left Shoulder
-6,	// Left Wrist
-
-12,	// Left Leg Up  
-2,		// Neck
-4,		// Left Shoulder
-
-12,	// Left Leg Up 
-5,		// Left Arm
-6,	// Left Wrist
-
-12,	// Left Leg Up 
-13,	// Left Leg
-16,	// Right Leg
-
-12,	// Left Leg Up 
-13,	// Left Leg
-14,	// Left Foot 
-
-// Left Side Leg
-13,	// Left Leg
-4,		// Left Shoulder
-5,		// Left Arm
-
-13,	// Left Leg
-4,		// Left Shoulder 
-16,	// Right Leg
-
-13,	// Left Leg
-12,	// Left Leg Up
-15,	// Right Leg Up
-
-13,	// Left Leg
-14,	// Left Foot 
-17,	// Right Foot
-
-// Left Side Ankle
-14,	// Left Foot
-4,		// Left Shoulder
-8,	// Right Shoulder
-
-14,	// Left Foot
-13,	// Left Leg
-16,	// Right Leg
-
-// Cross Center
-1,		// Head
-9,	// Right Elbow
-14,	// Left Foot
-
-1,		// Head
-5,		// Left Elbow
-17,	// Right Foot
-
-1,		// Head
-9,	// Right Elbow
-6,	// Left Wrist
-
-1,		// Head
-5,		// Left Elbow
-10,	// Right WRist
-
-3,		// Spine 1
-15,	// Right Hip
-6,	// Left Wrist
-
-3,		// Spine 1
-12,	// Left Hip
-10,	// Right Wrist
-
-3,		// Spine 1
-8,	// Right Shoulder
-6,	// Left Wrist
-
-3,		// Spine 1
-4,		// Left Shoulder
-10,	// Right Wrist
-
-15,	// Right Up Leg 
-4,		// Left Shoulder
-9,	// Right Arm
-
-12,	// Left Leg Up 
-8,	// Right Shoulder
-5,		// Left Arm
-
-15,	// Right Up Leg 
-4,		// Left Shoulder
-10,	// Right Wrist
-
-
-12,	// Left Leg Up 
-8,	// Right Shoulder
-6,	// Left Wrist
-
-15,	// Right Up Leg 
-5,		// Left Arm
-10,	// Right Wrist
-
-12,	// Left Leg Up 
-9,	// Right Arm
-6,	// Left Wrist
-
-15,	// Right Up Leg 
-13,	// Left Leg
-10,	// Right Wrist
-
-12,	// Left Leg Up 
-16,	// Right Leg
-6,	// Left Wrist
-
-15,	// Right Up Leg 
-14,	// Left Foot
-16,	// Right Leg
-
-12,	// Left Leg Up 
-17,	// Right Root
-13,	// Left Leg
-
-16,	// Right Leg
-4,	// Left Shoulder
-9,	// Right Arm
-
-13,	// Left Leg
-8,	// Right Shoulder
-5	// Left Arm
-	};
-
-
-	TriangleIndexBoneNames =
 	{
-		// Center Symmetrical	
-		BoneNames[1],	// Head 
-		BoneNames[12],	// Left Up Leg
-		BoneNames[15],	// Right Up Leg
-
-		BoneNames[1],	// Head
-		BoneNames[14],	// Left Top Base
-		BoneNames[17],	// Right Toe Base
-
-		BoneNames[3],	// Spine 1
-		BoneNames[4],	// Left Shoulder
-		BoneNames[8],	// Right Shoulder
-
-		BoneNames[3],	// Spine 1
-		BoneNames[7],	// Left Hand
-		BoneNames[11],	// Right Hand
-
-		BoneNames[3],	// Spine 1
-		BoneNames[12],	// Left Up Leg
-		BoneNames[15],	// Right Up Leg
-
-		// Right Side Head
-		BoneNames[1],		// Head
-		BoneNames[8],	// Right Shoulder 
-		BoneNames[2],		// Neck
-
-		BoneNames[1],		// Head
-		BoneNames[8],	// Right Shoulder
-		BoneNames[3],		// Spine 1
-
-		BoneNames[1],		// Head
-		BoneNames[9],	// Right Arm
-		BoneNames[10],	// Right Wrist 
-
-		BoneNames[1],		// Head
-		BoneNames[9],	// Right Arm 
-		BoneNames[17],	// Right Foot 
-
-
-		//Right Side Chest
-		BoneNames[3],		// Spine 1
-		BoneNames[8],	// Right Shoulder 
-		BoneNames[1],		// Neck
-
-		BoneNames[3],		// Spine 1 
-		BoneNames[8],	// Right Shoulder 
-		BoneNames[10],	// Right Wrist
-
-		BoneNames[3],		// Spine 1 
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[17],	// Right Foot
-
-		BoneNames[3],		// Spine 1 
-		BoneNames[9],	// Right Arm
-		BoneNames[10],	// Right Hand 
-
-		// Right Side Hip
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[8],	// Right Shoulder 
-		BoneNames[12],	// Left Up Leg 
-
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[8],	// Right Shoulder 
-		BoneNames[9],	// Right Arm 
-
-		BoneNames[15],	// Right Up Leg
-		BoneNames[8],	// Right Shoulder 
-		BoneNames[10],	// Right Wrist
-
-		BoneNames[15],	// Right Up Leg
-		BoneNames[1],		// Neck
-		BoneNames[8],	// Right Shoulder
-
-		BoneNames[15],	// Right Up Leg
-		BoneNames[9],	// Right Arm
-		BoneNames[10],	// Right Wrist
-
-		BoneNames[15],	// Right Up Leg
-		BoneNames[16],	// Right Leg 
-		BoneNames[13],	// Left Knee
-
-		BoneNames[15],	// Right Up Leg
-		BoneNames[16],	// Right Leg 
-		BoneNames[17],	// Right Foot
-
-		// Right Side Knee
-		BoneNames[16],	// Right Leg 
-		BoneNames[7],	// Right Shoulder
-		BoneNames[9],	// Right Elbow
-
-		BoneNames[16],	// Right Leg 
-		BoneNames[8],	// Right Shoulder
-		BoneNames[13],	// Left Leg
-
-		BoneNames[16],	// Right Leg 
-		BoneNames[15],	// Right Hip 
-		BoneNames[12],	// Left Hip 
-
-		BoneNames[16],	// Right Leg 
-		BoneNames[17],	// Right Foot
-		BoneNames[14],	// Left Foot
-
-		// Right Side Ankle
-		BoneNames[17],	// Right Foot 
-		BoneNames[8],	// Right Shoulder
-		BoneNames[4],		// Left Shoulder
-
-		BoneNames[17],	// Right Foot 
-		BoneNames[16],	// Right Leg
-		BoneNames[13],	// Left Leg
-
-
-		// Left Side Head
-		BoneNames[1],		// Head
-		BoneNames[4],		// Left Shoulder
-		BoneNames[1],		// Neck
-
-		BoneNames[1],		// Head
-		BoneNames[4],		// Left Shoulder
-		BoneNames[3],		// Spine 1
-
-		BoneNames[1],		// Head
-		BoneNames[5],		// Left Arm
-		BoneNames[6],	// Left  Wrist
-
-		BoneNames[1],		// Head
-		BoneNames[5],		// Left Arm
-		BoneNames[14],	// Left Foot
-
-
-		//Left Side Chest
-		BoneNames[3],		// Spine 1
-		BoneNames[4],		// Left Shoulder
-		BoneNames[5],		// Left Arm
-
-		BoneNames[3],		// Spine 1
-		BoneNames[4],		// Left Shoulder
-		BoneNames[6],		// Left Wrist
-
-		BoneNames[3],		// Spine 1
-		BoneNames[12],	// Left Leg Up
-		BoneNames[14],	// Left Foot
-
-		BoneNames[3],		// Spine 1
-		BoneNames[5],		// Left Arm
-		BoneNames[6],	// Left Hand
-
-		// Left Side Hip
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[4],		// Left Shoulder
-		BoneNames[15],	// Right Leg Up
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[4],		// Left Shoulder
-		BoneNames[5],		// Left Arm
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[4],		// Left Shoulder
-		BoneNames[6],	// Left Wrist
-
-		BoneNames[12],	// Left Leg Up  
-		BoneNames[2],		// Neck
-		BoneNames[4],		// Left Shoulder
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[5],		// Left Arm
-		BoneNames[6],	// Left Wrist
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[13],	// Left Leg
-		BoneNames[14],	// Right Leg
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[12],	// Left Leg
-		BoneNames[13],	// Left Foot 
-
-		// Left Side Leg
-		BoneNames[13],	// Left Leg
-		BoneNames[4],		// Left Shoulder
-		BoneNames[5],		// Left Arm
-
-		BoneNames[13],	// Left Leg
-		BoneNames[4],		// Left Shoulder 
-		BoneNames[16],	// Right Leg
-
-		BoneNames[13],	// Left Leg
-		BoneNames[12],	// Left Leg Up
-		BoneNames[15],	// Right Leg Up
-
-		BoneNames[13],	// Left Leg
-		BoneNames[14],	// Left Foot 
-		BoneNames[17],	// Right Foot
-
-		// Left Side Ankle
-		BoneNames[14],	// Left Foot
-		BoneNames[4],		// Left Shoulder
-		BoneNames[8],	// Right Shoulder
-
-		BoneNames[14],	// Left Foot
-		BoneNames[13],	// Left Leg
-		BoneNames[16],	// Right Leg
-
-		// Cross Center
-		BoneNames[1],		// Head
-		BoneNames[9],	// Right Elbow
-		BoneNames[14],	// Left Foot
-
-		BoneNames[1],		// Head
-		BoneNames[5],		// Left Elbow
-		BoneNames[17],	// Right Foot
-
-		BoneNames[1],		// Head
-		BoneNames[9],	// Right Elbow
-		BoneNames[6],	// Left Wrist
-
-		BoneNames[1],		// Head
-		BoneNames[5],		// Left Elbow
-		BoneNames[10],	// Right WRist
-
-		BoneNames[3],		// Spine 1
-		BoneNames[15],	// Right Hip
-		BoneNames[6],	// Left Wrist
-
-		BoneNames[3],		// Spine 1
-		BoneNames[12],	// Left Hip
-		BoneNames[10],	// Right Wrist
-
-		BoneNames[3],		// Spine 1
-		BoneNames[8],	// Right Shoulder
-		BoneNames[6],	// Left Wrist
-
-		BoneNames[3],		// Spine 1
-		BoneNames[4],		// Left Shoulder
-		BoneNames[10],	// Right Wrist
-
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[4],		// Left Shoulder
-		BoneNames[9],	// Right Arm
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[8],	// Right Shoulder
-		BoneNames[5],		// Left Arm
-
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[4],		// Left Shoulder
-		BoneNames[10],	// Right Wrist
-
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[8],	// Right Shoulder
-		BoneNames[6],	// Left Wrist
-
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[5],		// Left Arm
-		BoneNames[10],	// Right Wrist
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[9],	// Right Arm
-		BoneNames[6],	// Left Wrist
-
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[13],	// Left Leg
-		BoneNames[10],	// Right Wrist
-
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[16],	// Right Leg
-		BoneNames[6],	// Left Wrist
+		FScopeLock Lock(&PendingFrameLock);
+		if (!bHasPendingFrame) {
+			return;
+		}
+		Frame.Skeleton = PendingSkeleton;
+		Frame.bParallelTriangles = PendingQuality.bParallelTriangles;
+		Frame.TriangleGrainSize = FMath::Max(1, PendingQuality.TriangleGrainSize);
+		bPipelinedStages = PendingQuality.bPipelinedStages;
+		Frame.TrackedTriangleCount = PendingQuality.TrackedTriangleCount;
+		Frame.bUpdateDebugGeometry = PendingQuality.bUpdateDebugGeometry;
+		Frame.bVectorizedTau = PendingQuality.bVectorizedTau;
+		Frame.TauMathMode = PendingTauMathMode;
+		Frame.TauRecording = PendingTauRecording;
+		bHasPendingFrame = false;
+
+		LastWakeLatency = FPlatformTime::Seconds() - PendingFramePostTime;
+		TotalWakeLatency += LastWakeLatency;
+		WokenFrameCount++;
+	}
+	NextFrameIndex = (NextFrameIndex + 1) % PipelineDepth;
 
-		BoneNames[15],	// Right Up Leg 
-		BoneNames[14],	// Left Foot
-		BoneNames[16],	// Right Leg
+	if (!Frame.Skeleton.bHasJoints) {
+		return;
+	}
 
-		BoneNames[12],	// Left Leg Up 
-		BoneNames[17],	// Right Root
-		BoneNames[13],	// Left Leg
+	if (bPipelinedStages) {
+		DispatchPipelinedFrame(Frame);
+	}
+	else if (bUseSharedWorkerPool && LastTauEvent.IsValid() && !LastTauEvent->IsComplete()) {
+		// Chain behind the pipelined frame still in flight rather than blocking a pool thread on it
+		FGraphEventArray Prerequisites;
+		Prerequisites.Add(LastTauEvent);
+		LastTauEvent = DispatchTask(&FJointBufferThread::RunSerialFrame, &Frame, &Prerequisites);
+		Frame.CompletionEvent = LastTauEvent;
+	}
+	else {
+		// Keep the serial path ordered behind any frame still in the pipeline
+		if (LastTauEvent.IsValid()) {
+			FTaskGraphInterface::Get().WaitUntilTaskCompletes(LastTauEvent);
+			LastTauEvent = nullptr;
+		}
+		ProcessSocketRawData(Frame);
+		PublishFrameResult(Frame);
+	}
+}
 
-		BoneNames[16],	// Right Leg
-		BoneNames[4],	// Left Shoulder
-		BoneNames[9],	// Right Arm
+void FJointBufferThread::DispatchPoolFrame(FGraphEventRef WaitFor)
+{
+	// At most one dispatch task is queued per user. It is chained behind the previous one,
+	// so a user's frames stay in order while different users spread over the task graph workers.
+	FScopeLock Lock(&PendingFrameLock);
+	if (bPoolDispatchQueued) {
+		return;
+	}
+	bPoolDispatchQueued = true;
 
-		BoneNames[13],	// Left Leg
-		BoneNames[8],	// Right Shoulder
-		BoneNames[5]	// Left Arm
-	};
+	FGraphEventArray Prerequisites;
+	if (LastPoolDispatchEvent.IsValid()) {
+		Prerequisites.Add(LastPoolDispatchEvent);
+	}
+	if (WaitFor.IsValid()) {
+		Prerequisites.Add(WaitFor);
+	}
+	LastPoolDispatchEvent = DispatchTask(&FJointBufferThread::RunPoolDispatch, nullptr, &Prerequisites);
+}
 
+FGraphEventRef FJointBufferThread::DispatchTask(FTaskFunction Function, FJointBufferFrame* Frame, const FGraphEventArray* Prerequisites)
+{
+	return TGraphTask<FJointBufferTask>::CreateTask(Prerequisites).ConstructAndDispatchWhenReady(this, Function, Frame);
+}
 
-	TrianglePositions =
+void FJointBufferThread::RunPoolDispatch(FJointBufferFrame* Frame)
+{
 	{
-		// Center Symmetrical	
-		Locations[1],	// Head 
-		Locations[12],	// Left Up Leg
-		Locations[15],	// Right Up Leg
-
-		Locations[1],	// Head
-		Locations[14],	// Left Top Base
-		Locations[17],	// Right Toe Base
-
-		Locations[3],	// Spine 1
-		Locations[4],	// Left Shoulder
-		Locations[8],	// Right Shoulder
-
-		Locations[3],	// Spine 1
-		Locations[7],	// Left Hand
-		Locations[11],	// Right Hand
-
-		Locations[3],	// Spine 1
-		Locations[12],	// Left Up Leg
-		Locations[15],	// Right Up Leg
-
-		// Right Side Head
-		Locations[1],		// Head
-		Locations[8],	// Right Shoulder 
-		Locations[2],		// Neck
-
-		Locations[1],		// Head
-		Locations[8],	// Right Shoulder
-		Locations[3],		// Spine 1
-
-		Locations[1],		// Head
-		Locations[9],	// Right Arm
-		Locations[10],	// Right Wrist 
-
-		Locations[1],		// Head
-		Locations[9],	// Right Arm 
-		Locations[17],	// Right Foot 
-
-
-		//Right Side Chest
-		Locations[3],		// Spine 1
-		Locations[8],	// Right Shoulder 
-		Locations[1],		// Neck
-
-		Locations[3],		// Spine 1 
-		Locations[8],	// Right Shoulder 
-		Locations[10],	// Right Wrist
-
-		Locations[3],		// Spine 1 
-		Locations[15],	// Right Up Leg 
-		Locations[17],	// Right Foot
-
-		Locations[3],		// Spine 1 
-		Locations[9],	// Right Arm
-		Locations[10],	// Right Hand 
-
-		// Right Side Hip
-		Locations[15],	// Right Up Leg 
-		Locations[8],	// Right Shoulder 
-		Locations[12],	// Left Up Leg 
-
-		Locations[15],	// Right Up Leg 
-		Locations[8],	// Right Shoulder 
-		Locations[9],	// Right Arm 
-
-		Locations[15],	// Right Up Leg
-		Locations[8],	// Right Shoulder 
-		Locations[10],	// Right Wrist
-
-		Locations[15],	// Right Up Leg
-		Locations[1],		// Neck
-		Locations[8],	// Right Shoulder
-
-		Locations[15],	// Right Up Leg
-		Locations[9],	// Right Arm
-		Locations[10],	// Right Wrist
-
-		Locations[15],	// Right Up Leg
-		Locations[16],	// Right Leg 
-		Locations[13],	// Left Knee
-
-		Locations[15],	// Right Up Leg
-		Locations[16],	// Right Leg 
-		Locations[17],	// Right Foot
-
-		// Right Side Knee
-		Locations[16],	// Right Leg 
-		Locations[7],	// Right Shoulder
-		Locations[9],	// Right Elbow
-
-		Locations[16],	// Right Leg 
-		Locations[8],	// Right Shoulder
-		Locations[13],	// Left Leg
-
-		Locations[16],	// Right Leg 
-		Locations[15],	// Right Hip 
-		Locations[12],	// Left Hip 
-
-		Locations[16],	// Right Leg 
-		Locations[17],	// Right Foot
-		Locations[14],	// Left Foot
-
-		// Right Side Ankle
-		Locations[17],	// Right Foot 
-		Locations[8],	// Right Shoulder
-		Locations[4],		// Left Shoulder
-
-		Locations[17],	// Right Foot 
-		Locations[16],	// Right Leg
-		Locations[13],	// Left Leg
-
-
-		// Left Side Head
-		Locations[1],		// Head
-		Locations[4],		// Left Shoulder
-		Locations[2],		// Neck
-
-		Locations[1],		// Head
-		Locations[4],		// Left Shoulder
-		Locations[3],		// Spine 1
-
-		Locations[1],		// Head
-		Locations[5],		// Left Arm
-		Locations[6],	// Left  Wrist
-
-		Locations[1],		// Head
-		Locations[5],		// Left Arm
-		Locations[14],	// Left Foot
-
-
-		//Left Side Chest
-		Locations[3],		// Spine 1
-		Locations[4],		// Left Shoulder
-		Locations[5],		// Left Arm
-
-		Locations[3],		// Spine 1
-		Locations[4],		// Left Shoulder
-		Locations[6],		// Left Wrist
-
-		Locations[3],		// Spine 1
-		Locations[12],	// Left Leg Up
-		Locations[14],	// Left Foot
-
-		Locations[3],		// Spine 1
-		Locations[5],		// Left Arm
-		Locations[6],	// Left Hand
-
-		// Left Side Hip
-		Locations[12],	// Left Leg Up 
-		Locations[4],		// Left Shoulder
-		Locations[15],	// Right Leg Up
-
-		Locations[12],	// Left Leg Up 
-		Locations[4],		// Left Shoulder
-		Locations[5],		// Left Arm
-
-		Locations[12],	// Left Leg Up 
-		Locations[4],		// Left Shoulder
-		Locations[6],	// Left Wrist
-
-		Locations[12],	// Left Leg Up  
-		Locations[2],		// Neck
-		Locations[4],		// Left Shoulder
-
-		Locations[12],	// Left Leg Up 
-		Locations[5],		// Left Arm
-		Locations[6],	// Left Wrist
-
-		Locations[12],	// Left Leg Up 
-		Locations[13],	// Left Leg
-		Locations[14],	// Right Leg
-
-		Locations[12],	// Left Leg Up 
-		Locations[12],	// Left Leg
-		Locations[13],	// Left Foot 
-
-		// Left Side Leg
-		Locations[13],	// Left Leg
-		Locations[4],		// Left Shoulder
-		Locations[5],		// Left Arm
-
-		Locations[13],	// Left Leg
-		Locations[4],		// Left Shoulder 
-		Locations[16],	// Right Leg
-
-		Locations[13],	// Left Leg
-		Locations[12],	// Left Leg Up
-		Locations[15],	// Right Leg Up
-
-		Locations[13],	// Left Leg
-		Locations[14],	// Left Foot 
-		Locations[17],	// Right Foot
-
-		// Left Side Ankle
-		Locations[14],	// Left Foot
-		Locations[4],		// Left Shoulder
-		Locations[8],	// Right Shoulder
-
-		Locations[14],	// Left Foot
-		Locations[13],	// Left Leg
-		Locations[16],	// Right Leg
-
-		// Cross Center
-		Locations[1],		// Head
-		Locations[9],	// Right Elbow
-		Locations[14],	// Left Foot
-
-		Locations[1],		// Head
-		Locations[5],		// Left Elbow
-		Locations[17],	// Right Foot
-
-		Locations[1],		// Head
-		Locations[9],	// Right Elbow
-		Locations[6],	// Left Wrist
-
-		Locations[1],		// Head
-		Locations[5],		// Left Elbow
-		Locations[10],	// Right WRist
-
-		Locations[3],		// Spine 1
-		Locations[15],	// Right Hip
-		Locations[6],	// Left Wrist
-
-		Locations[3],		// Spine 1
-		Locations[12],	// Left Hip
-		Locations[10],	// Right Wrist
-
-		Locations[3],		// Spine 1
-		Locations[8],	// Right Shoulder
-		Locations[6],	// Left Wrist
-
-		Locations[3],		// Spine 1
-		Locations[4],		// Left Shoulder
-		Locations[10],	// Right Wrist
-
-		Locations[15],	// Right Up Leg 
-		Locations[4],		// Left Shoulder
-		Locations[9],	// Right Arm
-
-		Locations[12],	// Left Leg Up 
-		Locations[8],	// Right Shoulder
-		Locations[5],		// Left Arm
-
-		Locations[15],	// Right Up Leg 
-		Locations[4],		// Left Shoulder
-		Locations[10],	// Right Wrist
-
-
-		Locations[12],	// Left Leg Up 
-		Locations[8],	// Right Shoulder
-		Locations[6],	// Left Wrist
+		FScopeLock Lock(&PendingFrameLock);
+		bPoolDispatchQueued = false;
+	}
+	if (!bStopThread) {
+		RunPendingFrame();
+	}
+}
 
-		Locations[15],	// Right Up Leg 
-		Locations[5],		// Left Arm
-		Locations[10],	// Right Wrist
+void FJointBufferThread::RunGeometryStage(FJointBufferFrame* Frame)
+{
+	uint32 GeometryStart = FPlatformTime::Cycles();
+	UpdateEulerLines(*Frame);
+	UpdateDebugLines(*Frame);
+	AddStageTime(EJointBufferStage::Geometry, GeometryStart);
+}
 
-		Locations[12],	// Left Leg Up 
-		Locations[9],	// Right Arm
-		Locations[6],	// Left Wrist
+void FJointBufferThread::RunTauStage(FJointBufferFrame* Frame)
+{
+	uint32 TauStart = FPlatformTime::Cycles();
+	UpdateTracking(*Frame);
+	PublishFrameResult(*Frame);
+	AddStageTime(EJointBufferStage::Tau, TauStart);
+	FramesInFlight.Decrement();
+}
 
-		Locations[15],	// Right Up Leg 
-		Locations[13],	// Left Leg
-		Locations[10],	// Right Wrist
+void FJointBufferThread::RunSerialFrame(FJointBufferFrame* Frame)
+{
+	ProcessSocketRawData(*Frame);
+	PublishFrameResult(*Frame);
+}
 
-		Locations[12],	// Left Leg Up 
-		Locations[16],	// Right Leg
-		Locations[6],	// Left Wrist
+void FJointBufferThread::WaitForOutstandingTasks()
+{
+	// A dispatch task that was already running can requeue itself, so wait until no newer one appears
+	for (;;) {
+		FGraphEventRef DispatchEvent;
+		{
+			FScopeLock Lock(&PendingFrameLock);
+			DispatchEvent = LastPoolDispatchEvent;
+			LastPoolDispatchEvent = nullptr;
+		}
+		if (!DispatchEvent.IsValid()) {
+			break;
+		}
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(DispatchEvent);
+	}
+	if (LastTauEvent.IsValid()) {
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(LastTauEvent);
+		LastTauEvent = nullptr;
+	}
+	// Range helpers that started after their range was done still hold its slot
+	for (FTriangleRangeJob& Slot : RangeJobs) {
+		while (FPlatformAtomics::AtomicRead(&Slot.References) > 0) {
+			FPlatformProcess::YieldThread();
+		}
+	}
+}
 
-		Locations[15],	// Right Up Leg 
-		Locations[14],	// Left Foot
-		Locations[16],	// Right Leg
+void FJointBufferThread::PublishFrameResult(FJointBufferFrame& Frame)
+{
+	LastComputeSeconds = FPlatformTime::ToSeconds(FPlatformTime::Cycles() - Frame.StartCycles);
+
+	// Fill the handoff's write slot in place; its arrays keep their allocations between frames
+	FTauFrameResult& Result = JointBuffer->FrameResults.GetWriteBuffer();
+	Result.Sequence = ++PublishedSequence;
+	Result.ComputeSeconds = LastComputeSeconds;
+	Result.RobustCircumcenters = Frame.RobustCircumcenters;
+	Result.ExactPredicates = Frame.ExactPredicates;
+	Result.DegenerateTriangles = Frame.DegenerateTriangles;
+	Result.TriangleIndexes = Frame.TriangleIndexes;
+	Result.TrianglePositions = Frame.TrianglePositions;
+	Result.Skeleton = Frame.Skeleton;
+
+	// The snapshot keeps FVector arrays for Blueprint, so the SoA columns are gathered here
+	const FTriangleGeometryStore& Geometry = Frame.Geometry;
+	Result.TriangleCentroids.SetNumUninitialized(Geometry.Num(), false);
+	Result.TriangleCircumcenters.SetNumUninitialized(Geometry.Num(), false);
+	Result.EulerLines.SetNumUninitialized(Geometry.Num(), false);
+	Result.TriangleDegenerate.SetNumUninitialized(Geometry.Num(), false);
+	for (int32 i = 0; i < Geometry.Num(); i++) {
+		Result.TriangleCentroids[i] = Geometry.Centroids.Get(i);
+		Result.TriangleCircumcenters[i] = Geometry.Circumcenters.Get(i);
+		Result.EulerLines[i] = Geometry.EulerLines.Get(i);
+		Result.TriangleDegenerate[i] = Geometry.Degenerate[i] != 0;
+	}
 
-		Locations[12],	// Left Leg Up 
-		Locations[17],	// Right Root
-		Locations[13],	// Left Leg
+	Result.AngleTauSamples.Reset();
+	Result.AngleTauDotSamples.Reset();
+	Result.PositionTauSamples.Reset();
+	Result.PositionTauDotSamples.Reset();
+	const int32 StateCount = TauStates ? TauStates->TriangleCount : 0;
+	Result.TriangleNonFiniteCounts.SetNumUninitialized(StateCount, false);
+	int32 NonFiniteSamples = 0;
+	for (int32 i = 0; i < StateCount; i++) {
+		const UTauBuffer* Buffer = &TauStates->States[i];
+		Result.TriangleNonFiniteCounts[i] = Buffer->NonFiniteSamples;
+		NonFiniteSamples += Buffer->NonFiniteSamples;
+		if (Buffer->IncrementalAngleTauSamples.Num() > 0) {
+			Result.AngleTauSamples.Add(Buffer->IncrementalAngleTauSamples.Last());
+		}
+		if (Buffer->IncrementalAngleTauDotSamples.Num() > 0) {
+			Result.AngleTauDotSamples.Add(Buffer->IncrementalAngleTauDotSamples.Last());
+		}
+		if (Buffer->IncrementalPositionTauSamples.Num() > 0) {
+			Result.PositionTauSamples.Add(Buffer->IncrementalPositionTauSamples.Last());
+		}
+		if (Buffer->IncrementalPositionTauDotSamples.Num() > 0) {
+			Result.PositionTauDotSamples.Add(Buffer->IncrementalPositionTauDotSamples.Last());
+		}
+	}
 
-		Locations[16],	// Right Leg
-		Locations[4],	// Left Shoulder
-		Locations[9],	// Right Arm
+	// The per-state counts are totals, so the stat only gets what was added since the previous frame
+	INC_DWORD_STAT_BY(STAT_TauNonFiniteSamples, FMath::Max(NonFiniteSamples - PublishedNonFiniteSamples, 0));
+	PublishedNonFiniteSamples = NonFiniteSamples;
+	Result.NonFiniteSamples = NonFiniteSamples;
 
-		Locations[13],	// Left Leg
-		Locations[8],	// Right Shoulder
-		Locations[5]	// Left Arm
-	};
+	JointBuffer->FrameResults.Publish();
+}
 
-	TriangleRotations =
+void FJointBufferThread::PostFrame(const FSkeletonFrame& Skeleton)
+{
+	FTauAllocationAuditRegion AuditRegion;
 	{
-		// Center Symmetrical	
-		Rotations[1],	// Head 
-		Rotations[12],	// Left Up Leg
-		Rotations[15],	// Right Up Leg
-
-		Rotations[1],	// Head
-		Rotations[14],	// Left Top Base
-		Rotations[17],	// Right Toe Base
-
-		Rotations[3],	// Spine 1
-		Rotations[4],	// Left Shoulder
-		Rotations[8],	// Right Shoulder
-
-		Rotations[3],	// Spine 1
-		Rotations[7],	// Left Hand
-		Rotations[11],	// Right Hand
-
-		Rotations[3],	// Spine 1
-		Rotations[12],	// Left Up Leg
-		Rotations[15],	// Right Up Leg
-
-		// Right Side Head
-		Rotations[1],		// Head
-		Rotations[8],	// Right Shoulder 
-		Rotations[2],		// Neck
-
-		Rotations[1],		// Head
-		Rotations[8],	// Right Shoulder
-		Rotations[3],		// Spine 1
-
-		Rotations[1],		// Head
-		Rotations[9],	// Right Arm
-		Rotations[10],	// Right Wrist 
-
-		Rotations[1],		// Head
-		Rotations[9],	// Right Arm 
-		Rotations[17],	// Right Foot 
-
-
-		//Right Side Chest
-		Rotations[3],		// Spine 1
-		Rotations[8],	// Right Shoulder 
-		Rotations[1],		// Neck
-
-		Rotations[3],		// Spine 1 
-		Rotations[8],	// Right Shoulder 
-		Rotations[10],	// Right Wrist
-
-		Rotations[3],		// Spine 1 
-		Rotations[15],	// Right Up Leg 
-		Rotations[17],	// Right Foot
-
-		Rotations[3],		// Spine 1 
-		Rotations[9],	// Right Arm
-		Rotations[10],	// Right Hand 
-
-		// Right Side Hip
-		Rotations[15],	// Right Up Leg 
-		Rotations[8],	// Right Shoulder 
-		Rotations[12],	// Left Up Leg 
-
-		Rotations[15],	// Right Up Leg 
-		Rotations[8],	// Right Shoulder 
-		Rotations[9],	// Right Arm 
-
-		Rotations[15],	// Right Up Leg
-		Rotations[8],	// Right Shoulder 
-		Rotations[10],	// Right Wrist
-
-		Rotations[15],	// Right Up Leg
-		Rotations[1],		// Neck
-		Rotations[8],	// Right Shoulder
-
-		Rotations[15],	// Right Up Leg
-		Rotations[9],	// Right Arm
-		Rotations[10],	// Right Wrist
-
-		Rotations[15],	// Right Up Leg
-		Rotations[16],	// Right Leg 
-		Rotations[13],	// Left Knee
-
-		Rotations[15],	// Right Up Leg
-		Rotations[16],	// Right Leg 
-		Rotations[17],	// Right Foot
-
-		// Right Side Knee
-		Rotations[16],	// Right Leg 
-		Rotations[7],	// Right Shoulder
-		Rotations[9],	// Right Elbow
-
-		Rotations[16],	// Right Leg 
-		Rotations[8],	// Right Shoulder
-		Rotations[13],	// Left Leg
-
-		Rotations[16],	// Right Leg 
-		Rotations[15],	// Right Hip 
-		Rotations[12],	// Left Hip 
-
-		Rotations[16],	// Right Leg 
-		Rotations[17],	// Right Foot
-		Rotations[14],	// Left Foot
-
-		// Right Side Ankle
-		Rotations[17],	// Right Foot 
-		Rotations[8],	// Right Shoulder
-		Rotations[4],		// Left Shoulder
-
-		Rotations[17],	// Right Foot 
-		Rotations[16],	// Right Leg
-		Rotations[13],	// Left Leg
-
-
-		// Left Side Head
-		Rotations[1],		// Head
-		Rotations[4],		// Left Shoulder
-		Rotations[2],		// Neck
-
-		Rotations[1],		// Head
-		Rotations[4],		// Left Shoulder
-		Rotations[3],		// Spine 1
-
-		Rotations[1],		// Head
-		Rotations[5],		// Left Arm
-		Rotations[6],	// Left  Wrist
-
-		Rotations[1],		// Head
-		Rotations[5],		// Left Arm
-		Rotations[14],	// Left Foot
-
-
-		//Left Side Chest
-		Rotations[3],		// Spine 1
-		Rotations[4],		// Left Shoulder
-		Rotations[5],		// Left Arm
-
-		Rotations[3],		// Spine 1
-		Rotations[4],		// Left Shoulder
-		Rotations[6],		// Left Wrist
-
-		Rotations[3],		// Spine 1
-		Rotations[12],	// Left Leg Up
-		Rotations[14],	// Left Foot
-
-		Rotations[3],		// Spine 1
-		Rotations[5],		// Left Arm
-		Rotations[6],	// Left Hand
-
-		// Left Side Hip
-		Rotations[12],	// Left Leg Up 
-		Rotations[4],		// Left Shoulder
-		Rotations[15],	// Right Leg Up
-
-		Rotations[12],	// Left Leg Up 
-		Rotations[4],		// Left Shoulder
-		Rotations[5],		// Left Arm
-
-		Rotations[12],	// Left Leg Up 
-		Rotations[4],		// Left Shoulder
-		Rotations[6],	// Left Wrist
-
-		Rotations[12],	// Left Leg Up  
-		Rotations[2],		// Neck
-		Rotations[4],		// Left Shoulder
-
-		Rotations[12],	// Left Leg Up 
-		Rotations[5],		// Left Arm
-		Rotations[6],	// Left Wrist
-
-		Rotations[12],	// Left Leg Up 
-		Rotations[13],	// Left Leg
-		Rotations[14],	// Right Leg
-
-		Rotations[12],	// Left Leg Up 
-		Rotations[12],	// Left Leg
-		Rotations[13],	// Left Foot 
-
-		// Left Side Leg
-		Rotations[13],	// Left Leg
-		Rotations[4],		// Left Shoulder
-		Rotations[5],		// Left Arm
-
-		Rotations[13],	// Left Leg
-		Rotations[4],		// Left Shoulder 
-		Rotations[16],	// Right Leg
-
-		Rotations[13],	// Left Leg
-		Rotations[12],	// Left Leg Up
-		Rotations[15],	// Right Leg Up
-
-		Rotations[13],	// Left Leg
-		Rotations[14],	// Left Foot 
-		Rotations[17],	// Right Foot
+		FScopeLock Lock(&PendingFrameLock);
+		PendingSkeleton = Skeleton;
+		PendingFramePostTime = FPlatformTime::Seconds();
+		bHasPendingFrame = true;
+	}
 
-		// Left Side Ankle
-		Rotations[14],	// Left Foot
-		Rotations[4],		// Left Shoulder
-		Rotations[8],	// Right Shoulder
+	if (bUseSharedWorkerPool) {
+		DispatchPoolFrame();
+	}
+	else {
+		WorkEvent->Trigger();
+	}
+}
 
-		Rotations[14],	// Left Foot
-		Rotations[13],	// Left Leg
-		Rotations[16],	// Right Leg
+void FJointBufferThread::SetQualitySettings(const FJointBufferQualitySettings& Settings)
+{
+	FScopeLock Lock(&PendingFrameLock);
+	PendingQuality = Settings;
+}
 
-		// Cross Center
-		Rotations[1],		// Head
-		Rotations[9],	// Right Elbow
-		Rotations[14],	// Left Foot
+void FJointBufferThread::SetTauMathSettings(ETauMathMode MathMode, const TSharedPtr<FTauMotionRecording, ESPMode::ThreadSafe>& Recording)
+{
+	FScopeLock Lock(&PendingFrameLock);
+	PendingTauMathMode = MathMode;
+	if (Recording.IsValid() && !Recording->IsComplete()) {
+		PendingTauRecording = Recording;
+	}
+	else {
+		PendingTauRecording.Reset();
+	}
+}
 
-		Rotations[1],		// Head
-		Rotations[5],		// Left Elbow
-		Rotations[17],	// Right Foot
+void FJointBufferThread::GetWakeLatencyStats(double& OutLastLatency, double& OutAverageLatency, int32& OutFrameCount)
+{
+	FScopeLock Lock(&PendingFrameLock);
+	OutLastLatency = LastWakeLatency;
+	OutAverageLatency = WokenFrameCount > 0 ? TotalWakeLatency / WokenFrameCount : 0;
+	OutFrameCount = WokenFrameCount;
+}
 
-		Rotations[1],		// Head
-		Rotations[9],	// Right Elbow
-		Rotations[6],	// Left Wrist
+void FJointBufferThread::GetStageOccupancy(float OutOccupancy[(int32)EJointBufferStage::Count], int32& OutFramesInFlight)
+{
+	double Elapsed = FPlatformTime::Seconds() - StartTime;
+	for (int32 Stage = 0; Stage < (int32)EJointBufferStage::Count; Stage++) {
+		int64 BusyCycles = FPlatformAtomics::AtomicRead(&StageBusyCycles[Stage]);
+		OutOccupancy[Stage] = Elapsed > 0 ? float(FPlatformTime::ToSeconds64(BusyCycles) / Elapsed) : 0.f;
+	}
+	OutFramesInFlight = FramesInFlight.GetValue();
+}
 
-		Rotations[1],		// Head
-		Rotations[5],		// Left Elbow
-		Rotations[10],	// Right WRist
+void FJointBufferThread::AddStageTime(EJointBufferStage Stage, uint32 StartCycles)
+{
+	FPlatformAtomics::InterlockedAdd(&StageBusyCycles[(int32)Stage], int64(FPlatformTime::Cycles() - StartCycles));
+}
 
-		Rotations[3],		// Spine 1
-		Rotations[15],	// Right Hip
-		Rotations[6],	// Left Wrist
+void FJointBufferThread::ProcessSocketRawData(FJointBufferFrame& Frame)
+{
+	Frame.StartCycles = FPlatformTime::Cycles();
+	UpdateTriangles(Frame);
+	AddStageTime(EJointBufferStage::Assembly, Frame.StartCycles);
+
+	uint32 GeometryStart = FPlatformTime::Cycles();
+	// Euler lines first: they classify degenerate triangles, which the debug lines then skip
+	UpdateEulerLines(Frame);
+	UpdateDebugLines(Frame);
+	AddStageTime(EJointBufferStage::Geometry, GeometryStart);
+
+	uint32 TauStart = FPlatformTime::Cycles();
+	UpdateTracking(Frame);
+	AddStageTime(EJointBufferStage::Tau, TauStart);
+}
 
-		Rotations[3],		// Spine 1
-		Rotations[12],	// Left Hip
-		Rotations[10],	// Right Wrist
+void FJointBufferThread::DispatchPipelinedFrame(FJointBufferFrame& Frame)
+{
+	FramesInFlight.Increment();
 
-		Rotations[3],		// Spine 1
-		Rotations[8],	// Right Shoulder
-		Rotations[6],	// Left Wrist
+	// Assembly only gathers joints into triangles, so it stays on the worker thread
+	Frame.StartCycles = FPlatformTime::Cycles();
+	UpdateTriangles(Frame);
+	AddStageTime(EJointBufferStage::Assembly, Frame.StartCycles);
 
-		Rotations[3],		// Spine 1
-		Rotations[4],		// Left Shoulder
-		Rotations[10],	// Right Wrist
+	FGraphEventRef GeometryEvent = DispatchTask(&FJointBufferThread::RunGeometryStage, &Frame, nullptr);
 
-		Rotations[15],	// Right Up Leg 
-		Rotations[4],		// Left Shoulder
-		Rotations[9],	// Right Arm
+	// The tau stage waits for this frame's geometry and for the previous frame's tau, so the tau
+	// buffers still see every frame in order while the next frame's geometry runs alongside
+	FGraphEventArray TauPrerequisites;
+	TauPrerequisites.Add(GeometryEvent);
+	if (LastTauEvent.IsValid()) {
+		TauPrerequisites.Add(LastTauEvent);
+	}
 
-		Rotations[12],	// Left Leg Up 
-		Rotations[8],	// Right Shoulder
-		Rotations[5],		// Left Arm
+	LastTauEvent = DispatchTask(&FJointBufferThread::RunTauStage, &Frame, &TauPrerequisites);
 
-		Rotations[15],	// Right Up Leg 
-		Rotations[4],		// Left Shoulder
-		Rotations[10],	// Right Wrist
+	Frame.CompletionEvent = LastTauEvent;
+}
 
+void FJointBufferThread::ForEachTriangle(const FJointBufferFrame& Frame, int32 TriangleCount, TFunctionRef<void(int32)> Body)
+{
+	ForEachTriangleRange(Frame, TriangleCount, [&Body](int32 Begin, int32 End) {
+		for (int32 i = Begin; i < End; i++) {
+			Body(i);
+		}
+	});
+}
 
-		Rotations[12],	// Left Leg Up 
-		Rotations[8],	// Right Shoulder
-		Rotations[6],	// Left Wrist
+void FJointBufferThread::ForEachTriangleRange(const FJointBufferFrame& Frame, int32 TriangleCount, TFunctionRef<void(int32, int32)> Body)
+{
+	// Flush denormals for the duration of each range only; pool threads go back to the engine's mode afterwards
+	if (!Frame.bParallelTriangles || TriangleCount <= Frame.TriangleGrainSize) {
+		FTauDenormalScope DenormalScope;
+		Body(0, TriangleCount);
+		return;
+	}
 
-		Rotations[15],	// Right Up Leg 
-		Rotations[5],		// Left Arm
-		Rotations[10],	// Right Wrist
+	// Every triangle is independent, so hand out chunks of GrainSize triangles to the task graph.
+	// ParallelFor would allocate its task data on every call, so the job lives in a preallocated slot.
+	int32 ChunkCount = FMath::DivideAndRoundUp(TriangleCount, Frame.TriangleGrainSize);
+	int32 HelperCount = FMath::Min(ChunkCount - 1, FTaskGraphInterface::Get().GetNumWorkerThreads());
 
-		Rotations[12],	// Left Leg Up 
-		Rotations[9],	// Right Arm
-		Rotations[6],	// Left Wrist
+	FTriangleRangeJob* Job = nullptr;
+	for (FTriangleRangeJob& Slot : RangeJobs) {
+		if (FPlatformAtomics::InterlockedCompareExchange(&Slot.References, HelperCount + 1, 0) == 0) {
+			Job = &Slot;
+			break;
+		}
+	}
+	if (Job == nullptr) {
+		// Every slot still has a late helper on it; rare enough to just run this range here
+		FTauDenormalScope DenormalScope;
+		Body(0, TriangleCount);
+		return;
+	}
 
-		Rotations[15],	// Right Up Leg 
-		Rotations[13],	// Left Leg
-		Rotations[10],	// Right Wrist
+	Job->Body = &Body;
+	Job->TriangleCount = TriangleCount;
+	Job->GrainSize = Frame.TriangleGrainSize;
+	Job->ChunkCount = ChunkCount;
+	Job->NextChunk = 0;
+	FPlatformMisc::MemoryBarrier();
+	for (int32 Helper = 0; Helper < HelperCount; Helper++) {
+		TGraphTask<FTriangleRangeHelperTask>::CreateTask().ConstructAndDispatchWhenReady(Job);
+	}
 
-		Rotations[12],	// Left Leg Up 
-		Rotations[16],	// Right Leg
-		Rotations[6],	// Left Wrist
+	// Take chunks here too, then wait only for helpers still inside Body
+	Job->RunChunks();
+	while (FPlatformAtomics::AtomicRead(&Job->ActiveHelpers) > 0) {
+		FPlatformProcess::YieldThread();
+	}
+	FPlatformAtomics::InterlockedDecrement(&Job->References);
+}
 
-		Rotations[15],	// Right Up Leg 
-		Rotations[14],	// Left Foot
-		Rotations[16],	// Right Leg
 
-		Rotations[12],	// Left Leg Up 
-		Rotations[17],	// Right Root
-		Rotations[13],	// Left Leg
+void FJointBufferThread::UpdateTriangles(FJointBufferFrame& Frame)
+{
+	const FSkeletonFrame& Skeleton = Frame.Skeleton;
 
-		Rotations[16],	// Right Leg
-		Rotations[4],	// Left Shoulder
-		Rotations[9],	// Right Arm
+	const FTauCompiledTopology& Triangles = *Topology;
+	if (Triangles.JointCount > FSkeletonFrame::JointCount) {
+		UE_LOG(LogTemp, Warning, TEXT("Not updating triangles, expected %i sockets but got %i"), Triangles.JointCount, FSkeletonFrame::JointCount);
+		return;
+	}
 
-		Rotations[13],	// Left Leg
-		Rotations[8],	// Right Shoulder
-		Rotations[5]	// Left Arm
+	// Gather the sockets through the topology table. The arrays keep their size after the first frame.
+	int32 IndexCount = Triangles.GetIndexCount();
+	Frame.TriangleIndexes.SetNumUninitialized(IndexCount, false);
+	Frame.TrianglePositions.SetNumUninitialized(IndexCount, false);
 
+	FTriangleGeometryStore& Geometry = Frame.Geometry;
+	Geometry.Resize(Triangles.TriangleCount);
 
-	};
+	for (int32 Triangle = 0; Triangle < Triangles.TriangleCount; Triangle++) {
+		for (int32 Corner = 0; Corner < 3; Corner++) {
+			int32 Index = Triangle * 3 + Corner;
+			int32 Joint = Triangles.TriangleJoints[Index];
+			Frame.TriangleIndexes[Index] = Joint;
+			Frame.TrianglePositions[Index] = Skeleton.Positions[Joint];
+		}
+		Geometry.A.Set(Triangle, Frame.TrianglePositions[Triangle * 3]);
+		Geometry.B.Set(Triangle, Frame.TrianglePositions[Triangle * 3 + 1]);
+		Geometry.C.Set(Triangle, Frame.TrianglePositions[Triangle * 3 + 2]);
+	}
 }
-void FJointBufferThread::UpdateDebugLines()
+
+void FJointBufferThread::UpdateDebugLines(FJointBufferFrame& Frame)
 {
+	// The debug vectors are not published, so the frame budget governor can switch them off
+	if (!Frame.bUpdateDebugGeometry) {
+		return;
+	}
 
 	// Update debug vector arrays
-	int TriangleCount = 0;
-	for (int i = 0; i < TrianglePositions.Num() / 3; i++) {
+	FTriangleGeometryStore& Geometry = Frame.Geometry;
+
+	ForEachTriangle(Frame, Geometry.Num(), [this, &Geometry](int32 i) {
 		/*
 		Directional vector is D1 normalized
 		T is the midpoint of the side of the triangle
@@ -1716,11 +1037,9 @@ void FJointBufferThread::UpdateDebugLines()
 		ABBCx.z = ABmid.z + D1.z * ( ( ( BCmid.y - ABmid.y ) * ( D2.x ) + ( D2.y * ABmid.x ) - ( D2.y * BCmid.x ) ) / ( D1.y * D2.x - D2.y * D1.x ) );
 		*/
 
-		int StartIndex = TrianglePositions.Num() - 201;
-
-		FVector A(TrianglePositions[StartIndex + TriangleCount * 3].X, TrianglePositions[StartIndex + TriangleCount * 3].Y, TrianglePositions[StartIndex + TriangleCount * 3].Z);
-		FVector B(TrianglePositions[StartIndex + TriangleCount * 3 + 1].X, TrianglePositions[StartIndex + TriangleCount * 3 + 1].Y, TrianglePositions[StartIndex + TriangleCount * 3 + 1].Z);
-		FVector C(TrianglePositions[StartIndex + TriangleCount * 3 + 2].X, TrianglePositions[StartIndex + TriangleCount * 3 + 2].Y, TrianglePositions[StartIndex + TriangleCount * 3 + 2].Z);
+		FVector A = Geometry.A.Get(i);
+		FVector B = Geometry.B.Get(i);
+		FVector C = Geometry.C.Get(i);
 
 		FVector _AB = A - B;
 		FVector _ABmid((A.X + B.X) / 2, (A.Y + B.Y) / 2, (A.Z + B.Z) / 2);
@@ -1746,211 +1065,172 @@ void FJointBufferThread::UpdateDebugLines()
 		_D2 = _D2 * 150;
 		_D3 = _D3 * 150;
 
-		AB.Emplace(_AB);
-		ABmid.Emplace(_ABmid);
-		BC.Emplace(_BC);
-		BCmid.Emplace(_BCmid);
-		CA.Emplace(_CA);
-		CAmid.Emplace(_CAmid);
-
-		V.Emplace(_V);
-		D1.Emplace(_D1);
-		D2.Emplace(_D2);
-		D3.Emplace(_D3);
-
-		float CircumcenterX = _ABmid.X + _D1.X * (((_BCmid.Y - _ABmid.Y) * (_D2.X) + (_D2.Y * _ABmid.X) - (_D2.Y * _BCmid.X)) / (_D1.Y * _D2.X - _D2.Y * _D1.X));
-		float CircumcenterY = _ABmid.Y + _D1.Y * (((_BCmid.Y - _ABmid.Y) * (_D2.X) + (_D2.Y * _ABmid.X) - (_D2.Y * _BCmid.X)) / (_D1.Y * _D2.X - _D2.Y * _D1.X));
-		float CircumcenterZ = _ABmid.Z + _D1.Z * (((_BCmid.Y - _ABmid.Y) * (_D2.X) + (_D2.Y * _ABmid.X) - (_D2.Y * _BCmid.X)) / (_D1.Y * _D2.X - _D2.Y * _D1.X));
-		FVector _ABBC = FVector(CircumcenterX, CircumcenterY, CircumcenterZ);
-		ABBC.Emplace(_ABBC);
-		TriangleCount++;
-	}
-
-	if (AB.Num() > TriangleCount) {
-		for (int i = 0; i < AB.Num() - TriangleCount; i++) {
-			AB.RemoveAt(i, 1, true);
-			ABmid.RemoveAt(i, 1, true);
-			BC.RemoveAt(i, 1, true);
-			BCmid.RemoveAt(i, 1, true);
-			CA.RemoveAt(i, 1, true);
-			CAmid.RemoveAt(i, 1, true);
-
-			V.RemoveAt(i, 1, true);
-			D1.RemoveAt(i, 1, true);
-			D2.RemoveAt(i, 1, true);
-			D3.RemoveAt(i, 1, true);
-			ABBC.RemoveAt(i, 1, true);
+		Geometry.AB.Set(i, _AB);
+		Geometry.ABmid.Set(i, _ABmid);
+		Geometry.BC.Set(i, _BC);
+		Geometry.BCmid.Set(i, _BCmid);
+		Geometry.CA.Set(i, _CA);
+		Geometry.CAmid.Set(i, _CAmid);
+
+		Geometry.V.Set(i, _V);
+		Geometry.D1.Set(i, _D1);
+		Geometry.D2.Set(i, _D2);
+		Geometry.D3.Set(i, _D3);
+
+		// The line intersection divides by zero for degenerate triangles, which get the kernel's fallback point instead
+		float Denominator = _D1.Y * _D2.X - _D2.Y * _D1.X;
+		if (Geometry.Degenerate[i] || Denominator == 0) {
+			Geometry.ABBC.Set(i, Geometry.Circumcenters.Get(i));
+			return;
 		}
-	}
+
+		float CircumcenterX = _ABmid.X + _D1.X * (((_BCmid.Y - _ABmid.Y) * (_D2.X) + (_D2.Y * _ABmid.X) - (_D2.Y * _BCmid.X)) / Denominator);
+		float CircumcenterY = _ABmid.Y + _D1.Y * (((_BCmid.Y - _ABmid.Y) * (_D2.X) + (_D2.Y * _ABmid.X) - (_D2.Y * _BCmid.X)) / Denominator);
+		float CircumcenterZ = _ABmid.Z + _D1.Z * (((_BCmid.Y - _ABmid.Y) * (_D2.X) + (_D2.Y * _ABmid.X) - (_D2.Y * _BCmid.X)) / Denominator);
+		FVector _ABBC = FVector(CircumcenterX, CircumcenterY, CircumcenterZ);
+		Geometry.ABBC.Set(i, _ABBC);
+	});
 }
 
-void FJointBufferThread::UpdateEulerLines()
+void FJointBufferThread::UpdateEulerLines(FJointBufferFrame& Frame)
 {
-	EulerLines.Empty();
-	TriangleCircumcenters.Empty();
-	TriangleCentroids.Empty();
-	// Update debug vector arrays
-	int TriangleCount = 0;
-	for (int i = 0; i < TrianglePositions.Num() / 3; i++) {
-
-		int StartIndex = TrianglePositions.Num() - 201;
-
-		FVector A(TrianglePositions[StartIndex + TriangleCount * 3].X, TrianglePositions[StartIndex + TriangleCount * 3].Y, TrianglePositions[StartIndex + TriangleCount * 3].Z);
-		FVector B(TrianglePositions[StartIndex + TriangleCount * 3 + 1].X, TrianglePositions[StartIndex + TriangleCount * 3 + 1].Y, TrianglePositions[StartIndex + TriangleCount * 3 + 1].Z);
-		FVector C(TrianglePositions[StartIndex + TriangleCount * 3 + 2].X, TrianglePositions[StartIndex + TriangleCount * 3 + 2].Y, TrianglePositions[StartIndex + TriangleCount * 3 + 2].Z);
-
-		FVector Centroid((A.X + B.X + C.X) / 3, (A.Y + B.Y + C.Y) / 3, (A.Z + B.Z + C.Z) / 3);
-		double _a[3] = { double(A.X), double(A.Y), double(A.Z) };
-		double _b[3] = { double(B.X), double(B.Y), double(B.Z) };
-		double _c[3] = { double(C.X), double(C.Y), double(C.Z) };
-		double _result[3] = { 0,0,0 };
-		TriCircumCenter3D(_a, _b, _c, _result);
-		FVector Circumcenter = FVector(_result[0], _result[1], _result[2]);
-		FVector Final = Centroid - Circumcenter;
-		TriangleCentroids.Emplace(Centroid);
-		TriangleCircumcenters.Emplace(Circumcenter);
-		EulerLines.Emplace(Final);
-		TriangleCount++;
-	}
+	FTriangleGeometryStore& Geometry = Frame.Geometry;
+
+	// Centroids, circumcenters and Euler lines in one batched pass over the SoA columns
+	Frame.RobustCircumcenters = 0;
+	Frame.ExactPredicates = 0;
+	Frame.DegenerateTriangles = 0;
+	const float Quality = DegenerateQuality;
+	ForEachTriangleRange(Frame, Geometry.Num(), [&Frame, &Geometry, Quality](int32 Begin, int32 End) {
+		FEulerLineStats Stats = FTriangleGeometryKernels::UpdateEulerLines(Geometry, Begin, End, Quality);
+		if (Stats.RobustTriangles > 0) {
+			FPlatformAtomics::InterlockedAdd(&Frame.RobustCircumcenters, Stats.RobustTriangles);
+			FPlatformAtomics::InterlockedAdd(&Frame.ExactPredicates, Stats.ExactPredicates);
+		}
+		if (Stats.DegenerateTriangles > 0) {
+			FPlatformAtomics::InterlockedAdd(&Frame.DegenerateTriangles, Stats.DegenerateTriangles);
+		}
+	});
+	INC_DWORD_STAT_BY(STAT_TauRobustCircumcenters, Frame.RobustCircumcenters);
+	INC_DWORD_STAT_BY(STAT_TauExactPredicates, Frame.ExactPredicates);
+	INC_DWORD_STAT_BY(STAT_TauDegenerateTriangles, Frame.DegenerateTriangles);
 
 	//UE_LOG(LogTemp, Display, TEXT("Euler Lines Created"));
 }
 
-void FJointBufferThread::UpdateTracking()
+void FJointBufferThread::UpdateTracking(FJointBufferFrame& Frame)
 {
-
-	SmoothingSamplesCount = 3;
-	if (TriangleTauBuffers.size() == 0) {
-		int TriangleCount = 0;
-		for (int i = 0; i < TriangleIndexBoneNames.Num() / 3; i++) {
-			FString Base = TriangleIndexBoneNames[TriangleCount * 3].ToString().Append(TriangleIndexBoneNames[TriangleCount * 3 + 1].ToString()).Append(TriangleIndexBoneNames[TriangleCount * 3 + 2].ToString());
-			FName Name = FName(*Base);
-			//UE_LOG(LogTemp, Display, TEXT("Tracking tau for %i"), TriangleCount);
-			std::ostringstream s;
-			s << TriangleCount;
-			std::string CountIndex = s.str();
-			std::string SName(TCHAR_TO_UTF8(*Name.ToString()));
-			std::string BufferName = "Triangle Tau Buffer " + CountIndex + SName;
-			FString FBufferName(BufferName.c_str());
-			FName FinalName = FName(*FBufferName);
-			//UE_LOG(LogTemp, Display, TEXT("%s"), *FinalName.ToString());
-			int StartIndex = TrianglePositions.Num() - 201;
-			FVector A(TrianglePositions[StartIndex + TriangleCount * 3].X, TrianglePositions[StartIndex + TriangleCount * 3].Y, TrianglePositions[StartIndex + TriangleCount * 3].Z);
-			FVector Circumcenter = TriangleCircumcenters[i];
-			FVector Radius = TrianglePositions[0];
-			FVector EulerLine = EulerLines[i];
-			UTauBuffer* TriangleBuffer = new UTauBuffer();
+	if (TauStates == nullptr) {
+		// Histories hold the smoothing window plus the sample pushed this frame, and drop the oldest one on their own
+		TauStateHandle = TauStatePool->Acquire(Frame.Geometry.Num(), SmoothingSamplesCount + 1);
+		TauStates = TauStatePool->Resolve(TauStateHandle);
+		for (int i = 0; i < TauStates->TriangleCount; i++) {
+			//UE_LOG(LogTemp, Display, TEXT("Tracking tau for %i"), i);
+			FVector Radius = Frame.TrianglePositions[0];
+			FVector EulerLine = Frame.Geometry.EulerLines.Get(i);
+			UTauBuffer* TriangleBuffer = &TauStates->States[i];
 			TriangleBuffer->CurrentTime = FApp::GetCurrentTime();
 			TriangleBuffer->BeginningTime = FApp::GetCurrentTime();
 			TriangleBuffer->LastMeasuringStick = TriangleBuffer->MeasuringStick;
 			TriangleBuffer->MeasuringStick = Radius;
 			TriangleBuffer->BeginningPosition = FVector4(EulerLine.X, EulerLine.Y, EulerLine.Z, 0.0);
 			TriangleBuffer->MotionPath.Emplace(TriangleBuffer->BeginningPosition);
-			TriangleTauBuffers.emplace_back(TriangleBuffer);
-			TriangleCount++;
-
 		}
 		return;
 	}
 
 	//UE_LOG(LogTemp, Warning, TEXT("Triangle tau buffers length: %i"), TriangleTauBuffers.Num());
 
-	int TriangleCount = 0;
-	for (int i = 0; i < TriangleTauBuffers.size(); i++) {
-		FName Name = TriangleIndexBoneNames[TriangleCount * 3];
-		//UE_LOG(LogTemp, Display, TEXT("Tracking tau for %i"), TriangleCount);
-		UTauBuffer* Buffer = TriangleTauBuffers[TriangleCount];
-		//UE_LOG(LogTemp, Display, TEXT("%s"), *Buffer->GetFName().ToString());
-		Buffer->LastReadingTime = Buffer->CurrentTime;
-		Buffer->CurrentTime = FApp::GetCurrentTime();
-		//UE_LOG(LogTemp, Display, TEXT("Check Time %f, %f"),Buffer->CurrentTime, Buffer->LastReadingTime);
-		Buffer->ElapsedSinceLastReadingTime = FApp::GetDeltaTime();
-		Buffer->ElapsedSinceBeginningGestureTime = Buffer->CurrentTime - Buffer->BeginningTime;
-		//UE_LOG(LogTemp, Display, TEXT("Elapsed Time %f"), Buffer->ElapsedSinceLastReadingTime);
-		Buffer->ElapsedTimeSamples.Emplace(Buffer->ElapsedSinceLastReadingTime);
-		FVector EulerLine = EulerLines[i];
-		Buffer->MotionPath.Emplace(FVector4(EulerLine.X, EulerLine.Y, EulerLine.Z, Buffer->CurrentTime));
-		Buffer->EndingPosition = FVector4(EulerLine.X, EulerLine.Y, EulerLine.Z, Buffer->CurrentTime);
-		Buffer->CalculateIncrementalGestureChange(i);
-		//Buffer->CalculateFullGestureChange();
-
-		if (Buffer->IncrementalAngleTauSamples.Num() > SmoothingSamplesCount)
-		{
-			Buffer->IncrementalAngleTauSamples.RemoveAt(0, 1, true);
-		}
-		if (Buffer->IncrementalAngleTauDotSamples.Num() > SmoothingSamplesCount)
-		{
-			Buffer->IncrementalAngleTauDotSamples.RemoveAt(0, 1, true);
-		}
-		if (Buffer->IncrementalAngleTauDotSmoothedDiffFromLastFrame.Num() > SmoothingSamplesCount)
-		{
-			Buffer->IncrementalAngleTauDotSmoothedDiffFromLastFrame.RemoveAt(0, 1, true);
-		}
-		if (Buffer->IncrementalPositionTauSamples.Num() > SmoothingSamplesCount)
-		{
-			Buffer->IncrementalPositionTauSamples.RemoveAt(0, 1, true);
-		}
-		if (Buffer->IncrementalPositionTauDotSamples.Num() > SmoothingSamplesCount)
-		{
-			Buffer->IncrementalPositionTauDotSamples.RemoveAt(0, 1, true);
-		}
-		if (Buffer->IncrementalPositionTauDotSmoothedDiffFromLastFrame.Num() > SmoothingSamplesCount)
-		{
-			Buffer->IncrementalPositionTauDotSmoothedDiffFromLastFrame.RemoveAt(0, 1, true);
-		}
-		if (Buffer->ElapsedTimeSamples.Num() > SmoothingSamplesCount) {
-			Buffer->ElapsedTimeSamples.RemoveAt(0, 1, true);
-		}
-		if (Buffer->IncrementalGestureAngleChanges.Num() > SmoothingSamplesCount) {
-			Buffer->IncrementalGestureAngleChanges.RemoveAt(0, 1, true);
-		}
-		if (Buffer->IncrementalGesturePositionChanges.Num() > SmoothingSamplesCount) {
-			Buffer->IncrementalGesturePositionChanges.RemoveAt(0, 1, true);
-		}
-		if (Buffer->MotionPath.Num() > SmoothingSamplesCount) {
-			Buffer->MotionPath.RemoveAt(0, 1, true);
-		}
-		if (Buffer->FullGestureTauSamples.Num() > SmoothingSamplesCount)
-		{
-			Buffer->FullGestureTauSamples.RemoveAt(0, 1, true);
-		}
-		if (Buffer->FullGestureTauDotSamples.Num() > SmoothingSamplesCount)
-		{
-			Buffer->FullGestureTauDotSamples.RemoveAt(0, 1, true);
+	// Triangles past TrackedTriangleCount keep their last samples until the budget allows tracking them again
+	int32 TrackedCount = TauStates->TriangleCount;
+	if (Frame.TrackedTriangleCount > 0) {
+		TrackedCount = FMath::Min(TrackedCount, Frame.TrackedTriangleCount);
+	}
+
+	TauGestureColumns.SetNum(TauStates->TriangleCount);
+
+	if (Frame.TauRecording.IsValid()) {
+		Frame.TauRecording->AddFrame(Frame.Geometry, FApp::GetDeltaTime());
+	}
+
+	// The approximate math modes only exist on the batched path
+	const bool bBatched = Frame.bVectorizedTau || Frame.TauMathMode != ETauMathMode::Precise;
+
+	ForEachTriangleRange(Frame, TrackedCount, [this, &Frame, bBatched](int32 Begin, int32 End) {
+		for (int32 i = Begin; i < End; i++) {
+			//UE_LOG(LogTemp, Display, TEXT("Tracking tau for %i"), i);
+			UTauBuffer* Buffer = &TauStates->States[i];
+			//UE_LOG(LogTemp, Display, TEXT("%s"), *Buffer->GetFName().ToString());
+			Buffer->LastReadingTime = Buffer->CurrentTime;
+			Buffer->CurrentTime = FApp::GetCurrentTime();
+			//UE_LOG(LogTemp, Display, TEXT("Check Time %f, %f"),Buffer->CurrentTime, Buffer->LastReadingTime);
+			Buffer->ElapsedSinceLastReadingTime = FApp::GetDeltaTime();
+			Buffer->ElapsedSinceBeginningGestureTime = Buffer->CurrentTime - Buffer->BeginningTime;
+			//UE_LOG(LogTemp, Display, TEXT("Elapsed Time %f"), Buffer->ElapsedSinceLastReadingTime);
+			Buffer->ElapsedTimeSamples.Emplace(Buffer->ElapsedSinceLastReadingTime);
+			FVector EulerLine = Frame.Geometry.EulerLines.Get(i);
+			// A non-finite point would stay in the motion path and the running sums for the whole window
+			if (EulerLine.ContainsNaN()) {
+				Buffer->NonFiniteSamples++;
+				TauGestureColumns.Deactivate(i);
+				continue;
+			}
+			Buffer->MotionPath.Emplace(FVector4(EulerLine.X, EulerLine.Y, EulerLine.Z, Buffer->CurrentTime));
+			Buffer->EndingPosition = FVector4(EulerLine.X, EulerLine.Y, EulerLine.Z, Buffer->CurrentTime);
+			if (bBatched) {
+				Buffer->PrepareGestureChange(TauGestureColumns, i);
+			}
+			else {
+				Buffer->CalculateIncrementalGestureChange(i);
+			}
+			//Buffer->CalculateFullGestureChange();
 		}
-		if (Buffer->FullGestureTauDotSmoothedDiffFromLastFrame.Num() > SmoothingSamplesCount)
-		{
-			Buffer->FullGestureTauDotSmoothedDiffFromLastFrame.RemoveAt(0, 1, true);
+
+		// The range's states are still in cache when the batched results are pushed back
+		if (bBatched) {
+			FTauGestureKernels::UpdateGestureChanges(TauGestureColumns, Begin, End, Frame.TauMathMode);
 		}
 
-		if (false) {
-			int index = 0;
-			for (double Sample : Buffer->IncrementalAngleTauSamples)
-			{
-				UE_LOG(LogTemp, Display, TEXT("Tau Angle Samples: %i\t%f"), index, Sample);
-				index++;
+		for (int32 i = Begin; i < End; i++) {
+			UTauBuffer* Buffer = &TauStates->States[i];
+			if (Frame.Geometry.EulerLines.Get(i).ContainsNaN()) {
+				continue;
 			}
-			index = 0;
-			for (double Sample : Buffer->IncrementalPositionTauSamples)
-			{
-				UE_LOG(LogTemp, Display, TEXT("Tau Position Samples: %i\t%f"), index, Sample);
-				index++;
+			if (bBatched) {
+				Buffer->ApplyGestureChange(TauGestureColumns, i);
 			}
-			index = 0;
-			for (double Sample : Buffer->IncrementalAngleTauDotSamples)
-			{
-				UE_LOG(LogTemp, Display, TEXT("Tau Angle Dot Samples: %i\t%f"), index, Sample);
-				index++;
-			}
-			index = 0;
-			for (double Sample : Buffer->IncrementalPositionTauDotSamples)
-			{
-				UE_LOG(LogTemp, Display, TEXT("Tau Position Dot Samples: %i\t%f"), index, Sample);
-				index++;
+			if ((Buffer->IncrementalAngleTauSamples.Num() > 0 && !FMath::IsFinite(Buffer->IncrementalAngleTauSamples.Last()))
+				|| (Buffer->IncrementalPositionTauSamples.Num() > 0 && !FMath::IsFinite(Buffer->IncrementalPositionTauSamples.Last()))) {
+				Buffer->NonFiniteSamples++;
 			}
 
-		}
+			if (false) {
+				int index = 0;
+				for (double Sample : Buffer->IncrementalAngleTauSamples)
+				{
+					UE_LOG(LogTemp, Display, TEXT("Tau Angle Samples: %i\t%f"), index, Sample);
+					index++;
+				}
+				index = 0;
+				for (double Sample : Buffer->IncrementalPositionTauSamples)
+				{
+					UE_LOG(LogTemp, Display, TEXT("Tau Position Samples: %i\t%f"), index, Sample);
+					index++;
+				}
+				index = 0;
+				for (double Sample : Buffer->IncrementalAngleTauDotSamples)
+				{
+					UE_LOG(LogTemp, Display, TEXT("Tau Angle Dot Samples: %i\t%f"), index, Sample);
+					index++;
+				}
+				index = 0;
+				for (double Sample : Buffer->IncrementalPositionTauDotSamples)
+				{
+					UE_LOG(LogTemp, Display, TEXT("Tau Position Dot Samples: %i\t%f"), index, Sample);
+					index++;
+				}
 
-		TriangleCount++;
-	}
+			}
+		}
+	});
 }
\ No newline at end of file
@@ -5,11 +5,105 @@
 #include <vector>
 #include "CoreMinimal.h"
 #include "HAL/Runnable.h"
+#include "HAL/Event.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "UObject/NameTypes.h" 
+#include "Async/TaskGraphInterfaces.h"
+#include "TriangleGeometryStore.h"
+#include "TauTriangleTopology.h"
+#include "TauStatePool.h"
+#include "TauGestureKernels.h"
+#include "SkeletonFrame.h"
 
 class FRunnableThread;
 class UNuitrackSkeletonJointBuffer;
-class UTauBuffer;
+
+/**
+ * Per-frame working set of the calculation pipeline. Each in-flight frame owns one of these,
+ * so the geometry stage of one frame can run while the tau stage of the previous one finishes.
+ */
+struct FJointBufferFrame
+{
+	FSkeletonFrame Skeleton;
+
+	TArray<FVector> TrianglePositions;
+	TArray<int> TriangleIndexes;
+
+	// Vertices, centroids, circumcenters, Euler lines and debug vectors per triangle
+	FTriangleGeometryStore Geometry;
+
+	// Near-collinear triangles whose circumcenter took the robust path, and the exact predicate evaluations among them
+	int32 RobustCircumcenters = 0;
+	int32 ExactPredicates = 0;
+
+	// Triangles the area-ratio test flagged as degenerate this frame
+	int32 DegenerateTriangles = 0;
+
+	uint32 StartCycles = 0;
+
+	// Quality settings captured when the frame was posted, so a change never splits a frame across stages
+	bool bParallelTriangles = true;
+	int32 TriangleGrainSize = 16;
+	int32 TrackedTriangleCount = 0;
+	bool bUpdateDebugGeometry = true;
+	bool bVectorizedTau = true;
+	ETauMathMode TauMathMode = ETauMathMode::Precise;
+
+	// Set while a recording for the math mode validation still takes frames
+	TSharedPtr<FTauMotionRecording, ESPMode::ThreadSafe> TauRecording;
+
+	// Completes when the tau stage for this frame is done and the slot can be reused
+	FGraphEventRef CompletionEvent;
+};
+
+/**
+ * One ForEachTriangleRange call, shared with the task graph helpers that take chunks of it.
+ * Each worker preallocates a few of these; a slot is reused once the caller and every helper let go of it.
+ */
+struct FTriangleRangeJob
+{
+	const TFunctionRef<void(int32, int32)>* Body = nullptr;
+	int32 TriangleCount = 0;
+	int32 GrainSize = 1;
+	int32 ChunkCount = 0;
+	volatile int32 NextChunk = 0;
+
+	// Helpers currently taking chunks
+	volatile int32 ActiveHelpers = 0;
+
+	// The caller plus every helper that has not finished yet; the slot is free at 0
+	volatile int32 References = 0;
+
+	// Runs chunks until none are left
+	void RunChunks();
+
+	// Body of a helper task. A helper that starts after the last chunk was taken never touches Body.
+	void Help();
+};
+
+/**
+ * Quality settings the worker applies per frame. Captured from the joint buffer on the game thread,
+ * so the sensor thread posting frames never reads UObject properties.
+ */
+struct FJointBufferQualitySettings
+{
+	bool bParallelTriangles = true;
+	int32 TriangleGrainSize = 16;
+	bool bPipelinedStages = false;
+	int32 TrackedTriangleCount = 0;
+	bool bUpdateDebugGeometry = true;
+	bool bVectorizedTau = true;
+};
+
+enum class EJointBufferStage : uint8
+{
+	Assembly,
+	Geometry,
+	Tau,
+	Count
+};
 
 /**
  * 
@@ -17,11 +111,33 @@ class UTauBuffer;
 class FJointBufferThread : public FRunnable
 {
 public:
-	FJointBufferThread(TArray<FName>_BoneNames, TArray<FVector>_Locations, TArray<FRotator>_Rotations, TArray<float>_Confidences, std::vector<UTauBuffer*> _PreviousTriangleTauBuffers, UNuitrackSkeletonJointBuffer* _JointBuffer);
+	// With _bUseSharedWorkerPool the object is never run as its own thread; frames are dispatched to the task graph instead
+	FJointBufferThread(UNuitrackSkeletonJointBuffer* _JointBuffer, bool _bUseSharedWorkerPool = false);
 	~FJointBufferThread();
 
-	bool bStopThread;
-	bool bProcessComplete;
+	FThreadSafeBool bStopThread;
+
+	bool bUseSharedWorkerPool;
+
+	// Triangle set compiled by the joint buffer; fixed for the lifetime of this worker
+	FTauTopologyPtr Topology;
+
+	// Hands a new skeleton frame to the worker and wakes it up. If the worker is still busy
+	// the pending frame is replaced, so the worker always picks up the newest one.
+	void PostFrame(const FSkeletonFrame& Skeleton);
+
+	// Game thread only. Quality settings used from the next frame the worker picks up.
+	void SetQualitySettings(const FJointBufferQualitySettings& Settings);
+
+	// Game thread only. Math mode and recording used from the next frame the worker picks up; a completed
+	// recording is dropped. Kept apart from PostFrame, which runs on the sensor thread.
+	void SetTauMathSettings(ETauMathMode MathMode, const TSharedPtr<FTauMotionRecording, ESPMode::ThreadSafe>& Recording);
+
+	// Wake-up latency between PostFrame and the worker picking the frame up, in seconds.
+	void GetWakeLatencyStats(double& OutLastLatency, double& OutAverageLatency, int32& OutFrameCount);
+
+	// Fraction of wall time each stage spent busy since the worker started, and frames currently in flight.
+	void GetStageOccupancy(float OutOccupancy[(int32)EJointBufferStage::Count], int32& OutFramesInFlight);
 
 		int MinDebugTriangleIndex;
 
@@ -31,50 +147,82 @@ public:
 
 		double LastReadingTime;
 
+		// Tau history window, read from the joint buffer when the thread starts
 		int SmoothingSamplesCount;
 
-		TArray<FVector> TrianglePositions;
+		// Area ratio below which a triangle counts as degenerate, read from the joint buffer when the thread starts
+		float DegenerateQuality;
 
-		TArray<int> TriangleIndexes;
+		// Per-triangle tau state, leased from the joint buffer's pool on the first tracked frame
+		FTauStatePoolPtr TauStatePool;
 
-		TArray<FName> TriangleIndexBoneNames;
+		FTauStateHandle TauStateHandle;
 
-		TArray<FRotator> TriangleRotations;
+		FTauStateBlock* TauStates;
 
-		TArray<FVector> TriangleCentroids;
+		// Gathered tau inputs and kernel outputs, reused by every tau stage
+		FTauGestureStore TauGestureColumns;
 
-		TArray<FVector> TriangleCircumcenters;
+		// Run geometry and tau as separate task graph stages so consecutive frames overlap
+		bool bPipelinedStages;
 
-		TArray<FVector> EulerLines;
+		// Time between the start of assembly and the end of the tau stage for the last frame
+		double LastComputeSeconds;
 
-		std::vector<UTauBuffer*> TriangleTauBuffers;
+		// Runs all stages for one frame inline on the calling thread
+		void ProcessSocketRawData(FJointBufferFrame& Frame);
 
-		void ProcessSocketRawData();
+		// Copies this frame's results into the joint buffer's triple buffer and makes them visible to the reader
+		void PublishFrameResult(FJointBufferFrame& Frame);
 
 	virtual bool Init();
 	virtual uint32 Run();
 	virtual void Stop();
 
+	// Blocks until every task dispatched for this buffer has finished. Call after Stop in pool mode.
+	void WaitForOutstandingTasks();
+
+	// Task graph entry point; see DispatchTask
+	typedef void (FJointBufferThread::*FTaskFunction)(FJointBufferFrame* Frame);
+
 protected:
-	TArray<FVector> AB;
-	TArray<FVector> ABmid;
-	TArray<FVector> BC;
-	TArray<FVector> BCmid;
-	TArray<FVector> CA;
-	TArray<FVector> CAmid;
-	TArray<FVector> V;
-	TArray<FVector> D1;
-	TArray<FVector> D2;
-	TArray<FVector> D3;
-	TArray<FVector> ABBC;
+		void UpdateTriangles(FJointBufferFrame& Frame);
+
+		void UpdateDebugLines(FJointBufferFrame& Frame);
+
+		void UpdateEulerLines(FJointBufferFrame& Frame);
+
+		void UpdateTracking(FJointBufferFrame& Frame);
+
+		// Moves the pending input into the next free slot and processes or dispatches it
+		void RunPendingFrame();
 
-		void UpdateTriangles(TArray<FName>BoneNames, TArray<FVector>Locations, TArray<FRotator>Rotations);
+		// Assembles the frame and dispatches its geometry and tau stages to the task graph
+		void DispatchPipelinedFrame(FJointBufferFrame& Frame);
 
-		void UpdateDebugLines();
+		// Pool mode replacement for waking the dedicated thread. The dispatch runs after WaitFor when it is set.
+		void DispatchPoolFrame(FGraphEventRef WaitFor = nullptr);
 
-		void UpdateEulerLines();
+		// Queues Function(Frame) on the task graph behind Prerequisites. The task fits the task graph's
+		// recycled small-task memory, so steady-state frames dispatch without touching the heap.
+		FGraphEventRef DispatchTask(FTaskFunction Function, FJointBufferFrame* Frame, const FGraphEventArray* Prerequisites);
 
-		void UpdateTracking();
+		void RunPoolDispatch(FJointBufferFrame* Frame);
+
+		void RunGeometryStage(FJointBufferFrame* Frame);
+
+		void RunTauStage(FJointBufferFrame* Frame);
+
+		// Whole frame chained behind the pipelined frame still in flight
+		void RunSerialFrame(FJointBufferFrame* Frame);
+
+		void AddStageTime(EJointBufferStage Stage, uint32 StartCycles);
+
+		// Splits per-triangle work across the task graph in chunks of the frame's TriangleGrainSize, or runs it serially
+		void ForEachTriangle(const FJointBufferFrame& Frame, int32 TriangleCount, TFunctionRef<void(int32)> Body);
+
+		// Same split as ForEachTriangle, but hands whole [Begin, End) ranges to kernels that loop over the SoA columns themselves
+		void ForEachTriangleRange(const FJointBufferFrame& Frame, int32 TriangleCount, TFunctionRef<void(int32, int32)> Body);
 
 		float Map(float value,
 			float istart,
@@ -85,9 +233,40 @@ protected:
 
 private:
 
-	TArray<FName> SocketBoneNames;
-	TArray<FVector> SocketLocations;
-	TArray<FRotator> SocketRotations;
-	TArray<float> SocketConfidences;
+	FEvent* WorkEvent;
+	FCriticalSection PendingFrameLock;
+	bool bHasPendingFrame;
+	double PendingFramePostTime;
+	FJointBufferQualitySettings PendingQuality;
+	ETauMathMode PendingTauMathMode;
+	TSharedPtr<FTauMotionRecording, ESPMode::ThreadSafe> PendingTauRecording;
+
+	FSkeletonFrame PendingSkeleton;
+
+	double LastWakeLatency;
+	double TotalWakeLatency;
+	int32 WokenFrameCount;
+
+	uint64 PublishedSequence;
+	int32 PublishedNonFiniteSamples;
+
+	// Three slots let frame N+1's geometry overlap frame N's tau while one more frame is being assembled
+	static const int32 PipelineDepth = 3;
+	FJointBufferFrame Frames[PipelineDepth];
+	int32 NextFrameIndex;
+	FGraphEventRef LastTauEvent;
+
+	// Both guarded by PendingFrameLock; a dispatch task may requeue itself behind a tau task instead of blocking
+	bool bPoolDispatchQueued;
+	FGraphEventRef LastPoolDispatchEvent;
+
+	// Enough for the geometry and tau stages of overlapping frames plus helpers that start late
+	static const int32 MaxRangeJobs = 8;
+	FTriangleRangeJob RangeJobs[MaxRangeJobs];
+
+	double StartTime;
+	volatile int64 StageBusyCycles[(int32)EJointBufferStage::Count];
+	FThreadSafeCounter FramesInFlight;
+
 	UNuitrackSkeletonJointBuffer *JointBuffer;
 };
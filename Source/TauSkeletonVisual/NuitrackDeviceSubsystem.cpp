@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NuitrackDeviceSubsystem.h"
+#include "NuitrackPollingThread.h"
+#include "SkeletonOrientationKernels.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+#include <exception>
+
+using tdv::nuitrack::Nuitrack;
+using tdv::nuitrack::JointType;
+
+void UNuitrackDeviceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	bDidInitNuitrack = false;
+	LastPumpedFrame = MAX_uint64;
+	SnapshotSequence = 0;
+	DeliveredSnapshots = 0;
+
+	try {
+		UE_LOG(LogTemp, Warning, TEXT("Nuitrack::init() CALLING..."));
+		Nuitrack::init();
+
+		UE_LOG(LogTemp, Warning, TEXT("SkeletonTracker::create() CALLING..."));
+		skeletonTracker = SkeletonTracker::create();
+
+		UE_LOG(LogTemp, Warning, TEXT(
+			"skeletonTracker->connectOnUpdate() CALLING..."));
+		skeletonTracker->connectOnUpdate(
+			std::bind(&UNuitrackDeviceSubsystem::OnSkeletonUpdate,
+				this, std::placeholders::_1));
+
+		UE_LOG(LogTemp, Warning, TEXT("Nuitrack::run() CALLING..."));
+		Nuitrack::run();
+		bDidInitNuitrack = true;
+	}
+	catch (const std::exception& e) {
+		UE_LOG(LogTemp, Warning, TEXT("Nuitrack could not be started: %s"), UTF8_TO_TCHAR(e.what()));
+	}
+}
+
+void UNuitrackDeviceSubsystem::Deinitialize()
+{
+	if (CurrentPollingThread) {
+		// waitUpdate only returns with the next sensor frame, which never comes once the sensor is unplugged
+		PollingThread->Stop();
+		bool bExited = PollingThread->WaitForExit(PollingThreadJoinSeconds);
+		if (!bExited && bDidInitNuitrack) {
+			// Releasing the session makes the pending waitUpdate throw, and the loop then sees the stop flag
+			UE_LOG(LogTemp, Warning, TEXT("Nuitrack polling thread still waiting for a frame, releasing the session"));
+			bDidInitNuitrack = false;
+			try {
+				Nuitrack::release();
+			}
+			catch (const std::exception& e) {
+				UE_LOG(LogTemp, Warning, TEXT("Nuitrack::release() failed: %s"), UTF8_TO_TCHAR(e.what()));
+			}
+			bExited = PollingThread->WaitForExit(PollingThreadJoinSeconds);
+		}
+		if (bExited) {
+			CurrentPollingThread->Kill(true);
+			delete CurrentPollingThread;
+			delete PollingThread;
+		}
+		else {
+			// Deleting a thread that is still running would crash; with the session released it can no longer call back into us
+			UE_LOG(LogTemp, Error, TEXT("Nuitrack polling thread did not exit, leaving it behind"));
+		}
+		CurrentPollingThread = nullptr;
+		PollingThread = nullptr;
+	}
+	bSensorThreadActive = false;
+
+	{
+		FScopeLock Lock(&SubscribersLock);
+		OnSnapshot.Clear();
+	}
+	SnapshotPool.Empty();
+
+	if (bDidInitNuitrack) {
+		Nuitrack::release();
+		bDidInitNuitrack = false;
+	}
+	Super::Deinitialize();
+}
+
+FDelegateHandle UNuitrackDeviceSubsystem::Subscribe(FOnNuitrackSnapshot::FDelegate&& Delegate)
+{
+	FScopeLock Lock(&SubscribersLock);
+	return OnSnapshot.Add(MoveTemp(Delegate));
+}
+
+void UNuitrackDeviceSubsystem::Unsubscribe(FDelegateHandle Handle)
+{
+	// Delivery holds the same lock, so no callback for this handle runs after we return
+	FScopeLock Lock(&SubscribersLock);
+	OnSnapshot.Remove(Handle);
+}
+
+void UNuitrackDeviceSubsystem::RequestSensorThread()
+{
+	if (!bDidInitNuitrack || CurrentPollingThread != nullptr) {
+		return;
+	}
+
+	// Set before the thread starts, so PumpGameThread stops calling Nuitrack::update right away
+	bSensorThreadActive = true;
+	PollingThread = new FNuitrackPollingThread(this);
+	CurrentPollingThread = FRunnableThread::Create(PollingThread, TEXT("NuitrackPollingThread"));
+}
+
+void UNuitrackDeviceSubsystem::PumpGameThread()
+{
+	// Several actors may pump in the same frame; only the first one reaches Nuitrack
+	if (!bDidInitNuitrack || bSensorThreadActive || LastPumpedFrame == GFrameCounter) {
+		return;
+	}
+	LastPumpedFrame = GFrameCounter;
+	Nuitrack::update();
+}
+
+TSharedPtr<const FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> UNuitrackDeviceSubsystem::GetLatestSnapshot()
+{
+	FScopeLock Lock(&LatestSnapshotLock);
+	return LatestSnapshot;
+}
+
+TSharedRef<FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> UNuitrackDeviceSubsystem::AcquireSnapshot()
+{
+	// Subscribers only ever drop references to pooled snapshots, so a unique one stays free
+	for (const TSharedRef<FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe>& Pooled : SnapshotPool) {
+		if (Pooled.IsUnique()) {
+			return Pooled;
+		}
+	}
+
+	TSharedRef<FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe>();
+	if (SnapshotPool.Num() < MaxPooledSnapshots) {
+		SnapshotPool.Add(Snapshot);
+	}
+	return Snapshot;
+}
+
+void UNuitrackDeviceSubsystem::OnSkeletonUpdate(SkeletonData::Ptr userSkeletons)
+{
+	// Decode once; every subscriber shares the same immutable snapshot
+	TSharedRef<FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> Snapshot = AcquireSnapshot();
+	// getSkeletons copies the SDK's vector; that allocation is on Nuitrack's side
+	auto skeletons = userSkeletons->getSkeletons();
+	Snapshot->Sequence = ++SnapshotSequence;
+	// Keeps the recycled array's allocation, so a steady user count decodes without allocating
+	Snapshot->Users.SetNum(skeletons.size(), false);
+	for (int32 ii = 0; ii < Snapshot->Users.Num(); ii++) {
+		DecodeUser(skeletons[ii].id, skeletons[ii].joints, Snapshot->Users[ii]);
+	}
+
+	FNuitrackSnapshotRef SharedSnapshot = Snapshot;
+	{
+		FScopeLock Lock(&LatestSnapshotLock);
+		LatestSnapshot = SharedSnapshot;
+	}
+
+	FScopeLock Lock(&SubscribersLock);
+	OnSnapshot.Broadcast(SharedSnapshot);
+	DeliveredSnapshots++;
+}
+
+
+/**
+ * @ingroup SkeletonTracker_group
+ * @brief Joint index meaning (please note that <i>JOINT_LEFT_FINGERTIP, JOINT_RIGHT_FINGERTIP, JOINT_LEFT_FOOT, JOINT_RIGHT_FOOT</i> are not used in the current version).
+
+enum NT_JOINT
+{
+	JOINT_NONE = 0, ///< Reserved joint (unused).
+
+	JOINT_HEAD = 1, ///< Head
+	JOINT_NECK = 2, ///< Neck
+	JOINT_TORSO = 3, ///< Torso
+	JOINT_WAIST = 4, ///< Waist
+
+	JOINT_LEFT_COLLAR = 5, ///< Left collar
+	JOINT_LEFT_SHOULDER = 6, ///< Left shoulder
+	JOINT_LEFT_ELBOW = 7, ///< Left elbow
+	JOINT_LEFT_WRIST = 8, ///< Left wrist
+	JOINT_LEFT_HAND = 9, ///< Left hand
+	JOINT_LEFT_FINGERTIP = 10, ///< Left fingertip (<b>not used in the current version</b>).
+
+	JOINT_RIGHT_COLLAR = 11, ///< Right collar
+	JOINT_RIGHT_SHOULDER = 12, ///< Right shoulder
+	JOINT_RIGHT_ELBOW = 13, ///< Right elbow
+	JOINT_RIGHT_WRIST = 14, ///< Right wrist
+	JOINT_RIGHT_HAND = 15, ///< Right hand
+	JOINT_RIGHT_FINGERTIP = 16, ///< Right fingertip (<b>not used in the current version</b>).
+
+	JOINT_LEFT_HIP = 17, ///< Left hip
+	JOINT_LEFT_KNEE = 18, ///< Left knee
+	JOINT_LEFT_ANKLE = 19, ///< Left ankle
+	JOINT_LEFT_FOOT = 20, ///< Left foot (<b>not used in the current version</b>).
+
+	JOINT_RIGHT_HIP = 21, ///< Right hip
+	JOINT_RIGHT_KNEE = 22, ///< Right knee
+	JOINT_RIGHT_ANKLE = 23, ///< Right ankle
+	JOINT_RIGHT_FOOT = 24 ///< Right foot (<b>not used in the current version</b>).
+};
+ */
+
+// Nuitrack joint behind each FSkeletonFrame joint; the collars and unused end joints are skipped
+static const JointType SkeletonFrameJointTypes[FSkeletonFrame::JointCount] = {
+	JointType::JOINT_HEAD, JointType::JOINT_NECK, JointType::JOINT_TORSO, JointType::JOINT_WAIST,
+	JointType::JOINT_LEFT_SHOULDER, JointType::JOINT_LEFT_ELBOW, JointType::JOINT_LEFT_WRIST, JointType::JOINT_LEFT_HAND,
+	JointType::JOINT_RIGHT_SHOULDER, JointType::JOINT_RIGHT_ELBOW, JointType::JOINT_RIGHT_WRIST, JointType::JOINT_RIGHT_HAND,
+	JointType::JOINT_LEFT_HIP, JointType::JOINT_LEFT_KNEE, JointType::JOINT_LEFT_ANKLE,
+	JointType::JOINT_RIGHT_HIP, JointType::JOINT_RIGHT_KNEE, JointType::JOINT_RIGHT_ANKLE
+};
+
+void UNuitrackDeviceSubsystem::DecodeUser(int32 UserId, const std::vector<Joint>& joints, FSkeletonFrame& User)
+{
+	User.UserId = UserId;
+	User.Timestamp = FPlatformTime::Seconds();
+	User.bHasJoints = joints.size() > JointType::JOINT_RIGHT_ANKLE;
+	if (!User.bHasJoints)
+		return;
+
+	// Orientation matrices are gathered element by element and converted for all joints together
+	float Matrices[FSkeletonOrientationKernels::MatrixElements][FSkeletonFrame::JointCount];
+	for (int32 ii = 0; ii < FSkeletonFrame::JointCount; ii++) {
+		const Joint& joint = joints[SkeletonFrameJointTypes[ii]];
+		User.Positions[ii] = RealToPosition(FVector(joint.real.x, joint.real.y, joint.real.z));
+		User.Confidences[ii] = joint.confidence;
+		for (int32 Element = 0; Element < FSkeletonOrientationKernels::MatrixElements; Element++)
+			Matrices[Element][ii] = joint.orient.matrix[Element];
+	}
+	User.InvalidOrientations = FSkeletonOrientationKernels::MatricesToQuaternions(Matrices, User);
+}
+
+FQuat UNuitrackDeviceSubsystem::OrientationMatrixToQuaternion(const Orientation& orient)
+{
+	return FSkeletonOrientationKernels::MatrixToQuaternion(orient.matrix);
+}
+
+// Translation from Nuitrack space to Unreal Engine space
+FVector UNuitrackDeviceSubsystem::RealToPosition(FVector real)
+{
+	return FVector(real.X, -real.Z, real.Y) * 0.1f;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Templates/SharedPointer.h"
+#include "SkeletonFrame.h"
+
+#include <vector>
+
+#include "nuitrack/Nuitrack.h"
+#include "nuitrack/modules/SkeletonTracker.h"
+#include "nuitrack/types/Skeleton.h"
+#include "nuitrack/types/SkeletonData.h"
+
+#include "NuitrackDeviceSubsystem.generated.h"
+
+using tdv::nuitrack::SkeletonTracker;
+using tdv::nuitrack::SkeletonData;
+using tdv::nuitrack::Joint;
+using tdv::nuitrack::Orientation;
+
+class FNuitrackPollingThread;
+class FRunnableThread;
+
+/**
+ * One decoded Nuitrack update. It is never modified while anyone outside the subsystem holds
+ * a reference, so every subscriber can keep one on any thread. Released snapshots are
+ * recycled for later updates.
+ */
+struct FNuitrackSkeletonSnapshot
+{
+	// Increases by one for every decoded update
+	uint64 Sequence = 0;
+
+	// One entry per skeleton Nuitrack reported, empty when nobody is tracked
+	TArray<FSkeletonFrame> Users;
+};
+
+typedef TSharedRef<const FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> FNuitrackSnapshotRef;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnNuitrackSnapshot, const FNuitrackSnapshotRef&);
+
+/**
+ * Owns the single Nuitrack session and skeleton tracker of the game instance.
+ * Each update is decoded once and handed to every subscriber as a shared snapshot.
+ */
+UCLASS()
+class TAUSKELETONVISUAL_API UNuitrackDeviceSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// The delegate runs on the thread that decoded the update: the game thread, or the polling thread
+	// once RequestSensorThread was called. No call for a handle is running once Unsubscribe returns.
+	FDelegateHandle Subscribe(FOnNuitrackSnapshot::FDelegate&& Delegate);
+	void Unsubscribe(FDelegateHandle Handle);
+
+	// Moves Nuitrack::update onto a dedicated polling thread for the rest of the session
+	void RequestSensorThread();
+
+	// Runs Nuitrack::update at most once per engine frame while no polling thread is running
+	void PumpGameThread();
+
+	bool IsSensorThreadActive() const { return bSensorThreadActive; }
+
+	// Latest snapshot for consumers that poll instead of subscribing, invalid before the first update
+	TSharedPtr<const FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> GetLatestSnapshot();
+
+	// Snapshots delivered to the subscribers so far
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 DeliveredSnapshots;
+
+	SkeletonTracker::Ptr skeletonTracker;
+
+	static FQuat OrientationMatrixToQuaternion(const Orientation& orient);
+	static FVector RealToPosition(FVector real);
+
+protected:
+	void OnSkeletonUpdate(SkeletonData::Ptr userSkeletons);
+
+	// Fills the frame from Nuitrack's joint array in one pass
+	void DecodeUser(int32 UserId, const std::vector<Joint>& joints, FSkeletonFrame& User);
+
+private:
+	bool bDidInitNuitrack;
+
+	FThreadSafeBool bSensorThreadActive;
+	FNuitrackPollingThread* PollingThread = nullptr;
+	FRunnableThread* CurrentPollingThread = nullptr;
+
+	// How long Deinitialize waits for the polling thread before releasing the session under it
+	static constexpr float PollingThreadJoinSeconds = 1.f;
+
+	uint64 LastPumpedFrame;
+	uint64 SnapshotSequence;
+
+	// Held while delivering, so subscribing and unsubscribing never race a broadcast
+	FCriticalSection SubscribersLock;
+	FOnNuitrackSnapshot OnSnapshot;
+
+	FCriticalSection LatestSnapshotLock;
+	TSharedPtr<const FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> LatestSnapshot;
+
+	// Snapshots decoded so far; one only the pool references is free to decode into again
+	static const int32 MaxPooledSnapshots = 8;
+	TArray<TSharedRef<FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe>> SnapshotPool;
+
+	// Free pooled snapshot, or a new one while the pool has room. Only called by the decoding thread.
+	TSharedRef<FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> AcquireSnapshot();
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NuitrackPollingThread.h"
+#include "NuitrackDeviceSubsystem.h"
+#include "HAL/PlatformProcess.h"
+
+#include <exception>
+
+using tdv::nuitrack::Nuitrack;
+
+FNuitrackPollingThread::FNuitrackPollingThread(UNuitrackDeviceSubsystem* _Subsystem)
+{
+	Tracker = _Subsystem->skeletonTracker;
+	ExitEvent = FPlatformProcess::GetSynchEventFromPool(true);
+}
+
+FNuitrackPollingThread::~FNuitrackPollingThread()
+{
+	FPlatformProcess::ReturnSynchEventToPool(ExitEvent);
+	ExitEvent = nullptr;
+}
+
+bool FNuitrackPollingThread::Init()
+{
+	bStopThread = false;
+	return true;
+}
+
+uint32 FNuitrackPollingThread::Run()
+{
+	while (!bStopThread) {
+		try {
+			Nuitrack::waitUpdate(Tracker);
+		}
+		catch (const std::exception& e) {
+			UE_LOG(LogTemp, Warning, TEXT("Nuitrack::waitUpdate() failed: %s"), UTF8_TO_TCHAR(e.what()));
+			if (!bStopThread) {
+				FPlatformProcess::Sleep(0.1f);
+			}
+		}
+	}
+
+	ExitEvent->Trigger();
+	return 0;
+}
+
+void FNuitrackPollingThread::Stop()
+{
+	bStopThread = true;
+}
+
+bool FNuitrackPollingThread::WaitForExit(float Seconds)
+{
+	return ExitEvent->Wait(FTimespan::FromSeconds(Seconds));
+}
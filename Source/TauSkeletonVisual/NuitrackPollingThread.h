@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/Event.h"
+
+#include "nuitrack/modules/SkeletonTracker.h"
+
+class UNuitrackDeviceSubsystem;
+
+/**
+ * Runs the Nuitrack update loop off the game thread. Nuitrack::waitUpdate blocks until the
+ * skeleton tracker has new data, so the loop runs at the sensor's native rate and the
+ * skeleton callback fires on this thread.
+ */
+class FNuitrackPollingThread : public FRunnable
+{
+public:
+	FNuitrackPollingThread(UNuitrackDeviceSubsystem* _Subsystem);
+	~FNuitrackPollingThread();
+
+	FThreadSafeBool bStopThread;
+
+	virtual bool Init();
+	virtual uint32 Run();
+	virtual void Stop();
+
+	// Waits up to Seconds for Run to return. A pending waitUpdate only returns with the next sensor frame.
+	bool WaitForExit(float Seconds);
+
+private:
+	// Own reference, so the loop never goes back to the subsystem once it is being torn down
+	tdv::nuitrack::SkeletonTracker::Ptr Tracker;
+
+	// Triggered when Run returns
+	FEvent* ExitEvent;
+};
@@ -2,8 +2,15 @@
 
 
 #include "NuitrackSkeletonActor.h"
+#include "TauSkeletonVisual.h"
+#include "TauAllocationAudit.h"
+#include "Misc/ScopeLock.h"
+#include "Engine/Engine.h"
+
+DECLARE_CYCLE_STAT(TEXT("Nuitrack Game Thread"), STAT_NuitrackGameThread, STATGROUP_TauSkeleton);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Quality Tier"), STAT_TauQualityTier, STATGROUP_TauSkeleton);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Smoothed Tau Cost (ms)"), STAT_TauSmoothedCostMs, STATGROUP_TauSkeleton);
 
-using tdv::nuitrack::Nuitrack;
 using tdv::nuitrack::JointType;
 
 // Sets default values
@@ -11,13 +18,31 @@ ANuitrackSkeletonActor::ANuitrackSkeletonActor()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
-	DidInitNuitrack = false;
-}
-
-// Sets default values
-ANuitrackSkeletonActor::~ANuitrackSkeletonActor()
-{
-	Nuitrack::release();
+	bUseSensorThread = false;
+	GameThreadNuitrackMs = 0;
+	MaxTrackedUsers = 6;
+	bUseSharedWorkerPool = false;
+	bEnableFrameBudgetGovernor = false;
+	bEnableFrameBudgetGovernorInVR = true;
+	TauBudgetMs = 4.f;
+	GovernorRestoreFraction = 0.7f;
+	GovernorDegradeFrames = 10;
+	GovernorRestoreFrames = 90;
+	ReducedTriangleCount = 32;
+	ReducedTextureSlices = 2;
+	QualityTier = ETauQualityTier::Full;
+	SmoothedTauCostMs = 0;
+	GovernorOverBudgetFrames = 0;
+	GovernorUnderBudgetFrames = 0;
+	SensorUpdateDivider = 1;
+	SensorUpdateCount = 0;
+	TauStateBlocks = 0;
+	TauStateBytes = 0;
+	bAuditFrameAllocations = false;
+	AuditWarmupFrames = 120;
+	LastFrameAllocations = 0;
+	SteadyStateAllocatingFrames = 0;
+	AuditedFrames = 0;
 }
 
 
@@ -27,29 +52,55 @@ void ANuitrackSkeletonActor::BeginPlay()
 	Super::BeginPlay();
 	UE_LOG(LogTemp, Warning, TEXT("BeginPlay"));
 
+	TauStatePool = MakeShared<FTauStatePool, ESPMode::ThreadSafe>();
+
 	this->JointBuffer = NewObject<UNuitrackSkeletonJointBuffer>(this);
+	JointBuffer->bUseSharedWorkerPool = bUseSharedWorkerPool;
+	JointBuffer->TauStatePool = TauStatePool;
 	JointBuffer->RegisterComponent();
 
-	if (!DidInitNuitrack) {
-		Nuitrack::release();
-		UE_LOG(LogTemp, Warning, TEXT("Nuitrack::init() CALLING..."));
-		Nuitrack::init();
+	AssignedId = -1;
+	ReadyForUpdate = false;
 
-		UE_LOG(LogTemp, Warning, TEXT("SkeletonTracker::create() CALLING..."));
-		skeletonTracker = SkeletonTracker::create();
+	// TauBudgetMs defaults to a share of the 90 Hz frame, so VR keeps its frame rate without further setup
+	if (bEnableFrameBudgetGovernorInVR && !bEnableFrameBudgetGovernor && GEngine && GEngine->IsStereoscopic3D()) {
+		bEnableFrameBudgetGovernor = true;
+		UE_LOG(LogTemp, Display, TEXT("Stereo rendering active, frame budget governor enabled with a %.1f ms tau budget"), TauBudgetMs);
+	}
 
-		UE_LOG(LogTemp, Warning, TEXT(
-			"skeletonTracker->connectOnUpdate() CALLING..."));
-		skeletonTracker->connectOnUpdate(
-			std::bind(&ANuitrackSkeletonActor::OnSkeletonUpdate,
-				this, std::placeholders::_1));
+	if (bAuditFrameAllocations && !FTauAllocationAuditScope::IsAvailable()) {
+		UE_LOG(LogTemp, Warning, TEXT("Frame allocation audit needs -TauAllocationAudit on the command line and a non-shipping build"));
+	}
 
-		UE_LOG(LogTemp, Warning, TEXT("Nuitrack::run() CALLING..."));
-		Nuitrack::run();
-		DidInitNuitrack = true;
+	// The device subsystem owns the Nuitrack session, so any number of actors can share it
+	DeviceSubsystem = GetGameInstance()->GetSubsystem<UNuitrackDeviceSubsystem>();
+	if (DeviceSubsystem) {
+		if (bUseSensorThread) {
+			DeviceSubsystem->RequestSensorThread();
+		}
+		SnapshotSubscription = DeviceSubsystem->Subscribe(FOnNuitrackSnapshot::FDelegate::CreateUObject(this, &ANuitrackSkeletonActor::OnSensorSnapshot));
 	}
-	AssignedId = -1;
-	ReadyForUpdate = false;
+}
+
+void ANuitrackSkeletonActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (DeviceSubsystem) {
+		DeviceSubsystem->Unsubscribe(SnapshotSubscription);
+		SnapshotSubscription.Reset();
+		DeviceSubsystem = nullptr;
+	}
+	// Nothing writes after Unsubscribe, so drop the references all three slots may hold and let the subsystem recycle them
+	for (int32 ii = 0; ii < 3; ii++) {
+		PendingSnapshots.GetWriteBuffer().Reset();
+		PendingSnapshots.SwapWriteBuffers();
+		PendingSnapshots.SwapReadBuffers();
+	}
+	// Buffers still running keep their blocks until they shut down; everything else is freed here
+	if (TauStatePool.IsValid()) {
+		TauStatePool->Trim();
+		TauStatePool.Reset();
+	}
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -57,7 +108,24 @@ void ANuitrackSkeletonActor::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 	LastDeltaTime = DeltaTime;		
-	Nuitrack::update();
+
+	TOptional<FTauAllocationAuditScope> AllocationAudit;
+	if (bAuditFrameAllocations && FTauAllocationAuditScope::IsAvailable()) {
+		AllocationAudit.Emplace();
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_NuitrackGameThread);
+		uint32 StartCycles = FPlatformTime::Cycles();
+		if (DeviceSubsystem) {
+			// Without the polling thread this delivers the snapshot to OnSensorSnapshot right here
+			DeviceSubsystem->PumpGameThread();
+		}
+		ConsumeSensorSnapshot();
+		GameThreadNuitrackMs = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles);
+	}
+
+	UpdateFrameBudget();
 
 	if (ReadyForUpdate && JointBuffer != nullptr) {
 
@@ -66,257 +134,200 @@ void ANuitrackSkeletonActor::Tick(float DeltaTime)
 		SkeletonJointBufferDidUpdate();
 		ReadyForUpdate = false;
 	}
+
+	if (AllocationAudit.IsSet()) {
+		// Once warmed up, the sensor-to-texture path is expected to run out of preallocated buffers
+		LastFrameAllocations = AllocationAudit->GetAllocationCount();
+		AuditedFrames++;
+		if (AuditedFrames > AuditWarmupFrames && LastFrameAllocations > 0) {
+			SteadyStateAllocatingFrames++;
+			if (SteadyStateAllocatingFrames == 1 || SteadyStateAllocatingFrames % 600 == 0) {
+				UE_LOG(LogTemp, Warning, TEXT("Steady-state frame made %i heap allocations (%i allocating frames so far)"), LastFrameAllocations, SteadyStateAllocatingFrames);
+			}
+		}
+	}
 }
 
 
-void ANuitrackSkeletonActor::OnSkeletonUpdate(SkeletonData::Ptr userSkeletons)
+void ANuitrackSkeletonActor::OnSensorSnapshot(const FNuitrackSnapshotRef& Snapshot)
 {
-	auto skeletons = userSkeletons->getSkeletons();
-
-	if (!skeletons.empty())
-	{
-		//UE_LOG(LogTemp, Warning, TEXT("Nuitrack::OnSkeletonUpdate()..."));
-		for (auto skeleton : skeletons)
-		{
-			if (AssignedId == -1) {
-				AssignedId = skeleton.id; // TODO: Detect Unusued IDs;
+	int32 Divider = FMath::Max(1, FPlatformAtomics::AtomicRead(&SensorUpdateDivider));
+	bool bPostCalculations = (SensorUpdateCount++ % Divider) == 0;
+
+	// Users that already have a buffer start calculating right away; new ones are added in Tick.
+	// This can run on the polling thread, so it only posts to workers the game thread already started.
+	if (bPostCalculations) {
+		FScopeLock Lock(&UserJointBuffersLock);
+		for (const FSkeletonFrame& User : Snapshot->Users) {
+			if (UNuitrackSkeletonJointBuffer** UserBuffer = UserJointBuffers.Find(User.UserId)) {
+				(*UserBuffer)->PostCalculationFrame(User);
 			}
+		}
+	}
 
-			//DrawSkeleton(skeleton.id, skeleton.joints);
-			UpdateJointBuffer(skeleton.joints);
-			//UE_LOG(LogTemp, Warning, TEXT("Processing socket raw data for time: %f"), LastDeltaTime);
-			
-			JointBuffer->ProcessSocketRawData(LastDeltaTime);
+	PendingSnapshots.GetWriteBuffer() = Snapshot;
+	PendingSnapshots.SwapWriteBuffers();
+}
+
+void ANuitrackSkeletonActor::ConsumeSensorSnapshot()
+{
+	if (!PendingSnapshots.IsDirty()) {
+		return;
+	}
+	PendingSnapshots.SwapReadBuffers();
+	TSharedPtr<const FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe> Snapshot = MoveTemp(PendingSnapshots.Read());
+	if (!Snapshot.IsValid()) {
+		return;
+	}
+
+	TArray<int32, TInlineAllocator<6>> TrackedUserIds;
+	for (const FSkeletonFrame& User : Snapshot->Users) {
+		TrackedUserIds.Add(User.UserId);
+		bool bNewUser = GetJointBufferForUser(User.UserId) == nullptr;
+		UNuitrackSkeletonJointBuffer* UserBuffer = FindOrAddUserJointBuffer(User.UserId);
+		if (UserBuffer == nullptr) {
+			continue;
 		}
-		if (JointBuffer->SocketBoneNames.Num() == JointBuffer->SocketLocations.Num()) {
-			ReadyForUpdate = true;
+		UserBuffer->UpdateSocketFrame(User);
+		if (bNewUser) {
+			// The snapshot callback skipped this user since it had no buffer yet
+			UserBuffer->PostCalculationFrame(User);
 		}
+		UserBuffer->ProcessSocketRawData(LastDeltaTime);
+	}
+	EvictMissingUsers(TrackedUserIds);
+	TauStateBlocks = TauStatePool->GetBlockCount();
+	TauStateBytes = (int64)TauStatePool->GetAllocatedSize();
+	ReadyForUpdate = true;
+}
+
+UNuitrackSkeletonJointBuffer* ANuitrackSkeletonActor::GetJointBufferForUser(int32 UserId)
+{
+	UNuitrackSkeletonJointBuffer** UserBuffer = UserJointBuffers.Find(UserId);
+	return UserBuffer ? *UserBuffer : nullptr;
+}
+
+UNuitrackSkeletonJointBuffer* ANuitrackSkeletonActor::FindOrAddUserJointBuffer(int32 UserId)
+{
+	if (UNuitrackSkeletonJointBuffer** Existing = UserJointBuffers.Find(UserId)) {
+		return *Existing;
+	}
+	if (UserJointBuffers.Num() >= MaxTrackedUsers || JointBuffer == nullptr) {
+		return nullptr;
+	}
+
+	// The first user takes the Blueprint-facing JointBuffer, everyone else gets a buffer of their own
+	UNuitrackSkeletonJointBuffer* UserBuffer = JointBuffer;
+	if (JointBuffer->UserId == -1) {
+		AssignedId = UserId;
 	}
 	else {
-		ReadyForUpdate = true;
+		UserBuffer = NewObject<UNuitrackSkeletonJointBuffer>(this);
+		UserBuffer->bUseSharedWorkerPool = bUseSharedWorkerPool;
+		UserBuffer->TauStatePool = TauStatePool;
+		UserBuffer->RegisterComponent();
 	}
-}
+	UserBuffer->UserId = UserId;
+	ApplyQualityTier(UserBuffer);
 
+	// The worker is started here, before the sensor callback can find the buffer, so that
+	// callback never creates anything and never touches the buffer's UObject state
+	UserBuffer->StartCalculations();
 
-/**
- * @ingroup SkeletonTracker_group
- * @brief Joint index meaning (please note that <i>JOINT_LEFT_FINGERTIP, JOINT_RIGHT_FINGERTIP, JOINT_LEFT_FOOT, JOINT_RIGHT_FOOT</i> are not used in the current version).
+	FScopeLock Lock(&UserJointBuffersLock);
+	UserJointBuffers.Add(UserId, UserBuffer);
+	return UserBuffer;
+}
 
-enum NT_JOINT
+void ANuitrackSkeletonActor::EvictMissingUsers(const TArray<int32, TInlineAllocator<6>>& TrackedUserIds)
 {
-	JOINT_NONE = 0, ///< Reserved joint (unused).
-
-	JOINT_HEAD = 1, ///< Head
-	JOINT_NECK = 2, ///< Neck
-	JOINT_TORSO = 3, ///< Torso
-	JOINT_WAIST = 4, ///< Waist
-
-	JOINT_LEFT_COLLAR = 5, ///< Left collar
-	JOINT_LEFT_SHOULDER = 6, ///< Left shoulder
-	JOINT_LEFT_ELBOW = 7, ///< Left elbow
-	JOINT_LEFT_WRIST = 8, ///< Left wrist
-	JOINT_LEFT_HAND = 9, ///< Left hand
-	JOINT_LEFT_FINGERTIP = 10, ///< Left fingertip (<b>not used in the current version</b>).
-
-	JOINT_RIGHT_COLLAR = 11, ///< Right collar
-	JOINT_RIGHT_SHOULDER = 12, ///< Right shoulder
-	JOINT_RIGHT_ELBOW = 13, ///< Right elbow
-	JOINT_RIGHT_WRIST = 14, ///< Right wrist
-	JOINT_RIGHT_HAND = 15, ///< Right hand
-	JOINT_RIGHT_FINGERTIP = 16, ///< Right fingertip (<b>not used in the current version</b>).
-
-	JOINT_LEFT_HIP = 17, ///< Left hip
-	JOINT_LEFT_KNEE = 18, ///< Left knee
-	JOINT_LEFT_ANKLE = 19, ///< Left ankle
-	JOINT_LEFT_FOOT = 20, ///< Left foot (<b>not used in the current version</b>).
-
-	JOINT_RIGHT_HIP = 21, ///< Right hip
-	JOINT_RIGHT_KNEE = 22, ///< Right knee
-	JOINT_RIGHT_ANKLE = 23, ///< Right ankle
-	JOINT_RIGHT_FOOT = 24 ///< Right foot (<b>not used in the current version</b>).
-};
- */
-
-void ANuitrackSkeletonActor::UpdateJointBuffer(std::vector<Joint> joints)
+	// Only the game thread changes the map, so it can look for lost users without the lock
+	bool bAnyLost = false;
+	for (const TPair<int32, UNuitrackSkeletonJointBuffer*>& User : UserJointBuffers) {
+		bAnyLost |= !TrackedUserIds.Contains(User.Key);
+	}
+	if (!bAnyLost) {
+		return;
+	}
+
+	TArray<UNuitrackSkeletonJointBuffer*, TInlineAllocator<6>> Evicted;
+	{
+		FScopeLock Lock(&UserJointBuffersLock);
+		for (auto It = UserJointBuffers.CreateIterator(); It; ++It) {
+			if (!TrackedUserIds.Contains(It.Key())) {
+				Evicted.Add(It.Value());
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	for (UNuitrackSkeletonJointBuffer* UserBuffer : Evicted) {
+		UE_LOG(LogTemp, Display, TEXT("User %i lost, releasing its joint buffer"), UserBuffer->UserId);
+		if (UserBuffer == JointBuffer) {
+			// Keep the Blueprint-facing buffer around for the next user, but drop this user's tau state
+			UserBuffer->ShutdownCalculations();
+			UserBuffer->UserId = -1;
+			AssignedId = -1;
+		}
+		else {
+			UserBuffer->DestroyComponent();
+		}
+	}
+}
+
+
+void ANuitrackSkeletonActor::UpdateFrameBudget()
 {
-	if (joints.empty())
+	if (!bEnableFrameBudgetGovernor) {
 		return;
+	}
 
-	FName headName = FName(TEXT("Head"));
-	FName neckName = FName(TEXT("Neck"));
-	FName torsoName = FName(TEXT("Torso"));
-	FName waistName = FName(TEXT("Waist"));
-	//FName leftCollarName = FName(TEXT("LeftCollar"));
-	FName leftShoulderName = FName(TEXT("LeftShoulder"));
-	FName leftElbowName = FName(TEXT("LeftElbow"));
-	FName leftWristName = FName(TEXT("LeftWrist"));
-	FName leftHandName = FName(TEXT("LeftHand"));
-	//FName rightCollarName = FName(TEXT("RightCollar"));
-	FName rightShoulderName = FName(TEXT("RightShoulder"));
-	FName rightElbowName = FName(TEXT("RightElbow"));
-	FName rightWristName = FName(TEXT("RightWrist"));
-	FName rightHandName = FName(TEXT("RightHand"));
-	FName leftHipName = FName(TEXT("LeftHip"));
-	FName leftKneeName = FName(TEXT("LeftKnee"));
-	FName leftAnkleName = FName(TEXT("LeftAnkle"));
-	FName rightHipName = FName(TEXT("RightHip"));
-	FName rightKneeName = FName(TEXT("RightKnee"));
-	FName rightAnkleName = FName(TEXT("RightAnkle"));
-
-	FVector headProjectedPosition = FVector(joints[JointType::JOINT_HEAD].proj.x, joints[JointType::JOINT_HEAD].proj.y, joints[JointType::JOINT_HEAD].proj.z);
-	FVector neckProjectedPosition = FVector(joints[JointType::JOINT_NECK].proj.x, joints[JointType::JOINT_NECK].proj.y, joints[JointType::JOINT_NECK].proj.z);
-	FVector torsoProjectedPosition = FVector(joints[JointType::JOINT_TORSO].proj.x, joints[JointType::JOINT_TORSO].proj.y, joints[JointType::JOINT_TORSO].proj.z);
-	FVector waistProjectedPosition = FVector(joints[JointType::JOINT_WAIST].proj.x, joints[JointType::JOINT_WAIST].proj.y, joints[JointType::JOINT_WAIST].proj.z);
-	FVector leftShoulderProjectedPosition = FVector(joints[JointType::JOINT_LEFT_SHOULDER].proj.x, joints[JointType::JOINT_LEFT_SHOULDER].proj.y, joints[JointType::JOINT_LEFT_SHOULDER].proj.z);
-	FVector leftElbowProjectedPosition = FVector(joints[JointType::JOINT_LEFT_ELBOW].proj.x, joints[JointType::JOINT_LEFT_ELBOW].proj.y, joints[JointType::JOINT_LEFT_ELBOW].proj.z);
-	FVector leftWristProjectedPosition = FVector(joints[JointType::JOINT_LEFT_WRIST].proj.x, joints[JointType::JOINT_LEFT_WRIST].proj.y, joints[JointType::JOINT_LEFT_WRIST].proj.z);
-	FVector leftHandProjectedPosition = FVector(joints[JointType::JOINT_LEFT_HAND].proj.x, joints[JointType::JOINT_LEFT_HAND].proj.y, joints[JointType::JOINT_LEFT_HAND].proj.z);
-	FVector rightShoulderProjectedPosition = FVector(joints[JointType::JOINT_RIGHT_SHOULDER].proj.x, joints[JointType::JOINT_RIGHT_SHOULDER].proj.y, joints[JointType::JOINT_RIGHT_SHOULDER].proj.z);
-	FVector rightElbowProjectedPosition = FVector(joints[JointType::JOINT_RIGHT_ELBOW].proj.x, joints[JointType::JOINT_RIGHT_ELBOW].proj.y, joints[JointType::JOINT_RIGHT_ELBOW].proj.z);
-	FVector rightWristProjectedPosition = FVector(joints[JointType::JOINT_RIGHT_WRIST].proj.x, joints[JointType::JOINT_RIGHT_WRIST].proj.y, joints[JointType::JOINT_RIGHT_WRIST].proj.z);
-	FVector rightHandProjectedPosition = FVector(joints[JointType::JOINT_RIGHT_HAND].proj.x, joints[JointType::JOINT_RIGHT_HAND].proj.y, joints[JointType::JOINT_RIGHT_HAND].proj.z);
-	FVector leftHipProjectedPosition = FVector(joints[JointType::JOINT_LEFT_HIP].proj.x, joints[JointType::JOINT_LEFT_HIP].proj.y, joints[JointType::JOINT_LEFT_HIP].proj.z);
-	FVector leftKneeProjectedPosition = FVector(joints[JointType::JOINT_LEFT_KNEE].proj.x, joints[JointType::JOINT_LEFT_KNEE].proj.y, joints[JointType::JOINT_LEFT_KNEE].proj.z);
-	FVector leftAnkleProjectedPosition = FVector(joints[JointType::JOINT_LEFT_ANKLE].proj.x, joints[JointType::JOINT_LEFT_ANKLE].proj.y, joints[JointType::JOINT_LEFT_ANKLE].proj.z);
-	FVector rightHipProjectedPosition = FVector(joints[JointType::JOINT_RIGHT_HIP].proj.x, joints[JointType::JOINT_RIGHT_HIP].proj.y, joints[JointType::JOINT_RIGHT_HIP].proj.z);
-	FVector rightKneeProjectedPosition = FVector(joints[JointType::JOINT_RIGHT_KNEE].proj.x, joints[JointType::JOINT_RIGHT_KNEE].proj.y, joints[JointType::JOINT_RIGHT_KNEE].proj.z);
-	FVector rightAnkleProjectedPosition = FVector(joints[JointType::JOINT_RIGHT_ANKLE].proj.x, joints[JointType::JOINT_RIGHT_ANKLE].proj.y, joints[JointType::JOINT_RIGHT_ANKLE].proj.z);
-
-	FVector headRealPosition = FVector(joints[JointType::JOINT_HEAD].real.x, joints[JointType::JOINT_HEAD].real.y, joints[JointType::JOINT_HEAD].real.z);
-	FVector neckRealPosition = FVector(joints[JointType::JOINT_NECK].real.x, joints[JointType::JOINT_NECK].real.y, joints[JointType::JOINT_NECK].real.z);
-	FVector torsoRealPosition = FVector(joints[JointType::JOINT_TORSO].real.x, joints[JointType::JOINT_TORSO].real.y, joints[JointType::JOINT_TORSO].real.z);
-	FVector waistRealPosition = FVector(joints[JointType::JOINT_WAIST].real.x, joints[JointType::JOINT_WAIST].real.y, joints[JointType::JOINT_WAIST].real.z);
-	FVector leftShoulderRealPosition = FVector(joints[JointType::JOINT_LEFT_SHOULDER].real.x, joints[JointType::JOINT_LEFT_SHOULDER].real.y, joints[JointType::JOINT_LEFT_SHOULDER].real.z);
-	FVector leftElbowRealPosition = FVector(joints[JointType::JOINT_LEFT_ELBOW].real.x, joints[JointType::JOINT_LEFT_ELBOW].real.y, joints[JointType::JOINT_LEFT_ELBOW].real.z);
-	FVector leftWristRealPosition = FVector(joints[JointType::JOINT_LEFT_WRIST].real.x, joints[JointType::JOINT_LEFT_WRIST].real.y, joints[JointType::JOINT_LEFT_WRIST].real.z);
-	FVector leftHandRealPosition = FVector(joints[JointType::JOINT_LEFT_HAND].real.x, joints[JointType::JOINT_LEFT_HAND].real.y, joints[JointType::JOINT_LEFT_HAND].real.z);
-	FVector rightShoulderRealPosition = FVector(joints[JointType::JOINT_RIGHT_SHOULDER].real.x, joints[JointType::JOINT_RIGHT_SHOULDER].real.y, joints[JointType::JOINT_RIGHT_SHOULDER].real.z);
-	FVector rightElbowRealPosition = FVector(joints[JointType::JOINT_RIGHT_ELBOW].real.x, joints[JointType::JOINT_RIGHT_ELBOW].real.y, joints[JointType::JOINT_RIGHT_ELBOW].real.z);
-	FVector rightWristRealPosition = FVector(joints[JointType::JOINT_RIGHT_WRIST].real.x, joints[JointType::JOINT_RIGHT_WRIST].real.y, joints[JointType::JOINT_RIGHT_WRIST].real.z);
-	FVector rightHandRealPosition = FVector(joints[JointType::JOINT_RIGHT_HAND].real.x, joints[JointType::JOINT_RIGHT_HAND].real.y, joints[JointType::JOINT_RIGHT_HAND].real.z);
-	FVector leftHipRealPosition = FVector(joints[JointType::JOINT_LEFT_HIP].real.x, joints[JointType::JOINT_LEFT_HIP].real.y, joints[JointType::JOINT_LEFT_HIP].real.z);
-	FVector leftKneeRealPosition = FVector(joints[JointType::JOINT_LEFT_KNEE].real.x, joints[JointType::JOINT_LEFT_KNEE].real.y, joints[JointType::JOINT_LEFT_KNEE].real.z);
-	FVector leftAnkleRealPosition = FVector(joints[JointType::JOINT_LEFT_ANKLE].real.x, joints[JointType::JOINT_LEFT_ANKLE].real.y, joints[JointType::JOINT_LEFT_ANKLE].real.z);
-	FVector rightHipRealPosition = FVector(joints[JointType::JOINT_RIGHT_HIP].real.x, joints[JointType::JOINT_RIGHT_HIP].real.y, joints[JointType::JOINT_RIGHT_HIP].real.z);
-	FVector rightKneeRealPosition = FVector(joints[JointType::JOINT_RIGHT_KNEE].real.x, joints[JointType::JOINT_RIGHT_KNEE].real.y, joints[JointType::JOINT_RIGHT_KNEE].real.z);
-	FVector rightAnkleRealPosition = FVector(joints[JointType::JOINT_RIGHT_ANKLE].real.x, joints[JointType::JOINT_RIGHT_ANKLE].real.y, joints[JointType::JOINT_RIGHT_ANKLE].real.z);
-
-	FTransform headOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_HEAD].orient));
-	FTransform neckOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_NECK].orient));
-	FTransform torsoOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_TORSO].orient));
-	FTransform waistOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_WAIST].orient));
-	FTransform leftShoulderOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_LEFT_SHOULDER].orient));
-	FTransform leftElbowOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_LEFT_ELBOW].orient));
-	FTransform leftWristOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_LEFT_WRIST].orient));
-	FTransform leftHandOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_LEFT_HAND].orient));
-	FTransform rightShoulderOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_RIGHT_SHOULDER].orient));
-	FTransform rightElbowOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_RIGHT_ELBOW].orient));
-	FTransform rightWristOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_RIGHT_WRIST].orient));
-	FTransform rightHandOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_RIGHT_HAND].orient));
-	FTransform leftHipOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_LEFT_HIP].orient));
-	FTransform leftKneeOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_LEFT_KNEE].orient));
-	FTransform leftAnkleOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_LEFT_ANKLE].orient));
-	FTransform rightHipOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_RIGHT_HIP].orient));
-	FTransform rightKneeOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_RIGHT_KNEE].orient));
-	FTransform rightAnkleOrientationTransform = FTransform(OrientationMatrixToQuaternion(joints[JointType::JOINT_RIGHT_ANKLE].orient));
-
-
-	TArray<FName> SocketNames;
-	SocketNames.Init(headName, 1);
-	SocketNames.Emplace(neckName);
-	SocketNames.Emplace(torsoName);
-	SocketNames.Emplace(waistName);
-	//BoneNames.Emplace(leftCollarName);
-	SocketNames.Emplace(leftShoulderName);
-	SocketNames.Emplace(leftElbowName);
-	SocketNames.Emplace(leftWristName);
-	SocketNames.Emplace(leftHandName);
-	//BoneNames.Emplace(rightCollarName);
-	SocketNames.Emplace(rightShoulderName);
-	SocketNames.Emplace(rightElbowName);
-	SocketNames.Emplace(rightWristName);
-	SocketNames.Emplace(rightHandName);
-	SocketNames.Emplace(leftHipName);
-	SocketNames.Emplace(leftKneeName);
-	SocketNames.Emplace(leftAnkleName);
-	SocketNames.Emplace(rightHipName);
-	SocketNames.Emplace(rightKneeName);
-	SocketNames.Emplace(rightAnkleName);
-
-	TArray<FVector> SocketLocations;
-	SocketLocations.Init(RealToPosition(headRealPosition), 1);
-	SocketLocations.Emplace(RealToPosition(neckRealPosition));
-	SocketLocations.Emplace(RealToPosition(torsoRealPosition));
-	SocketLocations.Emplace(RealToPosition(waistRealPosition));
-	SocketLocations.Emplace(RealToPosition(leftShoulderRealPosition));
-	SocketLocations.Emplace(RealToPosition(leftElbowRealPosition));
-	SocketLocations.Emplace(RealToPosition(leftWristRealPosition));
-	SocketLocations.Emplace(RealToPosition(leftHandRealPosition));
-	SocketLocations.Emplace(RealToPosition(rightShoulderRealPosition));
-	SocketLocations.Emplace(RealToPosition(rightElbowRealPosition));
-	SocketLocations.Emplace(RealToPosition(rightWristRealPosition));
-	SocketLocations.Emplace(RealToPosition(rightHandRealPosition));
-	SocketLocations.Emplace(RealToPosition(leftHipRealPosition));
-	SocketLocations.Emplace(RealToPosition(leftKneeRealPosition));
-	SocketLocations.Emplace(RealToPosition(leftAnkleRealPosition));
-	SocketLocations.Emplace(RealToPosition(rightHipRealPosition));
-	SocketLocations.Emplace(RealToPosition(rightKneeRealPosition));
-	SocketLocations.Emplace(RealToPosition(rightAnkleRealPosition));
-
-	TArray<FRotator> SocketRotations;
-	SocketRotations.Init(headOrientationTransform.Rotator(), 1);
-	SocketRotations.Emplace(neckOrientationTransform.Rotator());
-	SocketRotations.Emplace(torsoOrientationTransform.Rotator());
-	SocketRotations.Emplace(waistOrientationTransform.Rotator());
-	SocketRotations.Emplace(leftShoulderOrientationTransform.Rotator());
-	SocketRotations.Emplace(leftElbowOrientationTransform.Rotator());
-	SocketRotations.Emplace(leftWristOrientationTransform.Rotator());
-	SocketRotations.Emplace(leftHandOrientationTransform.Rotator());
-	SocketRotations.Emplace(rightShoulderOrientationTransform.Rotator());
-	SocketRotations.Emplace(rightElbowOrientationTransform.Rotator());
-	SocketRotations.Emplace(rightWristOrientationTransform.Rotator());
-	SocketRotations.Emplace(rightHandOrientationTransform.Rotator());
-	SocketRotations.Emplace(leftHipOrientationTransform.Rotator());
-	SocketRotations.Emplace(leftKneeOrientationTransform.Rotator());
-	SocketRotations.Emplace(leftAnkleOrientationTransform.Rotator());
-	SocketRotations.Emplace(rightHipOrientationTransform.Rotator());
-	SocketRotations.Emplace(rightKneeOrientationTransform.Rotator());
-	SocketRotations.Emplace(rightAnkleOrientationTransform.Rotator());
-
-	TArray<float> SocketConfidences;
-	SocketConfidences.Init(joints[JointType::JOINT_HEAD].confidence, 1);
-	SocketConfidences.Emplace(joints[JointType::JOINT_NECK].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_TORSO].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_WAIST].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_LEFT_SHOULDER].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_LEFT_ELBOW].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_LEFT_WRIST].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_LEFT_HAND].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_RIGHT_SHOULDER].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_RIGHT_ELBOW].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_RIGHT_WRIST].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_RIGHT_HAND].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_LEFT_HIP].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_LEFT_KNEE].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_LEFT_ANKLE].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_RIGHT_HIP].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_RIGHT_KNEE].confidence);
-	SocketConfidences.Emplace(joints[JointType::JOINT_RIGHT_ANKLE].confidence);
-
-	if (SocketNames.Num() != SocketLocations.Num()) {
-		UE_LOG(LogTemp, Warning, TEXT("Warning: Check socket locations size"));
+	// Worker time counts once per posted frame, so spread it over the sensor updates the rate divider skips
+	int32 Divider = FMath::Max(1, FPlatformAtomics::AtomicRead(&SensorUpdateDivider));
+	float CostMs = GameThreadNuitrackMs;
+	for (const TPair<int32, UNuitrackSkeletonJointBuffer*>& User : UserJointBuffers) {
+		CostMs += User.Value->LastComputeMs / Divider + User.Value->LastTextureUpdateMs;
 	}
-	else if (SocketNames.Num() != SocketRotations.Num()) {
-		UE_LOG(LogTemp, Warning, TEXT("Warning: Check socket rotations size"));
+
+	FrameBudgetGovernor.BudgetMs = TauBudgetMs;
+	FrameBudgetGovernor.RestoreFraction = GovernorRestoreFraction;
+	FrameBudgetGovernor.DegradeFrames = GovernorDegradeFrames;
+	FrameBudgetGovernor.RestoreFrames = GovernorRestoreFrames;
+	bool bTierChanged = FrameBudgetGovernor.Update(CostMs);
+
+	SmoothedTauCostMs = FrameBudgetGovernor.GetSmoothedCostMs();
+	GovernorOverBudgetFrames = FrameBudgetGovernor.GetOverBudgetFrames();
+	GovernorUnderBudgetFrames = FrameBudgetGovernor.GetUnderBudgetFrames();
+	SET_DWORD_STAT(STAT_TauQualityTier, (uint32)FrameBudgetGovernor.GetTier());
+	SET_FLOAT_STAT(STAT_TauSmoothedCostMs, SmoothedTauCostMs);
+
+	if (!bTierChanged) {
+		return;
 	}
-	else if (SocketNames.Num() != SocketConfidences.Num()) {
-		UE_LOG(LogTemp, Warning, TEXT("Warning: Check socket confidences size"));
+
+	ETauQualityTier PreviousTier = QualityTier;
+	QualityTier = FrameBudgetGovernor.GetTier();
+	UE_LOG(LogTemp, Display, TEXT("Frame budget governor: %s -> %s (%.2f ms of %.2f ms)"),
+		*UEnum::GetValueAsString(PreviousTier), *UEnum::GetValueAsString(QualityTier), SmoothedTauCostMs, TauBudgetMs);
+
+	FPlatformAtomics::InterlockedExchange(&SensorUpdateDivider, QualityTier >= ETauQualityTier::ReducedRate ? 2 : 1);
+	for (const TPair<int32, UNuitrackSkeletonJointBuffer*>& User : UserJointBuffers) {
+		ApplyQualityTier(User.Value);
 	}
+}
 
-	JointBuffer->UpdateSocketRawData(SocketNames, SocketLocations, SocketRotations, SocketConfidences);
-	JointBuffer->InitCalculations(SocketNames, SocketLocations, SocketRotations, SocketConfidences, JointBuffer->TriangleTauBuffers);
+void ANuitrackSkeletonActor::ApplyQualityTier(UNuitrackSkeletonJointBuffer* UserBuffer)
+{
+	if (!bEnableFrameBudgetGovernor) {
+		return;
+	}
+	UserBuffer->TrackedTriangleCount = QualityTier >= ETauQualityTier::ReducedTriangles ? ReducedTriangleCount : 0;
+	UserBuffer->TextureSlicesPerUpdate = QualityTier >= ETauQualityTier::ReducedSlices ? ReducedTextureSlices : 8;
+	UserBuffer->bUpdateDebugGeometry = QualityTier < ETauQualityTier::NoDebugGeometry;
+	UserBuffer->PushCalculationSettings();
 }
 
+
 void ANuitrackSkeletonActor::DrawSkeleton(int skeleton_index, std::vector<Joint> joints)
 {
 	if (joints.empty())
@@ -344,16 +355,16 @@ void ANuitrackSkeletonActor::DrawBone(Joint j1, Joint j2)
 	for (int i = 0; i < 9; i++) {
 		UE_LOG(LogTemp, Warning, TEXT("Joint 1 orientation matrix: %i\t%f"), i, j1.orient.matrix[i]);
 	}
-	FTransform j1OrientationTransform = FTransform(OrientationMatrixToQuaternion(j1.orient));
-	UE_LOG(LogTemp, Warning, TEXT("Joint 1 roll: %f\tpitch %f\tyaw: %f"), j1OrientationTransform.Rotator().Roll, j1OrientationTransform.Rotator().Pitch, j1OrientationTransform.Rotator().Yaw);
+	const FRotator j1Rotator = UNuitrackDeviceSubsystem::OrientationMatrixToQuaternion(j1.orient).Rotator();
+	UE_LOG(LogTemp, Warning, TEXT("Joint 1 roll: %f\tpitch %f\tyaw: %f"), j1Rotator.Roll, j1Rotator.Pitch, j1Rotator.Yaw);
 
 	UE_LOG(LogTemp, Warning, TEXT("Joint 2 position: x: %f y:%f z:%f"), j2.proj.x, j2.proj.y, j2.proj.z);
 	for (int i = 0; i < 9; i++) {
 		UE_LOG(LogTemp, Warning, TEXT("Joint 2 orientation matrix: %i\t%f"), i, j2.orient.matrix[i]);
 	}
 
-	FTransform j2OrientationTransform = FTransform(OrientationMatrixToQuaternion(j2.orient));
-	UE_LOG(LogTemp, Warning, TEXT("Joint roll: % f\tpitch % f\tyaw: % f"), j2OrientationTransform.Rotator().Roll, j2OrientationTransform.Rotator().Pitch, j2OrientationTransform.Rotator().Yaw);
+	const FRotator j2Rotator = UNuitrackDeviceSubsystem::OrientationMatrixToQuaternion(j2.orient).Rotator();
+	UE_LOG(LogTemp, Warning, TEXT("Joint roll: % f\tpitch % f\tyaw: % f"), j2Rotator.Roll, j2Rotator.Pitch, j2Rotator.Yaw);
 
 	/*
 	DrawDebugLine(World, RealToPosition(j1.real), RealToPosition(j2.real),
@@ -361,60 +372,3 @@ void ANuitrackSkeletonActor::DrawBone(Joint j1, Joint j2)
 		true, -1, 0, 4);
 		*/
 }
-
-FQuat ANuitrackSkeletonActor::OrientationMatrixToQuaternion(Orientation orient) {
-	// http://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/index.htm
-
-	float x1 = orient.matrix[0]; //m00
-	float x2 = orient.matrix[1]; //m10
-	float x3 = orient.matrix[3]; //m20
-	float y1 = orient.matrix[4]; //m01
-	float y2 = orient.matrix[5]; //m11
-	float y3 = orient.matrix[6]; //m21
-	float z1 = orient.matrix[7]; //m02
-	float z2 = orient.matrix[8]; //m12
-	float z3 = orient.matrix[9]; //m22
-
-	float tr = x1 + y2 + z3;
-	float qw = 0;
-	float qx = 0;
-	float qy = 0;
-	float qz = 0;
-
-	if (tr > 0) {
-		float S = sqrt(tr + 1) * 2; //S = 4 * qw
-		qw = 0.25 * S;
-		qx = (y3 - z2) / S;
-		qy = (z1 - x3) / S;
-		qz = (x2 - y1) / S;
-	}
-	else if (x1 > y2 && x1 > z3) {
-		float S = sqrt(1.0 + x1 - y2 - z3) * 2;
-		qw = (y3 - z2);
-		qx = 0.25 * S;
-		qy = (y1 + x2) / S;
-		qz = (z1 + x3) / S;
-	}
-	else if (y2 > z3) {
-		float S = sqrt(1.0 + y2 - x1 - z3) * 2;
-		qw = (z2 - x3) / S;
-		qx = (y1 + x2) / S;
-		qy = 0.25 * S;
-		qz = (z2 + y3) / S;
-	}
-	else {
-		float S = sqrt(1.0 + z3 - x1 - y2) * 2;
-		qw = (x2 - y1) / S;
-		qx = (z1 + x3) / S;
-		qy = (z2 + y3) / S;
-		qz = 0.25 * S;
-	}
-
-	return FQuat(qx, qy, qz, qw);
-}
-
-// Translation from Nuitrack space to Unreal Engine space
-FVector ANuitrackSkeletonActor::RealToPosition(FVector real)
-{
-	return FVector(real.X, -real.Z, real.Y) * 0.1f;
-}
\ No newline at end of file
@@ -4,23 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Containers/TripleBuffer.h"
 #include "NuitrackSkeletonJointBuffer.h"
+#include "NuitrackDeviceSubsystem.h"
+#include "TauFrameBudgetGovernor.h"
 
 #include <iostream>
 #include <vector>
 
-#include "nuitrack/Nuitrack.h"
-#include "nuitrack/modules/SkeletonTracker.h"
-#include "nuitrack/types/Skeleton.h"
-#include "nuitrack/types/SkeletonData.h"
-
 #include "NuitrackSkeletonActor.generated.h"
 
 using tdv::nuitrack::Skeleton;
-using tdv::nuitrack::SkeletonTracker;
-using tdv::nuitrack::SkeletonData;
-using tdv::nuitrack::Joint;
-using tdv::nuitrack::Orientation;
 using tdv::nuitrack::Vector3;
 
 
@@ -32,33 +26,152 @@ class TAUSKELETONVISUAL_API ANuitrackSkeletonActor : public AActor
 public:	
 	// Sets default values for this actor's properties
 	ANuitrackSkeletonActor();
-	~ANuitrackSkeletonActor();
-
-	SkeletonTracker::Ptr skeletonTracker;
 
 	int AssignedId;
 	float LastDeltaTime;
 	bool ReadyForUpdate;
-	bool DidInitNuitrack;
 
+	// Asks the device subsystem to run Nuitrack::update and skeleton decoding on a dedicated thread instead of in Tick
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bUseSensorThread;
+
+	// Game thread time spent on the Nuitrack path in the last Tick
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float GameThreadNuitrackMs;
+
+	UPROPERTY()
+		UNuitrackDeviceSubsystem* DeviceSubsystem;
+
+	FDelegateHandle SnapshotSubscription;
+
+	// Newest snapshot not yet consumed in Tick. Written only by the thread that delivers snapshots and read
+	// only by Tick, so handing one over is a lock-free buffer swap on each side.
+	TTripleBuffer<TSharedPtr<const FNuitrackSkeletonSnapshot, ESPMode::ThreadSafe>> PendingSnapshots;
 
-	void OnSkeletonUpdate(SkeletonData::Ptr userSkeletons);
+	void OnSensorSnapshot(const FNuitrackSnapshotRef& Snapshot);
 	void DrawSkeleton(int skeleton_index, std::vector<Joint> joints);
 	void DrawBone(Joint j1, Joint j2);
-	void UpdateJointBuffer(std::vector<Joint> joints);
-
-	static FQuat OrientationMatrixToQuaternion(Orientation orient);
-	static FVector RealToPosition(FVector real);
 
+	// Joint buffer of the first tracked user (AssignedId)
 	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
 	UNuitrackSkeletonJointBuffer* JointBuffer;
 
+	// One joint buffer per tracked Nuitrack skeleton id, each with its own tau state and textures
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	TMap<int32, UNuitrackSkeletonJointBuffer*> UserJointBuffers;
+
+	// Nuitrack tracks at most six users
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1", ClampMax = "6"))
+		int32 MaxTrackedUsers;
+
+	// Run every user's calculations on the shared task graph workers instead of one thread per user
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bUseSharedWorkerPool;
+
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		UNuitrackSkeletonJointBuffer* GetJointBufferForUser(int32 UserId);
+
+	// Guards UserJointBuffers against the snapshot callback while the game thread adds or evicts users
+	FCriticalSection UserJointBuffersLock;
+
+	// Tau state of every user's joint buffer. Blocks of lost users are recycled for new ones and freed in EndPlay.
+	FTauStatePoolPtr TauStatePool;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 TauStateBlocks;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int64 TauStateBytes;
+
 	UFUNCTION(BlueprintImplementableEvent, Category = "NuitrackSkeletonJointBuffer")
 		void SkeletonJointBufferDidUpdate();
 
+	// Scale the tau work back when it runs over TauBudgetMs, and restore it once there is headroom.
+	// Off by default. While enabled the governor owns TrackedTriangleCount, TextureSlicesPerUpdate and bUpdateDebugGeometry on every joint buffer.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bEnableFrameBudgetGovernor;
+
+	// Turns the governor on in BeginPlay when the game renders in stereo, where the whole frame is 11.1 ms
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bEnableFrameBudgetGovernorInVR;
+
+	// Share of the frame the tau pipeline and texture updates may use, out of 11.1 ms in VR
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "0.1"))
+		float TauBudgetMs;
+
+	// Restore a tier only while the cost stays below this fraction of TauBudgetMs
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "0", ClampMax = "1"))
+		float GovernorRestoreFraction;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1"))
+		int32 GovernorDegradeFrames;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1"))
+		int32 GovernorRestoreFrames;
+
+	// Triangles tracked from ReducedTriangles on
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1"))
+		int32 ReducedTriangleCount;
+
+	// Texture slices rebuilt per update from ReducedSlices on
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1", ClampMax = "8"))
+		int32 ReducedTextureSlices;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		ETauQualityTier QualityTier;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float SmoothedTauCostMs;
+
+	// Hysteresis counters: consecutive frames spent over budget and with headroom
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 GovernorOverBudgetFrames;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 GovernorUnderBudgetFrames;
+
+	FTauFrameBudgetGovernor FrameBudgetGovernor;
+
+	// Counts heap allocations made by the game thread part of each Tick. A runtime diagnostic only; the
+	// TauSkeletonVisual.SteadyStateAllocations automation test covers the worker side as well.
+	// Needs -TauAllocationAudit on the command line, and is not available in shipping builds.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bAuditFrameAllocations;
+
+	// Ticks allowed to allocate while buffers, pools and textures warm up
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "0"))
+		int32 AuditWarmupFrames;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 LastFrameAllocations;
+
+	// Ticks after the warm-up that allocated at least once
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 SteadyStateAllocatingFrames;
+
+	int32 AuditedFrames;
+
+	// Tau is posted on one out of this many sensor updates. Written on the game thread, read by the snapshot callback.
+	volatile int32 SensorUpdateDivider;
+	uint32 SensorUpdateCount;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;	
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void ConsumeSensorSnapshot();
+
+	// Game thread only. Returns nullptr once MaxTrackedUsers buffers exist.
+	UNuitrackSkeletonJointBuffer* FindOrAddUserJointBuffer(int32 UserId);
+
+	// Game thread only. Releases the buffers of users that are no longer reported by Nuitrack.
+	void EvictMissingUsers(const TArray<int32, TInlineAllocator<6>>& TrackedUserIds);
+
+	// Feeds this frame's tau cost to the governor and applies the tier it settles on
+	void UpdateFrameBudget();
+
+	void ApplyQualityTier(UNuitrackSkeletonJointBuffer* UserBuffer);
 
 public:	
 	// Called every frame
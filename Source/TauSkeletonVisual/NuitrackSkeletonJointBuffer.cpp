@@ -22,6 +22,15 @@
 #include "Math/Vector.h"
 #include "DynamicTexture.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "TauSkeletonVisual.h"
+#include "TriangleTopology.h"
+#include "Misc/ScopeExit.h"
+#include "TauGestureKernels.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frames Produced"), STAT_TauFramesProduced, STATGROUP_TauSkeleton);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frames Consumed"), STAT_TauFramesConsumed, STATGROUP_TauSkeleton);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frames Coalesced"), STAT_TauFramesCoalesced, STATGROUP_TauSkeleton);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frames Dropped"), STAT_TauFramesDropped, STATGROUP_TauSkeleton);
 
 // Classes below from circumcenter.cpp in MeshKit   https://bitbucket.org/fathomteam/meshkit.git
 #include <stdlib.h>
@@ -132,6 +141,48 @@ UNuitrackSkeletonJointBuffer::UNuitrackSkeletonJointBuffer()
 {
 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryComponentTick.bCanEverTick = true;
+	CalculationThreadCreations = 0;
+	LastWakeLatencyMs = 0;
+	AverageWakeLatencyMs = 0;
+	LatestFrameSequence = 0;
+	bParallelTriangles = true;
+	TriangleGrainSize = 16;
+	LastComputeMs = 0;
+	RobustCircumcenters = 0;
+	ExactPredicates = 0;
+	DegenerateTriangleQuality = 0.001f;
+	DegenerateTriangles = 0;
+	NonFiniteSamples = 0;
+	bVectorizedTau = true;
+	TauBenchmarkSpeedup = 0;
+	TauBenchmarkMismatches = 0;
+	TauMathMode = ETauMathMode::Precise;
+	TauMathColorTolerance = 1;
+	TauMathOutlierFraction = 0.0001f;
+	bPipelinedStages = false;
+	AssemblyStageOccupancy = 0;
+	GeometryStageOccupancy = 0;
+	TauStageOccupancy = 0;
+	FrameHandoffCapacity = 1;
+	bConsumeFramesInOrder = false;
+	FramesProduced = 0;
+	FramesConsumed = 0;
+	FramesCoalesced = 0;
+	FramesDropped = 0;
+	FramesQueued = 0;
+	FramesInFlight = 0;
+	UserId = -1;
+	bUseSharedWorkerPool = false;
+	TextureSlicesPerUpdate = 8;
+	LastTextureUpdateMs = 0;
+	TrackedTriangleCount = 0;
+	bUpdateDebugGeometry = true;
+	NextTextureSlice = 0;
+	bSocketRotationsStale = false;
+	bTriangleRotationsStale = false;
+	TriangleTopology = nullptr;
+	bTrackAllTriples = false;
+	SmoothingSamplesCount = 3;
 }
 
 UNuitrackSkeletonJointBuffer::~UNuitrackSkeletonJointBuffer()
@@ -145,8 +196,13 @@ void UNuitrackSkeletonJointBuffer::BeginPlay()
 	Super::BeginPlay();
 
 	MinDebugTriangleIndex = 0;
-	MaxDebugTriangleIndex = 67 * 3;
+	MaxDebugTriangleIndex = TauTopology::IndexCount;
+
+	CreateTrackingTextures();
+}
 
+void UNuitrackSkeletonJointBuffer::CreateTrackingTextures()
+{
 	AngleTauLayer0Texture = NewObject<UDynamicTexture>(GetOuter());
 	AngleTauLayer0Texture->Initialize(18, 18, FLinearColor::Black);
 
@@ -247,13 +303,80 @@ void UNuitrackSkeletonJointBuffer::BeginPlay()
 
 void UNuitrackSkeletonJointBuffer::EndPlay(const EEndPlayReason::Type EndPlayReason) {
 	Super::EndPlay(EndPlayReason);
-	if (CurrentRunningThread && CalcThread) {
-		CurrentRunningThread->Suspend(true);
-		CalcThread->bStopThread = true;
-		CurrentRunningThread->Suspend(false);
-		CurrentRunningThread->Kill(false);
-		CurrentRunningThread->WaitForCompletion();
+	ShutdownCalculations();
+
+	// Frees the tau state unless the owning actor still shares the pool
+	TauStatePool.Reset();
+}
+
+void UNuitrackSkeletonJointBuffer::BenchmarkTauKernel(int32 TriangleCount, int32 FrameCount)
+{
+	FTauGestureBenchmark Result = FTauGestureKernels::Benchmark(TriangleCount, FrameCount, SmoothingSamplesCount + 1, TriangleGrainSize);
+	TauBenchmarkSpeedup = Result.BatchedSeconds > 0 ? (float)(Result.PerBufferSeconds / Result.BatchedSeconds) : 0.f;
+	TauBenchmarkMismatches = Result.MismatchedSamples;
+	UE_LOG(LogTemp, Display, TEXT("Tau kernel, %i triangles x %i frames, %i lanes: per-buffer %.3f ms, batched %.3f ms (sweep %.3f ms), %.2fx"),
+		Result.Triangles, Result.Frames, FTauGestureKernels::GetLaneCount(),
+		Result.PerBufferSeconds * 1000.0, Result.BatchedSeconds * 1000.0, Result.SweepSeconds * 1000.0, TauBenchmarkSpeedup);
+	if (Result.MismatchedSamples > 0) {
+		UE_LOG(LogTemp, Warning, TEXT("Tau kernel: %i of %i samples differ from the per-buffer path"), Result.MismatchedSamples, Result.ComparedSamples);
+	}
+}
+
+void UNuitrackSkeletonJointBuffer::RecordTauFrames(int32 FrameCount)
+{
+	if (!CompiledTopology.IsValid() || FrameCount <= 0) {
+		UE_LOG(LogTemp, Warning, TEXT("Tau frames can only be recorded while the calculations run"));
+		return;
+	}
+	// A new recording, so the calculation thread never writes into one that is being read
+	TSharedPtr<FTauMotionRecording, ESPMode::ThreadSafe> Recording = MakeShared<FTauMotionRecording, ESPMode::ThreadSafe>();
+	Recording->Reserve(CompiledTopology->TriangleCount, FrameCount);
+	TauRecording = Recording;
+	PushCalculationSettings();
+}
+
+bool UNuitrackSkeletonJointBuffer::ValidateTauMathMode()
+{
+	FTauMotionRecording SyntheticMotion;
+	const bool bRecorded = TauRecording.IsValid() && TauRecording->IsComplete();
+	if (!bRecorded) {
+		FTauGestureKernels::SynthesizeMotion(SyntheticMotion, GetCompiledTopology()->TriangleCount, 600);
+	}
+	const FTauMotionRecording& Motion = bRecorded ? *TauRecording : SyntheticMotion;
+
+	// The clamp range UpdateTrackingRenderTargets colors the samples with
+	TauMathValidation = FTauGestureKernels::ValidateMathMode(TauMathMode, Motion, FMath::Max(SmoothingSamplesCount, 1) + 1, -1, 1, TauMathColorTolerance, TauMathOutlierFraction);
+	TauMathValidation.bRecordedMotion = bRecorded;
+	PushCalculationSettings();
+	UE_LOG(LogTemp, Display, TEXT("Tau math mode %s over %i %s frames: tau max %g rms %g, tau dot max %g rms %g, color max %i rms %.3f, %i of %i samples off by more than %i levels, %i growing flags differ, %s"),
+		*UEnum::GetValueAsString(TauMathMode), TauMathValidation.Frames, bRecorded ? TEXT("recorded") : TEXT("synthetic"),
+		TauMathValidation.MaxTauError, TauMathValidation.RmsTauError, TauMathValidation.MaxTauDotError, TauMathValidation.RmsTauDotError,
+		TauMathValidation.MaxColorError, TauMathValidation.RmsColorError, TauMathValidation.ColorOutliers, TauMathValidation.ComparedSamples, TauMathColorTolerance,
+		TauMathValidation.GrowingMismatches, TauMathValidation.bSafe ? TEXT("safe") : TEXT("not safe, staying precise"));
+	return TauMathValidation.bSafe;
+}
+
+ETauMathMode UNuitrackSkeletonJointBuffer::GetSafeTauMathMode() const
+{
+	if (TauMathMode != ETauMathMode::Precise && TauMathValidation.Mode == TauMathMode && TauMathValidation.bSafe) {
+		return TauMathMode;
+	}
+	return ETauMathMode::Precise;
+}
+
+void UNuitrackSkeletonJointBuffer::ShutdownCalculations()
+{
+	if (CurrentRunningThread) {
+		// Kill calls FJointBufferThread::Stop, which wakes the worker so it can leave its loop
+		CurrentRunningThread->Kill(true);
+		delete CurrentRunningThread;
+		CurrentRunningThread = nullptr;
+	}
+	if (CalcThread) {
+		CalcThread->Stop();
+		CalcThread->WaitForOutstandingTasks();
 		delete CalcThread;
+		CalcThread = nullptr;
 	}
 }
 
@@ -266,257 +389,352 @@ void UNuitrackSkeletonJointBuffer::TickComponent(float DeltaTime, ELevelTick Tic
 
 void UNuitrackSkeletonJointBuffer::ProcessSocketRawData(float DeltaTime)
 {
-	if (!TriangleIndexesQueue.IsEmpty()) {
-		TriangleIndexesQueue.Dequeue(TriangleIndexes);
-	}
-	if (!TrianglePositionsQueue.IsEmpty()) {
-		TrianglePositionsQueue.Dequeue(TrianglePositions);
-	}
-	if (!TriangleIndexBoneNamesQueue.IsEmpty()) {
-		TriangleIndexBoneNamesQueue.Dequeue(TriangleIndexBoneNames);
-	}
-	if (!TriangleRotationsQueue.IsEmpty()) {
-		TriangleRotationsQueue.Dequeue(TriangleRotations);
+	if (CalcThread) {
+		// Picks up settings changed from Blueprint since the last frame
+		PushCalculationSettings();
+
+		double LastLatency = 0;
+		double AverageLatency = 0;
+		int32 WokenFrames = 0;
+		CalcThread->GetWakeLatencyStats(LastLatency, AverageLatency, WokenFrames);
+		LastWakeLatencyMs = LastLatency * 1000.0;
+		AverageWakeLatencyMs = AverageLatency * 1000.0;
+
+		float StageOccupancy[(int32)EJointBufferStage::Count];
+		CalcThread->GetStageOccupancy(StageOccupancy, FramesInFlight);
+		AssemblyStageOccupancy = StageOccupancy[(int32)EJointBufferStage::Assembly];
+		GeometryStageOccupancy = StageOccupancy[(int32)EJointBufferStage::Geometry];
+		TauStageOccupancy = StageOccupancy[(int32)EJointBufferStage::Tau];
 	}
-	if (!TriangleCentroidsQueue.IsEmpty()) {
-		TriangleCentroidsQueue.Dequeue(TriangleCentroids);
-	}
-	if (!TriangleCircumcentersQueue.IsEmpty()) {
-		TriangleCircumcentersQueue.Dequeue(TriangleCircumcenters);
-	}
-	if (!EulerLinesQueue.IsEmpty()) {
-		EulerLinesQueue.Dequeue(EulerLines);
+
+	bool bHasNewFrame = FrameResults.Consume(bConsumeFramesInOrder);
+
+	// The stats are totals over every user's buffer, so only the growth since the last call is added
+	FFrameHandoffStats HandoffStats = FrameResults.GetStats();
+	INC_DWORD_STAT_BY(STAT_TauFramesProduced, HandoffStats.Produced - FramesProduced);
+	INC_DWORD_STAT_BY(STAT_TauFramesConsumed, HandoffStats.Consumed - FramesConsumed);
+	INC_DWORD_STAT_BY(STAT_TauFramesCoalesced, HandoffStats.Coalesced - FramesCoalesced);
+	INC_DWORD_STAT_BY(STAT_TauFramesDropped, HandoffStats.Dropped - FramesDropped);
+	FramesProduced = HandoffStats.Produced;
+	FramesConsumed = HandoffStats.Consumed;
+	FramesCoalesced = HandoffStats.Coalesced;
+	FramesDropped = HandoffStats.Dropped;
+	FramesQueued = HandoffStats.Queued;
+
+	if (!bHasNewFrame) {
+		UE_LOG(LogTemp, Display, TEXT("No new frame result from the calculation thread"));
+		return;
 	}
-	if (!TriangleTauBuffersQueue.IsEmpty()) {
-		TriangleTauBuffersQueue.Dequeue(TriangleTauBuffers);
-		
-		IncrementalAngleTauSamples.Empty();
-		IncrementalPositionTauSamples.Empty();
-		IncrementalAngleTauDotSamples.Empty();
-		IncrementalPositionTauDotSamples.Empty();
 
-		std::vector<UTauBuffer*>::iterator it;
-		for (it = TriangleTauBuffers.begin(); it != TriangleTauBuffers.end(); it++) {
-			UTauBuffer* Buffer = *it;
-			if (Buffer->IncrementalAngleTauSamples.Num() > 0) {
-				IncrementalAngleTauSamples.Emplace(Buffer->IncrementalAngleTauSamples.Last());
-			}
-			if (Buffer->IncrementalAngleTauDotSamples.Num() > 0) {
-				IncrementalAngleTauDotSamples.Emplace(Buffer->IncrementalAngleTauDotSamples.Last());
-			}
+	const FTauFrameResult& Frame = FrameResults.Read();
+	LatestFrameSequence = Frame.Sequence;
+	LastComputeMs = Frame.ComputeSeconds * 1000.0;
+	RobustCircumcenters = Frame.RobustCircumcenters;
+	ExactPredicates = Frame.ExactPredicates;
+	DegenerateTriangles = Frame.DegenerateTriangles;
+	NonFiniteSamples = Frame.NonFiniteSamples;
 
-			if (Buffer->IncrementalPositionTauSamples.Num() > 0) {
-				IncrementalPositionTauSamples.Emplace(Buffer->IncrementalPositionTauSamples.Last());
-			}
+	// The arrays stay in the published frame; Blueprint getters copy from it on demand
+	bTriangleRotationsStale = true;
+}
 
-			if (Buffer->IncrementalPositionTauDotSamples.Num() > 0) {
-				IncrementalPositionTauDotSamples.Emplace(Buffer->IncrementalPositionTauDotSamples.Last());
-			}
-		}
+const FTauFrameResult& UNuitrackSkeletonJointBuffer::GetLatestFrame() const
+{
+	return FrameResults.Read();
+}
+
+TArray<int> UNuitrackSkeletonJointBuffer::GetTriangleIndexes() const
+{
+	return FrameResults.Read().TriangleIndexes;
+}
 
-		//UE_LOG(LogTemp, Display, TEXT("Found IncrementalPositionTauDotSamples size %i"), IncrementalPositionTauDotSamples.Num());
+TArray<FVector> UNuitrackSkeletonJointBuffer::GetTrianglePositions() const
+{
+	return FrameResults.Read().TrianglePositions;
+}
 
+TArray<FVector> UNuitrackSkeletonJointBuffer::GetTriangleCentroids() const
+{
+	return FrameResults.Read().TriangleCentroids;
+}
+
+TArray<FVector> UNuitrackSkeletonJointBuffer::GetTriangleCircumcenters() const
+{
+	return FrameResults.Read().TriangleCircumcenters;
+}
+
+TArray<FVector> UNuitrackSkeletonJointBuffer::GetEulerLines() const
+{
+	return FrameResults.Read().EulerLines;
+}
+
+TArray<float> UNuitrackSkeletonJointBuffer::GetIncrementalAngleTauSamples() const
+{
+	return FrameResults.Read().AngleTauSamples;
+}
+
+TArray<float> UNuitrackSkeletonJointBuffer::GetIncrementalPositionTauSamples() const
+{
+	return FrameResults.Read().PositionTauSamples;
+}
+
+TArray<float> UNuitrackSkeletonJointBuffer::GetIncrementalAngleTauDotSamples() const
+{
+	return FrameResults.Read().AngleTauDotSamples;
+}
+
+TArray<float> UNuitrackSkeletonJointBuffer::GetIncrementalPositionTauDotSamples() const
+{
+	return FrameResults.Read().PositionTauDotSamples;
+}
+
+TArray<bool> UNuitrackSkeletonJointBuffer::GetTriangleDegenerate() const
+{
+	return FrameResults.Read().TriangleDegenerate;
+}
+
+TArray<int32> UNuitrackSkeletonJointBuffer::GetTriangleNonFiniteCounts() const
+{
+	return FrameResults.Read().TriangleNonFiniteCounts;
+}
+
+FTauTopologyPtr UNuitrackSkeletonJointBuffer::GetCompiledTopology() const
+{
+	if (CompiledTopology.IsValid()) {
+		return CompiledTopology;
 	}
-	else {
-		UE_LOG(LogTemp, Display, TEXT("TriangleTauBufferQueue is empty"));
+	return FTauCompiledTopology::GetDefault();
+}
+
+FTauStatePoolPtr UNuitrackSkeletonJointBuffer::GetTauStatePool()
+{
+	if (!TauStatePool.IsValid()) {
+		TauStatePool = MakeShared<FTauStatePool, ESPMode::ThreadSafe>();
+	}
+	return TauStatePool;
+}
+
+FName UNuitrackSkeletonJointBuffer::GetTriangleLabel(int32 TriangleId) const
+{
+	FTauTopologyPtr Topology = GetCompiledTopology();
+	return Topology->Labels.IsValidIndex(TriangleId) ? Topology->Labels[TriangleId] : NAME_None;
+}
+
+FName UNuitrackSkeletonJointBuffer::GetTriangleDisplayName(int32 TriangleId) const
+{
+	FTauTopologyPtr Topology = GetCompiledTopology();
+	if (TriangleId < 0 || TriangleId >= Topology->TriangleCount) {
+		return NAME_None;
 	}
+	return Topology->GetDisplayName((FTauTriangleId)TriangleId);
 }
 
 void UNuitrackSkeletonJointBuffer::UpdateSocketRawData(TArray<FName>BoneNames, TArray<FVector>Locations, TArray<FRotator>Rotations, TArray<float>Confidences)
 {
-	if (BoneNames.Num() != Locations.Num() || BoneNames.Num() != Rotations.Num()) {
+	if (BoneNames.Num() != Locations.Num() || BoneNames.Num() != Rotations.Num() || BoneNames.Num() != Confidences.Num()) {
 		UE_LOG(LogTemp, Warning, TEXT("Not Updating socket data because data is not aligned."));
 		return;
 	}
+	if (BoneNames.Num() != FSkeletonFrame::JointCount) {
+		UE_LOG(LogTemp, Warning, TEXT("Not Updating socket data, expected %i sockets but got %i"), FSkeletonFrame::JointCount, BoneNames.Num());
+		return;
+	}
 
-	SocketBoneNames.Empty();
-	SocketLocations.Empty();
-	SocketRotations.Empty();
-	SocketConfidences.Empty();
+	FSkeletonFrame Frame;
+	Frame.UserId = UserId;
+	Frame.bHasJoints = true;
+	Frame.Timestamp = FPlatformTime::Seconds();
+	for (int ii = 0; ii < FSkeletonFrame::JointCount; ii++) {
+		Frame.Positions[ii] = Locations[ii];
+		Frame.SetOrientation(ii, Rotations[ii].Quaternion());
+		Frame.Confidences[ii] = Confidences[ii];
+	}
+	UpdateSocketFrame(Frame);
+}
 
-	for (int ii = 0; ii < BoneNames.Num(); ii++) {
-		FName BoneName = BoneNames[ii];
-		FRotator Rotation = Rotations[ii] /* MeshComponent->GetSocketRotation(Name)*/;
-		FVector Location = Locations[ii] /* MeshComponent->GetSocketLocation(Name)*/;
-		float Confidence = Confidences[ii];
+void UNuitrackSkeletonJointBuffer::UpdateSocketFrame(const FSkeletonFrame& Frame)
+{
+	LatestSkeletonFrame = Frame;
+	if (!Frame.bHasJoints) {
+		return;
+	}
 
-		SocketNames.Emplace(BoneName);
-		SocketBoneNames.Emplace(BoneName);
-		SocketRotations.Emplace(Rotation);
-		SocketLocations.Emplace(Location);
-		SocketConfidences.Emplace(Confidence);
+	// Fixed size, so the arrays only allocate on the first frame
+	SocketNames.SetNum(FSkeletonFrame::JointCount, false);
+	SocketBoneNames.SetNum(FSkeletonFrame::JointCount, false);
+	SocketLocations.SetNumUninitialized(FSkeletonFrame::JointCount, false);
+	SocketConfidences.SetNumUninitialized(FSkeletonFrame::JointCount, false);
+	for (int ii = 0; ii < FSkeletonFrame::JointCount; ii++) {
+		SocketNames[ii] = FSkeletonFrame::GetJointName(ii);
+		SocketBoneNames[ii] = SocketNames[ii];
+		SocketLocations[ii] = Frame.Positions[ii];
+		SocketConfidences[ii] = Frame.Confidences[ii];
 	}
+	bSocketRotationsStale = true;
 }
 
+const TArray<FRotator>& UNuitrackSkeletonJointBuffer::GetSocketRotations()
+{
+	if (bSocketRotationsStale) {
+		SocketRotations.SetNumUninitialized(FSkeletonFrame::JointCount, false);
+		for (int32 ii = 0; ii < FSkeletonFrame::JointCount; ii++) {
+			SocketRotations[ii] = LatestSkeletonFrame.GetRotator(ii);
+		}
+		bSocketRotationsStale = false;
+	}
+	return SocketRotations;
+}
 
-void UNuitrackSkeletonJointBuffer::UpdateTrackingRenderTargets() {
-	if (TriangleTauBuffers.size() == 0) {
-		return;
+FRotator UNuitrackSkeletonJointBuffer::GetSocketRotation(int32 Joint) const
+{
+	if (Joint < 0 || Joint >= FSkeletonFrame::JointCount) {
+		return FRotator::ZeroRotator;
 	}
+	return LatestSkeletonFrame.GetRotator(Joint);
+}
 
-	TArray<float> LastAngleTauSamples;
-	TArray<float> LastAngleTauDotSamples;
-	TArray<float> LastPositionTauSamples;
-	TArray<float> LastPositionTauDotSamples;
-	std::vector<UTauBuffer*>::iterator it;
-	for (it = TriangleTauBuffers.begin(); it != TriangleTauBuffers.end(); it++) {
-		UTauBuffer* TauBuffer = *it;
-		//UE_LOG(LogTemp, Display, TEXT("\n%s"), *TauBuffer->GetFName().ToString());
-		if (TauBuffer->IncrementalAngleTauSamples.Num() > 0) {
-			//UE_LOG(LogTemp, Display, TEXT("Incremental Angle Tau Sample:\t%f"), TauBuffer->IncrementalAngleTauSamples.Last());
-			LastAngleTauSamples.Add(TauBuffer->IncrementalAngleTauSamples.Last());
+const TArray<FRotator>& UNuitrackSkeletonJointBuffer::GetTriangleRotations()
+{
+	if (bTriangleRotationsStale) {
+		// One rotator per joint rather than one per triangle corner
+		const FTauFrameResult& Frame = FrameResults.Read();
+		FRotator Rotations[FSkeletonFrame::JointCount];
+		for (int32 Joint = 0; Joint < FSkeletonFrame::JointCount; Joint++) {
+			Rotations[Joint] = Frame.Skeleton.GetRotator(Joint);
 		}
-		if (TauBuffer->IncrementalAngleTauDotSamples.Num() > 0) {
-			//UE_LOG(LogTemp, Display, TEXT("Incremental Angle Tau Dot Sample:\t%f"), TauBuffer->IncrementalAngleTauDotSamples.Last());
-			LastAngleTauDotSamples.Add(TauBuffer->IncrementalAngleTauDotSamples.Last());
+		TriangleRotations.SetNumUninitialized(Frame.TriangleIndexes.Num(), false);
+		for (int32 Index = 0; Index < Frame.TriangleIndexes.Num(); Index++) {
+			TriangleRotations[Index] = Rotations[Frame.TriangleIndexes[Index]];
 		}
+		bTriangleRotationsStale = false;
+	}
+	return TriangleRotations;
+}
 
-		if (TauBuffer->IncrementalPositionTauSamples.Num() > 0) {
-			//UE_LOG(LogTemp, Display, TEXT("Incremental Position Tau Sample:\t%f"), TauBuffer->IncrementalPositionTauSamples.Last());
-			LastPositionTauSamples.Add(TauBuffer->IncrementalPositionTauSamples.Last());
-		}
-		if (TauBuffer->IncrementalPositionTauDotSamples.Num() > 0) {
-			//UE_LOG(LogTemp, Display, TEXT("Incremental Position Tau Dot Sample:\t%f\n"), TauBuffer->IncrementalPositionTauDotSamples.Last());
-			LastPositionTauDotSamples.Add(TauBuffer->IncrementalPositionTauDotSamples.Last());
-		}
+
+void UNuitrackSkeletonJointBuffer::UpdateTrackingRenderTargets() {
+	const FTauFrameResult& Frame = FrameResults.Read();
+	if (Frame.Sequence == 0) {
+		return;
 	}
 
-	TArray<float> SortedAngleTauSamples = TArray<float>(LastAngleTauSamples);
-	TArray<float> SortedAngleTauDotSamples = TArray<float>(LastAngleTauDotSamples);
-	TArray<float> SortedPositionTauSamples = TArray<float>(LastPositionTauSamples);
-	TArray<float> SortedPositionTauDotSamples = TArray<float>(LastPositionTauDotSamples);
+	uint32 StartCycles = FPlatformTime::Cycles();
+	ON_SCOPE_EXIT{
+		LastTextureUpdateMs = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles);
+	};
 
-	SortedAngleTauSamples.Sort();
-	SortedAngleTauDotSamples.Sort();
-	SortedPositionTauSamples.Sort();
-	SortedPositionTauDotSamples.Sort();
+	const TArray<float>& LastAngleTauSamples = Frame.AngleTauSamples;
+	const TArray<float>& LastAngleTauDotSamples = Frame.AngleTauDotSamples;
+	const TArray<float>& LastPositionTauSamples = Frame.PositionTauSamples;
+	const TArray<float>& LastPositionTauDotSamples = Frame.PositionTauDotSamples;
 
-	int CompleteSamples = TriangleIndexes.Num() / 3;
+	int CompleteSamples = Frame.TriangleIndexes.Num() / 3;
 
-	if (SortedAngleTauSamples.Num() == CompleteSamples && SortedAngleTauDotSamples.Num() == CompleteSamples && SortedPositionTauSamples.Num() == CompleteSamples && SortedPositionTauDotSamples.Num() == CompleteSamples) {
+	if (LastAngleTauSamples.Num() == CompleteSamples && LastAngleTauDotSamples.Num() == CompleteSamples && LastPositionTauSamples.Num() == CompleteSamples && LastPositionTauDotSamples.Num() == CompleteSamples) {
 
-		TArray<FColor> AngleTauFillColors = CreateFillColors(TriangleIndexes, LastAngleTauSamples, -1, 1);
-		TArray<FColor> AngleTauDotFillColors = CreateFillColors(TriangleIndexes, LastAngleTauDotSamples, -1 ,1);
-		TArray<FColor> PositionTauFillColors = CreateFillColors(TriangleIndexes, LastPositionTauSamples, -1 ,1);
-		TArray<FColor> PositionTauDotFillColors = CreateFillColors(TriangleIndexes, LastPositionTauDotSamples, -1 ,1);
+		// Refilled in place every update, so the volumes are allocated once
+		FillColors(Frame.TriangleIndexes, LastAngleTauSamples, -1, 1, AngleTauFillColors);
+		FillColors(Frame.TriangleIndexes, LastAngleTauDotSamples, -1 ,1, AngleTauDotFillColors);
+		FillColors(Frame.TriangleIndexes, LastPositionTauSamples, -1 ,1, PositionTauFillColors);
+		FillColors(Frame.TriangleIndexes, LastPositionTauDotSamples, -1 ,1, PositionTauDotFillColors);
 
-		int CompleteArray = 18 * 18 * 18;
+		const int32 Size = GetCompiledTopology()->JointCount;
+		int CompleteArray = Size * Size * Size;
 
 		if (AngleTauFillColors.Num() == CompleteArray && AngleTauDotFillColors.Num() == CompleteArray && PositionTauFillColors.Num() == CompleteArray && PositionTauDotFillColors.Num() == CompleteArray) {
-			for (int32 Depth = 0; Depth <= 17; Depth++) {
-				if (Depth == 1) {
-					CreateTextureSliceWithColors(AngleTauLayer0Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer0Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer0Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer0Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else if (Depth == 3) {
-					CreateTextureSliceWithColors(AngleTauLayer2Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer2Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer2Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer2Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else if (Depth == 12) {
-					CreateTextureSliceWithColors(AngleTauLayer11Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer11Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer11Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer11Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else if (Depth == 13) {
-					CreateTextureSliceWithColors(AngleTauLayer12Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer12Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer12Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer12Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else if (Depth == 14) {
-					CreateTextureSliceWithColors(AngleTauLayer13Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer13Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer13Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer13Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else if (Depth == 15) {
-					CreateTextureSliceWithColors(AngleTauLayer14Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer14Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer14Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer14Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else if (Depth == 16) {
-					CreateTextureSliceWithColors(AngleTauLayer15Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer15Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer15Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer15Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else if (Depth == 17) {
-					CreateTextureSliceWithColors(AngleTauLayer16Texture, 18, 18, Depth, AngleTauFillColors);
-					CreateTextureSliceWithColors(AngleTauDotLayer16Texture, 18, 18, Depth, AngleTauDotFillColors);
-					CreateTextureSliceWithColors(PositionTauLayer16Texture, 18, 18, Depth, PositionTauFillColors);
-					CreateTextureSliceWithColors(PositionTauDotLayer16Texture, 18, 18, Depth, PositionTauDotFillColors);
-				}
-				else {
+			struct FTextureSlice
+			{
+				int32 Depth;
+				UDynamicTexture* AngleTau;
+				UDynamicTexture* AngleTauDot;
+				UDynamicTexture* PositionTau;
+				UDynamicTexture* PositionTauDot;
+			};
+			const FTextureSlice Slices[] = {
+				{ 1, AngleTauLayer0Texture, AngleTauDotLayer0Texture, PositionTauLayer0Texture, PositionTauDotLayer0Texture },
+				{ 3, AngleTauLayer2Texture, AngleTauDotLayer2Texture, PositionTauLayer2Texture, PositionTauDotLayer2Texture },
+				{ 12, AngleTauLayer11Texture, AngleTauDotLayer11Texture, PositionTauLayer11Texture, PositionTauDotLayer11Texture },
+				{ 13, AngleTauLayer12Texture, AngleTauDotLayer12Texture, PositionTauLayer12Texture, PositionTauDotLayer12Texture },
+				{ 14, AngleTauLayer13Texture, AngleTauDotLayer13Texture, PositionTauLayer13Texture, PositionTauDotLayer13Texture },
+				{ 15, AngleTauLayer14Texture, AngleTauDotLayer14Texture, PositionTauLayer14Texture, PositionTauDotLayer14Texture },
+				{ 16, AngleTauLayer15Texture, AngleTauDotLayer15Texture, PositionTauLayer15Texture, PositionTauDotLayer15Texture },
+				{ 17, AngleTauLayer16Texture, AngleTauDotLayer16Texture, PositionTauLayer16Texture, PositionTauDotLayer16Texture },
+			};
+			const int32 SliceCount = UE_ARRAY_COUNT(Slices);
+
+			// Rebuild a rotating window of slices, so every slice still refreshes when fewer are allowed per update
+			int32 SlicesThisUpdate = FMath::Clamp(TextureSlicesPerUpdate, 1, SliceCount);
+			for (int32 ii = 0; ii < SlicesThisUpdate; ii++) {
+				const FTextureSlice& Slice = Slices[(NextTextureSlice + ii) % SliceCount];
+				if (Slice.Depth >= Size) {
 					continue;
 				}
+				for (UDynamicTexture* Texture : { Slice.AngleTau, Slice.AngleTauDot, Slice.PositionTau, Slice.PositionTauDot }) {
+					if (Texture->GetWidth() != Size) {
+						Texture->Initialize(Size, Size, FLinearColor::Black);
+					}
+				}
+				CreateTextureSliceWithColors(Slice.AngleTau, Size, Size, Slice.Depth, AngleTauFillColors);
+				CreateTextureSliceWithColors(Slice.AngleTauDot, Size, Size, Slice.Depth, AngleTauDotFillColors);
+				CreateTextureSliceWithColors(Slice.PositionTau, Size, Size, Slice.Depth, PositionTauFillColors);
+				CreateTextureSliceWithColors(Slice.PositionTauDot, Size, Size, Slice.Depth, PositionTauDotFillColors);
 			}
+			NextTextureSlice = (NextTextureSlice + SlicesThisUpdate) % SliceCount;
 			//UE_LOG(LogTemp, Display, TEXT("Added %i textures to array"), AngleTauTexture2DArray->SourceTextures.Num());
 		}
 	}
 	else {
 		//UE_LOG(LogTemp, Display, TEXT("Incremental Angle Tau Sample:\t%f"), TauBuffer->IncrementalAngleTauSamples.Last());
-	     UE_LOG(LogTemp, Display, TEXT("Found unequal samples (%i) and triangles (%i)"), LastAngleTauSamples.Num(), TriangleIndexes.Num() / 3);
+	     UE_LOG(LogTemp, Display, TEXT("Found unequal samples (%i) and triangles (%i)"), LastAngleTauSamples.Num(), Frame.TriangleIndexes.Num() / 3);
 	}
 }
 
-TArray<FColor> UNuitrackSkeletonJointBuffer::CreateFillColors(TArray<int> JointIndexes, TArray<float>FrameSamples, float ClampMin, float ClampMax )
+TArray<FColor> UNuitrackSkeletonJointBuffer::CreateFillColors(const TArray<int>& JointIndexes, const TArray<float>& FrameSamples, float ClampMin, float ClampMax )
 {
 	TArray<FColor> RetVal;
+	FillColors(JointIndexes, FrameSamples, ClampMin, ClampMax, RetVal);
+	return RetVal;
+}
 
+bool UNuitrackSkeletonJointBuffer::FillColors(const TArray<int>& JointIndexes, const TArray<float>& FrameSamples, float ClampMin, float ClampMax, TArray<FColor>& RetVal)
+{
 	if (JointIndexes.Num() / 3 != FrameSamples.Num()) {
 		UE_LOG(LogTemp, Display, TEXT("Found unequal samples (%i) and triangles (%i)"), JointIndexes.Num(), FrameSamples.Num() / 3);
-		return RetVal;
+		RetVal.Reset();
+		return false;
 	}
 
-	RetVal.SetNum(18 * 18 * 18);
-	for (int ii = 0; ii < 18 * 18 * 18; ii++) {
+	// One voxel per joint triple, so the volume follows the topology's joint count.
+	// The caller's array keeps its allocation, so refilling it every frame does not allocate.
+	const int32 Size = GetCompiledTopology()->JointCount;
+	RetVal.SetNumUninitialized(Size * Size * Size, false);
+	for (int ii = 0; ii < Size * Size * Size; ii++) {
 		RetVal[ii] = FColor::Transparent;
 	}
 
-	for (int ii = 0; ii < FrameSamples.Num(); ii++) {
-		int x = JointIndexes[ii * 3 + 1];		// Triangle p1 as X
-		int y = JointIndexes[ii * 3 + 2];		// Triangle p2 as Y
-		int z = JointIndexes[ii * 3 + 0];		// Using Z Value as triangle joint 0
-		int index = z + y * 18 + x * 18 * 18;
+	// All-triples topologies list each triple once, so mirror it into every permutation's voxel
+	const int32 Permutations = GetCompiledTopology()->bAllTriples ? 6 : 1;
+	static const int32 PermutationOrder[6][3] = { {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0} };
+
+	for (int pp = 0; pp < Permutations * FrameSamples.Num(); pp++) {
+		int ii = pp / Permutations;
+		const int32* Order = PermutationOrder[pp % Permutations];
+		int x = JointIndexes[ii * 3 + Order[1]];		// Triangle p1 as X
+		int y = JointIndexes[ii * 3 + Order[2]];		// Triangle p2 as Y
+		int z = JointIndexes[ii * 3 + Order[0]];		// Using Z Value as triangle joint 0
+		int index = z + y * Size + x * Size * Size;
 
 		if( index < RetVal.Num() ){
 			//UE_LOG(LogTemp, Display, TEXT("Converting x:%i y:%i z:%i to index: %i"),x, y, z, index);
 			
-			if( FrameSamples[ii] < 0 ){
-				//UE_LOG(LogTemp, Display, TEXT("Setting Negative Value Color: %f"), Value);
-				float Value = Map(FrameSamples[ii], ClampMin, 0, 0, 255);
-				if( Value > 255 ){
-					Value = 255;
-				}
-				else if (Value < 0) {
-					Value = 0;
-				}
-				RetVal[index] = FColor(0, uint8(Value), 255 - uint8(Value), 255);
-			}
-			else {
-				//UE_LOG(LogTemp, Display, TEXT("Setting Positive Value Color: %f"), Value);
-				float Value = Map(FrameSamples[ii], 0, ClampMax, 0, 255);
-				if (Value > 255) {
-					Value = 255;
-				}
-				else if (Value < 0) {
-					Value = 0;
-				}
-				RetVal[index] = FColor(uint8(Value), 0, 255 - uint8(Value), 255);
-			}
+			RetVal[index] = FTauGestureKernels::SampleColor(FrameSamples[ii], ClampMin, ClampMax);
 		}
 		else {
 			UE_LOG(LogTemp, Display, TEXT("Found index outsize of range x:%i y:%i z:%i to index: %i"), x, y, z, index);
 		}
 	}
 	
-	return RetVal;
+	return true;
 }
 
 float UNuitrackSkeletonJointBuffer::Map(float value,
@@ -528,7 +746,7 @@ float UNuitrackSkeletonJointBuffer::Map(float value,
 }
 
 
-void UNuitrackSkeletonJointBuffer::CreateTextureSliceWithColors(UDynamicTexture* BufferTexture, int32 ALPHA_MAP_WIDTH, int32 ALPHA_MAP_HEIGHT, int32 DEPTH_INDEX, TArray<FColor> FillColors)
+void UNuitrackSkeletonJointBuffer::CreateTextureSliceWithColors(UDynamicTexture* BufferTexture, int32 ALPHA_MAP_WIDTH, int32 ALPHA_MAP_HEIGHT, int32 DEPTH_INDEX, const TArray<FColor>& FillColors)
 {
 	BufferTexture->Clear();
 
@@ -561,7 +779,80 @@ void UNuitrackSkeletonJointBuffer::CreateTextureSliceWithColors(UDynamicTexture*
 	BufferTexture->UpdateTexture();
 }
 
-void UNuitrackSkeletonJointBuffer::InitCalculations(TArray<FName>BoneNames, TArray<FVector>Locations, TArray<FRotator>Rotations, TArray<float>Confidences, std::vector<UTauBuffer*>PreviousTriangleTauBuffers) {
-	CalcThread = new FJointBufferThread(BoneNames, Locations, Rotations, Confidences, PreviousTriangleTauBuffers, this);
-	CurrentRunningThread = FRunnableThread::Create(CalcThread, TEXT("CalculationThread"));
+void UNuitrackSkeletonJointBuffer::InitCalculations(const FSkeletonFrame& Frame) {
+	StartCalculations();
+	PostCalculationFrame(Frame);
+}
+
+bool UNuitrackSkeletonJointBuffer::StartCalculations()
+{
+	// Compiling the topology, validating the math mode and resizing the handoff all touch UObject state
+	check(IsInGameThread());
+
+	// The calculation thread is created once and then woken up for every new frame
+	if (CalcThread == nullptr) {
+		// Compile the topology once; the worker and the texture mapping size everything from it
+		if (bTrackAllTriples) {
+			CompiledTopology = FTauCompiledTopology::MakeAllTriples(TauTopology::JointCount);
+		}
+		else {
+			CompiledTopology = TriangleTopology ? TriangleTopology->Compile() : nullptr;
+		}
+		if (!CompiledTopology.IsValid()) {
+			CompiledTopology = FTauCompiledTopology::GetDefault();
+		}
+		MaxDebugTriangleIndex = CompiledTopology->GetIndexCount();
+
+		TriangleIndexBoneNames.SetNum(CompiledTopology->GetIndexCount());
+		for (int32 Index = 0; Index < CompiledTopology->GetIndexCount(); Index++) {
+			int32 Joint = CompiledTopology->TriangleJoints[Index];
+			TriangleIndexBoneNames[Index] = Joint < FSkeletonFrame::JointCount ? FSkeletonFrame::GetJointName(Joint) : NAME_None;
+		}
+
+		// No writer exists yet, so the handoff slots can be reallocated
+		FrameResults.Initialize(FrameHandoffCapacity);
+		FramesProduced = 0;
+		FramesConsumed = 0;
+		FramesCoalesced = 0;
+		FramesDropped = 0;
+		FramesQueued = 0;
+
+		// The tau window is fixed from here on, so an approximate mode is checked against it before the first frame
+		if (TauMathMode != ETauMathMode::Precise && TauMathValidation.Mode != TauMathMode) {
+			ValidateTauMathMode();
+		}
+
+		CalcThread = new FJointBufferThread(this, bUseSharedWorkerPool);
+		PushCalculationSettings();
+		if (!bUseSharedWorkerPool) {
+			CurrentRunningThread = FRunnableThread::Create(CalcThread, TEXT("CalculationThread"));
+			CalculationThreadCreations++;
+			UE_LOG(LogTemp, Display, TEXT("Created calculation thread (%i total)"), CalculationThreadCreations);
+		}
+		return true;
+	}
+	return false;
+}
+
+void UNuitrackSkeletonJointBuffer::PostCalculationFrame(const FSkeletonFrame& Frame)
+{
+	if (CalcThread) {
+		CalcThread->PostFrame(Frame);
+	}
+}
+
+void UNuitrackSkeletonJointBuffer::PushCalculationSettings()
+{
+	check(IsInGameThread());
+	if (CalcThread) {
+		FJointBufferQualitySettings Quality;
+		Quality.bParallelTriangles = bParallelTriangles;
+		Quality.TriangleGrainSize = TriangleGrainSize;
+		Quality.bPipelinedStages = bPipelinedStages;
+		Quality.TrackedTriangleCount = TrackedTriangleCount;
+		Quality.bUpdateDebugGeometry = bUpdateDebugGeometry;
+		Quality.bVectorizedTau = bVectorizedTau;
+		CalcThread->SetQualitySettings(Quality);
+		CalcThread->SetTauMathSettings(GetSafeTauMathMode(), TauRecording);
+	}
 }
\ No newline at end of file
@@ -14,6 +14,12 @@
 #include "Math/Color.h"
 #include "Engine/Texture2D.h"
 #include "JointBufferThread.h"
+#include "TauFrameResult.h"
+#include "TauTriangleTopology.h"
+#include "TauStatePool.h"
+#include "TauGestureKernels.h"
+#include "SkeletonFrame.h"
+#include "BoundedFrameHandoff.h"
 #include "HAL/Runnable.h"
 #include "HAL/RunnableThread.h"
 #include "NuitrackSkeletonJointBuffer.generated.h"
@@ -39,45 +45,48 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FVector> SocketLocations;
 
+	// Filled by GetSocketRotations; the frame only keeps quaternions
 	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FRotator> SocketRotations;
 
 	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
 	TArray<float> SocketConfidences;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	// The frame arrays below are not mirrored every frame. Blueprint reads go through their getters, which copy
+	// from the published frame only when a graph asks for one; C++ reads GetLatestFrame without copying.
+	UPROPERTY(BlueprintGetter = GetTriangleIndexes, Category = "NuitrackSkeletonJointBuffer")
 	TArray<int> TriangleIndexes;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetTrianglePositions, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FVector> TrianglePositions;
 
+	// Socket name of every triangle corner. Fixed for a topology, so it is filled once when the calculations start.
 	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FName> TriangleIndexBoneNames;
 
+	// Filled by GetTriangleRotations; the published frame only keeps the skeleton's quaternions
 	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FRotator> TriangleRotations;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetTriangleCentroids, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FVector> TriangleCentroids;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetTriangleCircumcenters, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FVector> TriangleCircumcenters;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetEulerLines, Category = "NuitrackSkeletonJointBuffer")
 	TArray<FVector> EulerLines;
 
-	std::vector<UTauBuffer*> TriangleTauBuffers;
-
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetIncrementalAngleTauSamples, Category = "NuitrackSkeletonJointBuffer")
 	TArray<float> IncrementalAngleTauSamples;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetIncrementalPositionTauSamples, Category = "NuitrackSkeletonJointBuffer")
 	TArray<float> IncrementalPositionTauSamples;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetIncrementalAngleTauDotSamples, Category = "NuitrackSkeletonJointBuffer")
 	TArray<float> IncrementalAngleTauDotSamples;
 
-	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+	UPROPERTY(BlueprintGetter = GetIncrementalPositionTauDotSamples, Category = "NuitrackSkeletonJointBuffer")
 	TArray<float> IncrementalPositionTauDotSamples;
 
 	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
@@ -87,14 +96,32 @@ public:
 		int MaxDebugTriangleIndex;
 
 
+	// Blueprint entry point; the sockets must be in FSkeletonFrame order
 	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
 		void UpdateSocketRawData(TArray<FName>BoneNames, TArray<FVector>Locations, TArray<FRotator>Rotations, TArray<float>Confidences);
 
+	// Mirrors the frame into the Blueprint-visible socket arrays
+	void UpdateSocketFrame(const FSkeletonFrame& Frame);
+
+	// Latest frame passed to UpdateSocketFrame
+	FSkeletonFrame LatestSkeletonFrame;
+
+	// Rotators are only built when asked for, at most once per frame
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		const TArray<FRotator>& GetSocketRotations();
+
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		FRotator GetSocketRotation(int32 Joint) const;
+
+	// Rotation of the joint at every triangle corner of the latest published frame
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		const TArray<FRotator>& GetTriangleRotations();
+
 	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
 		void ProcessSocketRawData(float DeltaTime);
 	
 	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
-		void CreateTextureSliceWithColors(UDynamicTexture* BufferTexture, int32 ALPHA_MAP_WIDTH, int32 ALPHA_MAP_HEIGHT, int32 DEPTH_INDEX, TArray<FColor> FillColors);
+		void CreateTextureSliceWithColors(UDynamicTexture* BufferTexture, int32 ALPHA_MAP_WIDTH, int32 ALPHA_MAP_HEIGHT, int32 DEPTH_INDEX, const TArray<FColor>& FillColors);
 
 	UPROPERTY(BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
 		UDynamicTexture* AngleTauLayer0Texture;
@@ -193,25 +220,269 @@ public:
 		UDynamicTexture* PositionTauDotLayer16Texture;
 
 	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
-		TArray<FColor> CreateFillColors(TArray<int> JointIndexes, TArray<float>FrameSamples, float ClampMin, float ClampMax);
+		TArray<FColor> CreateFillColors(const TArray<int>& JointIndexes, const TArray<float>& FrameSamples, float ClampMin, float ClampMax);
+
+	// CreateFillColors into an existing array, reusing its allocation. Returns false when the samples do not match the triangles.
+	bool FillColors(const TArray<int>& JointIndexes, const TArray<float>& FrameSamples, float ClampMin, float ClampMax, TArray<FColor>& RetVal);
 
 	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
 		void UpdateTrackingRenderTargets();
 
+	// Number of the eight texture slices rebuilt per UpdateTrackingRenderTargets call; the rest wait their turn
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1", ClampMax = "8"))
+		int32 TextureSlicesPerUpdate;
+
+	// Game thread time of the latest UpdateTrackingRenderTargets call
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float LastTextureUpdateMs;
+
+	// Triangles whose tau is updated each frame, 0 tracks all of them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "0"))
+		int32 TrackedTriangleCount;
+
+	// Past samples the tau averages cover, applied when the calculation thread starts
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1", ClampMax = "64"))
+		int32 SmoothingSamplesCount;
+
+	// Compute the per-triangle debug vectors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bUpdateDebugGeometry;
+
+
+	// Nuitrack skeleton id this buffer tracks, -1 while unassigned
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 UserId;
+
+	// Schedule this buffer's frames on the task graph workers instead of a dedicated calculation thread
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bUseSharedWorkerPool;
 
 	class FJointBufferThread* CalcThread = nullptr;
 	FRunnableThread* CurrentRunningThread = nullptr;
 
-	TQueue<TArray<int>> TriangleIndexesQueue;
-	TQueue<TArray<FVector>> TrianglePositionsQueue;
-	TQueue<TArray<FName>> TriangleIndexBoneNamesQueue;
-	TQueue<TArray<FRotator>> TriangleRotationsQueue;
-	TQueue<TArray<FVector>> TriangleCentroidsQueue;
-	TQueue<TArray<FVector>> TriangleCircumcentersQueue;
-	TQueue<TArray<FVector>> EulerLinesQueue;
-	TQueue<std::vector<UTauBuffer*>> TriangleTauBuffersQueue;
+	// Number of calculation threads this buffer has spawned. Should stay at 1 for the whole session.
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 CalculationThreadCreations;
+
+	// Time between posting a frame and the calculation thread waking up for it.
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float LastWakeLatencyMs;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float AverageWakeLatencyMs;
+
+	// Run the per-triangle geometry and tau updates on the task graph. Turn off to compare against the serial path.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bParallelTriangles;
+
+	// Number of triangles handled by one task when bParallelTriangles is on
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1"))
+		int32 TriangleGrainSize;
+
+	// Calculation thread time for the latest frame
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float LastComputeMs;
+
+	// Near-collinear triangles of the latest frame whose circumcenter needed the robust path,
+	// and the cross product components among them that needed exact arithmetic
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 RobustCircumcenters;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 ExactPredicates;
+
+	// Area ratio (1 for an equilateral triangle, 0 for a collinear one) below which a triangle counts as
+	// degenerate and gets the midpoint of its longest edge as circumcenter. Applied when the calculation thread starts.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "0", ClampMax = "1"))
+		float DegenerateTriangleQuality;
+
+	// Triangles of the latest frame flagged as degenerate, in total and per triangle
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 DegenerateTriangles;
+
+	UPROPERTY(BlueprintGetter = GetTriangleDegenerate, Category = "NuitrackSkeletonJointBuffer")
+		TArray<bool> TriangleDegenerate;
+
+	// NaN/Inf Euler lines and tau samples each triangle's tau state has seen, and their sum
+	UPROPERTY(BlueprintGetter = GetTriangleNonFiniteCounts, Category = "NuitrackSkeletonJointBuffer")
+		TArray<int32> TriangleNonFiniteCounts;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 NonFiniteSamples;
+
+	// Compute tau and tau dot for a whole range of triangles per SIMD sweep. Gives the same samples as the per-buffer path.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bVectorizedTau;
+
+	// Runs both tau paths over synthetic motion with the current window and grain size and logs their timings
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		void BenchmarkTauKernel(int32 TriangleCount = 816, int32 FrameCount = 600);
+
+	// Per-buffer time over batched time of the latest BenchmarkTauKernel run, and the samples that differed between them
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float TauBenchmarkSpeedup;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 TauBenchmarkMismatches;
+
+	// Math the tau update should use. An approximate mode only runs once ValidateTauMathMode found it safe;
+	// until then, and whenever the mode changes, the calculations stay precise.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		ETauMathMode TauMathMode;
+
+	// 8-bit color levels a sample may move by, and the share of samples allowed to move further, for a mode to count as safe
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "0", ClampMax = "255"))
+		int32 TauMathColorTolerance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "0", ClampMax = "1"))
+		float TauMathOutlierFraction;
+
+	// Result of the latest ValidateTauMathMode run
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		FTauMathValidation TauMathValidation;
+
+	// Records the Euler lines of the next FrameCount frames for ValidateTauMathMode. Needs the calculations to be running.
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		void RecordTauFrames(int32 FrameCount = 600);
+
+	// Replays the recorded frames, or synthetic motion while no recording is complete, through the precise math
+	// and TauMathMode, and logs the differences. Returns whether TauMathMode may be used.
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		bool ValidateTauMathMode();
+
+	// TauMathMode when it was validated as safe, Precise otherwise
+	ETauMathMode GetSafeTauMathMode() const;
+
+	TSharedPtr<FTauMotionRecording, ESPMode::ThreadSafe> TauRecording;
+
+	// Run triangle assembly, geometry and tau as pipelined task graph stages so consecutive frames overlap
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bPipelinedStages;
+
+	// Fraction of wall time each pipeline stage has been busy
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float AssemblyStageOccupancy;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float GeometryStageOccupancy;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float TauStageOccupancy;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 FramesInFlight;
+
+	// Frames published by the calculation thread. The worker writes, ProcessSocketRawData reads.
+	TBoundedFrameHandoff<FTauFrameResult> FrameResults;
+
+	// Unread frames kept when the game thread falls behind; older ones are dropped. Applied when the calculations start.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer", meta = (ClampMin = "1", ClampMax = "8"))
+		int32 FrameHandoffCapacity;
+
+	// Take queued frames oldest first instead of jumping to the newest one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bConsumeFramesInOrder;
+
+	// Handoff totals since the calculations started
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 FramesProduced;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 FramesConsumed;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 FramesCoalesced;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 FramesDropped;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 FramesQueued;
+
+	// Sequence number of the frame currently visible through GetLatestFrame
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 LatestFrameSequence;
+
+	// Read-only view of the latest consumed frame without copying it
+	const FTauFrameResult& GetLatestFrame() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<int> GetTriangleIndexes() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<FVector> GetTrianglePositions() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<FVector> GetTriangleCentroids() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<FVector> GetTriangleCircumcenters() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<FVector> GetEulerLines() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<float> GetIncrementalAngleTauSamples() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<float> GetIncrementalPositionTauSamples() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<float> GetIncrementalAngleTauDotSamples() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<float> GetIncrementalPositionTauDotSamples() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<bool> GetTriangleDegenerate() const;
+
+	UFUNCTION(BlueprintGetter)
+		TArray<int32> GetTriangleNonFiniteCounts() const;
+
+	// Triangles to track; the built-in 67-triangle set when empty. Compiled when the calculations start.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		UTauTriangleTopology* TriangleTopology;
+
+	// Track every distinct triple of the 18 joints (816 triangles) instead of TriangleTopology
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NuitrackSkeletonJointBuffer")
+		bool bTrackAllTriples;
+
+	// Topology the running calculations use
+	FTauTopologyPtr GetCompiledTopology() const;
 
-		void InitCalculations(TArray<FName>BoneNames, TArray<FVector>Locations, TArray<FRotator>Rotations, TArray<float>Confidences, std::vector<UTauBuffer*>PreviousTriangleTauBuffers);
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		FName GetTriangleLabel(int32 TriangleId) const;
+
+	// The triangle's label, or its joint names joined when the topology has no label for it
+	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
+		FName GetTriangleDisplayName(int32 TriangleId) const;
+
+	// Pool the calculation thread leases its tau state from. The owning actor shares one across its users;
+	// a buffer without one creates its own.
+	FTauStatePoolPtr TauStatePool;
+
+	FTauStatePoolPtr GetTauStatePool();
+
+		// Stops the calculation worker and drops its tau state. The next StartCalculations starts over.
+		void ShutdownCalculations();
+
+		// Compiles the topology and creates the worker if it is not running. Game thread only, and before
+		// the buffer is reachable from the sensor thread. Returns true when a new worker was created.
+		bool StartCalculations();
+
+		// Hands a frame to the running worker, and does nothing when there is none. Safe from the sensor thread
+		// while the caller keeps the buffer from being shut down, which the actor does with its user map lock.
+		void PostCalculationFrame(const FSkeletonFrame& Frame);
+
+		// Game thread only. Hands the settings the worker reads per frame over under its lock, so posting a frame
+		// from the sensor thread never reads this object's properties. Called on start, every ProcessSocketRawData and on changes.
+		void PushCalculationSettings();
+
+		// StartCalculations followed by PostCalculationFrame, for game thread callers
+		void InitCalculations(const FSkeletonFrame& Frame);
+
+		// Creates the 18x18 tau slice textures. Called from BeginPlay, and by tests that drive a buffer without a world.
+		void CreateTrackingTextures();
 
 protected:
 	// Called when the game starts
@@ -245,6 +516,21 @@ protected:
 
 		*/
 
+	FTauTopologyPtr CompiledTopology;
+
+	// Set when a new frame arrives and cleared once its rotators are built
+	bool bSocketRotationsStale;
+	bool bTriangleRotationsStale;
+
+	// First slice rebuilt by the next UpdateTrackingRenderTargets call when TextureSlicesPerUpdate is below 8
+	int32 NextTextureSlice;
+
+	// Color volumes UpdateTrackingRenderTargets refills every update
+	TArray<FColor> AngleTauFillColors;
+	TArray<FColor> AngleTauDotFillColors;
+	TArray<FColor> PositionTauFillColors;
+	TArray<FColor> PositionTauDotFillColors;
+
 	UFUNCTION(BlueprintCallable, Category = "NuitrackSkeletonJointBuffer")
 	float Map(float value,
 		float istart,
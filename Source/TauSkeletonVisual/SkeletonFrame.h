@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TriangleTopology.h"
+#include <type_traits>
+
+/**
+ * One tracked user's 18 joints in Unreal space, in the socket order TriangleTopology.h lists.
+ * Fixed-size and trivially copyable, so handing a frame to another stage is a single memcpy
+ * and nothing in it allocates.
+ */
+struct FSkeletonFrame
+{
+	static constexpr int32 JointCount = TauTopology::JointCount;
+
+	// Nuitrack skeleton id, -1 when unassigned
+	int32 UserId = -1;
+
+	// False when Nuitrack reported the user without joints
+	bool bHasJoints = false;
+
+	// FPlatformTime::Seconds() when the frame was decoded
+	double Timestamp = 0;
+
+	FVector Positions[JointCount];
+
+	// Joint rotations as quaternion columns, filled for all joints at once by FSkeletonOrientationKernels
+	float OrientationX[JointCount];
+	float OrientationY[JointCount];
+	float OrientationZ[JointCount];
+	float OrientationW[JointCount];
+
+	// Joints whose sensor matrix was not a rotation and got the identity
+	int32 InvalidOrientations = 0;
+
+	float Confidences[JointCount];
+
+	FQuat GetOrientation(int32 Joint) const
+	{
+		return FQuat(OrientationX[Joint], OrientationY[Joint], OrientationZ[Joint], OrientationW[Joint]);
+	}
+
+	void SetOrientation(int32 Joint, const FQuat& Orientation)
+	{
+		OrientationX[Joint] = Orientation.X;
+		OrientationY[Joint] = Orientation.Y;
+		OrientationZ[Joint] = Orientation.Z;
+		OrientationW[Joint] = Orientation.W;
+	}
+
+	// Euler angles cost a few atan2/asin per joint, so they are only built for a consumer that asks
+	FRotator GetRotator(int32 Joint) const
+	{
+		return GetOrientation(Joint).Rotator();
+	}
+
+	// Socket name of each joint, created once for the whole session
+	static FName GetJointName(int32 Joint)
+	{
+		static const FName JointNames[JointCount] = {
+			TEXT("Head"), TEXT("Neck"), TEXT("Torso"), TEXT("Waist"),
+			TEXT("LeftShoulder"), TEXT("LeftElbow"), TEXT("LeftWrist"), TEXT("LeftHand"),
+			TEXT("RightShoulder"), TEXT("RightElbow"), TEXT("RightWrist"), TEXT("RightHand"),
+			TEXT("LeftHip"), TEXT("LeftKnee"), TEXT("LeftAnkle"),
+			TEXT("RightHip"), TEXT("RightKnee"), TEXT("RightAnkle")
+		};
+		check(Joint >= 0 && Joint < JointCount);
+		return JointNames[Joint];
+	}
+};
+
+static_assert(std::is_trivially_copyable<FSkeletonFrame>::value, "FSkeletonFrame is copied with memcpy between pipeline stages");
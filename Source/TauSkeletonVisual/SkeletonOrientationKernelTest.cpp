@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "Misc/Optional.h"
+#include "Math/QuatRotationTranslationMatrix.h"
+#include "SkeletonOrientationKernels.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkeletonOrientationKernelTest, "TauSkeletonVisual.OrientationKernel.MatrixToQuaternion",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+namespace SkeletonOrientationKernelTest
+{
+	using FMatrixElements = float[FSkeletonOrientationKernels::MatrixElements];
+
+	// Sign-insensitive, q and -q are the same rotation
+	static const float QuatTolerance = 1e-5f;
+
+	// Noise of 1e-4 per element moves the quaternion by about as much
+	static const float NoisyTolerance = 1e-3f;
+
+	// The SIMD path and the single matrix path run the same steps, so they may only differ by rounding
+	static const float PathTolerance = 1e-6f;
+
+	// Nuitrack's matrix rotates column vectors, FMatrix rotates row vectors, so one is the other transposed
+	static void ToSensorMatrix(const FMatrix& Matrix, FMatrixElements& OutElements)
+	{
+		for (int32 Row = 0; Row < 3; Row++) {
+			for (int32 Column = 0; Column < 3; Column++) {
+				OutElements[Row * 3 + Column] = Matrix.M[Column][Row];
+			}
+		}
+	}
+
+	struct FCase
+	{
+		FString Name;
+		float Elements[FSkeletonOrientationKernels::MatrixElements];
+		bool bRotation;
+		// The quaternion the matrix was built from, for the exact rotations
+		TOptional<FQuat> Source;
+	};
+
+	static FCase MakeRotationCase(const FString& Name, const FQuat& Rotation)
+	{
+		FCase Case;
+		Case.Name = Name;
+		ToSensorMatrix(FQuatRotationMatrix(Rotation), Case.Elements);
+		Case.bRotation = true;
+		Case.Source = Rotation;
+		return Case;
+	}
+
+	// Known rotations, including every branch of the trace method and the points where it switches
+	static void MakeRotationCases(TArray<FCase>& OutCases)
+	{
+		const FVector Axes[] = { FVector::ForwardVector, FVector::RightVector, FVector::UpVector };
+		const TCHAR* AxisNames[] = { TEXT("X"), TEXT("Y"), TEXT("Z") };
+
+		OutCases.Add(MakeRotationCase(TEXT("identity"), FQuat::Identity));
+		for (int32 Axis = 0; Axis < 3; Axis++) {
+			OutCases.Add(MakeRotationCase(FString::Printf(TEXT("90 about %s"), AxisNames[Axis]), FQuat(Axes[Axis], HALF_PI)));
+			OutCases.Add(MakeRotationCase(FString::Printf(TEXT("-90 about %s"), AxisNames[Axis]), FQuat(Axes[Axis], -HALF_PI)));
+			OutCases.Add(MakeRotationCase(FString::Printf(TEXT("180 about %s"), AxisNames[Axis]), FQuat(Axes[Axis], PI)));
+			OutCases.Add(MakeRotationCase(FString::Printf(TEXT("179.9 about %s"), AxisNames[Axis]), FQuat(Axes[Axis], FMath::DegreesToRadians(179.9f))));
+		}
+		OutCases.Add(MakeRotationCase(TEXT("180 about XY"), FQuat(FVector(1.f, 1.f, 0.f).GetSafeNormal(), PI)));
+		OutCases.Add(MakeRotationCase(TEXT("180 about XYZ"), FQuat(FVector(1.f, -1.f, 1.f).GetSafeNormal(), PI)));
+
+		// A trace of zero sits exactly between the W branch and the axis branches
+		OutCases.Add(MakeRotationCase(TEXT("120 about XYZ"), FQuat(FVector(1.f, 1.f, 1.f).GetSafeNormal(), 2.f * PI / 3.f)));
+		OutCases.Add(MakeRotationCase(TEXT("just under 120 about XYZ"), FQuat(FVector(1.f, 1.f, 1.f).GetSafeNormal(), 2.f * PI / 3.f - 1e-3f)));
+		OutCases.Add(MakeRotationCase(TEXT("just over 120 about XYZ"), FQuat(FVector(1.f, 1.f, 1.f).GetSafeNormal(), 2.f * PI / 3.f + 1e-3f)));
+
+		FRandomStream Random(0x5eed);
+		for (int32 Index = 0; Index < 64; Index++) {
+			const FQuat Rotation(Random.GetUnitVector(), Random.FRandRange(-PI, PI));
+			OutCases.Add(MakeRotationCase(FString::Printf(TEXT("random %i"), Index), Rotation));
+		}
+	}
+
+	// Matrices the kernel must not read as rotations, and one that is only slightly off and must still pass
+	static void MakeNearSingularCases(TArray<FCase>& OutCases)
+	{
+		FCase Zero;
+		Zero.Name = TEXT("zero matrix");
+		FMemory::Memzero(Zero.Elements);
+		Zero.bRotation = false;
+		OutCases.Add(Zero);
+
+		FCase Scaled = MakeRotationCase(TEXT("rotation scaled by 2"), FQuat(FVector::UpVector, 0.7f));
+		for (float& Element : Scaled.Elements) {
+			Element *= 2.f;
+		}
+		Scaled.bRotation = false;
+		Scaled.Source.Reset();
+		OutCases.Add(Scaled);
+
+		FCase Reflection = MakeRotationCase(TEXT("reflection"), FQuat(FVector::RightVector, 0.4f));
+		for (int32 Row = 0; Row < 3; Row++) {
+			Reflection.Elements[Row * 3] = -Reflection.Elements[Row * 3];
+		}
+		Reflection.bRotation = false;
+		Reflection.Source.Reset();
+		OutCases.Add(Reflection);
+
+		FCase Flattened = MakeRotationCase(TEXT("rank 2"), FQuat::Identity);
+		Flattened.Elements[8] = 0.f;
+		Flattened.bRotation = false;
+		Flattened.Source.Reset();
+		OutCases.Add(Flattened);
+
+		FRandomStream Random(0xface);
+		FCase Noisy = MakeRotationCase(TEXT("rotation with sensor noise"), FQuat(FVector(0.3f, -0.5f, 0.8f).GetSafeNormal(), 1.1f));
+		Noisy.Source.Reset();
+		for (float& Element : Noisy.Elements) {
+			Element += Random.FRandRange(-1e-4f, 1e-4f);
+		}
+		OutCases.Add(Noisy);
+	}
+
+	static FMatrix ToMatrix(const FMatrixElements& Elements)
+	{
+		FMatrix Matrix = FMatrix::Identity;
+		for (int32 Row = 0; Row < 3; Row++) {
+			for (int32 Column = 0; Column < 3; Column++) {
+				Matrix.M[Column][Row] = Elements[Row * 3 + Column];
+			}
+		}
+		return Matrix;
+	}
+}
+
+bool FSkeletonOrientationKernelTest::RunTest(const FString& Parameters)
+{
+	using namespace SkeletonOrientationKernelTest;
+
+	TArray<FCase> Cases;
+	MakeRotationCases(Cases);
+	MakeNearSingularCases(Cases);
+
+	for (const FCase& Case : Cases) {
+		const FQuat Result = FSkeletonOrientationKernels::MatrixToQuaternion(Case.Elements);
+
+		if (!Case.bRotation) {
+			TestTrue(FString::Printf(TEXT("%s gives the identity"), *Case.Name), Result.Equals(FQuat::Identity, 0.f));
+			continue;
+		}
+
+		// The engine's own conversion of the same matrix, and for exact rotations the quaternion it was built from
+		const FQuat Expected(ToMatrix(Case.Elements));
+		const float Tolerance = Case.Source.IsSet() ? QuatTolerance : NoisyTolerance;
+		if (!Result.Equals(Expected, Tolerance)) {
+			AddError(FString::Printf(TEXT("%s: kernel gives %s, FQuat(FMatrix) gives %s"), *Case.Name, *Result.ToString(), *Expected.ToString()));
+		}
+		if (Case.Source.IsSet() && !Result.Equals(Case.Source.GetValue(), Tolerance)) {
+			AddError(FString::Printf(TEXT("%s: kernel gives %s, built from %s"), *Case.Name, *Result.ToString(), *Case.Source.GetValue().ToString()));
+		}
+		if (FMath::Abs(Result.Size() - 1.f) > Tolerance) {
+			AddError(FString::Printf(TEXT("%s: kernel quaternion has length %g"), *Case.Name, Result.Size()));
+		}
+	}
+
+	// Every case through the whole skeleton pass, shifted by one joint per round so each case lands in every SIMD lane and in the scalar tail
+	const int32 JointCount = FSkeletonFrame::JointCount;
+	for (int32 Offset = 0; Offset < Cases.Num(); Offset++) {
+		float Matrices[FSkeletonOrientationKernels::MatrixElements][FSkeletonFrame::JointCount];
+		int32 ExpectedInvalid = 0;
+		for (int32 Joint = 0; Joint < JointCount; Joint++) {
+			const FCase& Case = Cases[(Offset + Joint) % Cases.Num()];
+			for (int32 Element = 0; Element < FSkeletonOrientationKernels::MatrixElements; Element++) {
+				Matrices[Element][Joint] = Case.Elements[Element];
+			}
+			ExpectedInvalid += Case.bRotation ? 0 : 1;
+		}
+
+		FSkeletonFrame Frame;
+		const int32 Invalid = FSkeletonOrientationKernels::MatricesToQuaternions(Matrices, Frame);
+		if (Invalid != ExpectedInvalid) {
+			AddError(FString::Printf(TEXT("Skeleton pass from case %i: %i joints counted as invalid, expected %i"), Offset, Invalid, ExpectedInvalid));
+		}
+
+		for (int32 Joint = 0; Joint < JointCount; Joint++) {
+			const FCase& Case = Cases[(Offset + Joint) % Cases.Num()];
+			const FQuat Single = FSkeletonOrientationKernels::MatrixToQuaternion(Case.Elements);
+			const FQuat Batched = Frame.GetOrientation(Joint);
+			// Same sign too, both paths pick the same branch
+			if (FMath::Abs(Batched.X - Single.X) > PathTolerance || FMath::Abs(Batched.Y - Single.Y) > PathTolerance
+				|| FMath::Abs(Batched.Z - Single.Z) > PathTolerance || FMath::Abs(Batched.W - Single.W) > PathTolerance) {
+				AddError(FString::Printf(TEXT("%s at joint %i: skeleton pass gives %s, single matrix gives %s"),
+					*Case.Name, Joint, *Batched.ToString(), *Single.ToString()));
+			}
+		}
+	}
+
+	return !HasAnyErrors();
+}
+
+#endif
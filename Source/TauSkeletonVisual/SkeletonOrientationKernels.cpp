@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkeletonOrientationKernels.h"
+#include "TauSimd.h"
+
+TAU_BEGIN_UNFUSED_MATH
+
+namespace SkeletonOrientationKernels
+{
+	// Sensor matrices are orthonormal to float precision, anything further off is not a rotation
+	static constexpr float DeterminantTolerance = 0.01f;
+
+	// One joint, with the steps and rounding of the SIMD loop. Returns false when the matrix is not a rotation.
+	static bool MatrixToQuaternion(float M00, float M01, float M02, float M10, float M11, float M12, float M20, float M21, float M22,
+		float& OutX, float& OutY, float& OutZ, float& OutW)
+	{
+		// The trace method picks the largest quaternion component to divide by
+		const float Trace = (M00 + M11) + M22;
+		const bool bW = Trace > 0.f;
+		const bool bX = !bW & (M00 > M11) & (M00 > M22);
+		const bool bY = !(bW | bX) & (M11 > M22);
+		const float Diagonal = bW ? Trace : (bX ? (M00 - M11) - M22 : (bY ? (M11 - M00) - M22 : (M22 - M00) - M11));
+
+		// S is 4 times the largest component
+		const float S = FMath::Sqrt(1.f + Diagonal) * 2.f;
+		const float InvS = 1.f / S;
+		const float Largest = 0.25f * S;
+		const float WX = (M21 - M12) * InvS;
+		const float WY = (M02 - M20) * InvS;
+		const float WZ = (M10 - M01) * InvS;
+		const float XY = (M01 + M10) * InvS;
+		const float XZ = (M02 + M20) * InvS;
+		const float YZ = (M12 + M21) * InvS;
+
+		const float Determinant = (M00 * ((M11 * M22) - (M12 * M21)) - M01 * ((M10 * M22) - (M12 * M20))) + M02 * ((M10 * M21) - (M11 * M20));
+		const bool bRotation = FMath::Abs(Determinant - 1.f) <= DeterminantTolerance;
+
+		OutX = bRotation ? (bW ? WX : (bX ? Largest : (bY ? XY : XZ))) : 0.f;
+		OutY = bRotation ? (bW ? WY : (bX ? XY : (bY ? Largest : YZ))) : 0.f;
+		OutZ = bRotation ? (bW ? WZ : (bX ? XZ : (bY ? YZ : Largest))) : 0.f;
+		OutW = bRotation ? (bW ? Largest : (bX ? WX : (bY ? WY : WZ))) : 1.f;
+		return bRotation;
+	}
+
+#if PLATFORM_CPU_X86_FAMILY
+	// SSE2 has no blend, so masks pick with and/andnot/or
+	FORCEINLINE __m128 Select(__m128 Mask, __m128 IfTrue, __m128 IfFalse)
+	{
+		return _mm_or_ps(_mm_and_ps(Mask, IfTrue), _mm_andnot_ps(Mask, IfFalse));
+	}
+#endif
+}
+
+int32 FSkeletonOrientationKernels::MatricesToQuaternions(const float Matrices[MatrixElements][FSkeletonFrame::JointCount], FSkeletonFrame& Frame)
+{
+	int32 InvalidJoints = 0;
+	int32 Joint = 0;
+
+#if PLATFORM_CPU_X86_FAMILY
+	// SSE2 is part of every x86-64 target, so this needs no CPU dispatch
+	using SkeletonOrientationKernels::Select;
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 One = _mm_set1_ps(1.f);
+	const __m128 Two = _mm_set1_ps(2.f);
+	const __m128 Quarter = _mm_set1_ps(0.25f);
+	const __m128 SignBit = _mm_set1_ps(-0.f);
+	const __m128 Tolerance = _mm_set1_ps(SkeletonOrientationKernels::DeterminantTolerance);
+	for (; Joint + 4 <= FSkeletonFrame::JointCount; Joint += 4) {
+		const __m128 M00 = _mm_loadu_ps(&Matrices[0][Joint]);
+		const __m128 M01 = _mm_loadu_ps(&Matrices[1][Joint]);
+		const __m128 M02 = _mm_loadu_ps(&Matrices[2][Joint]);
+		const __m128 M10 = _mm_loadu_ps(&Matrices[3][Joint]);
+		const __m128 M11 = _mm_loadu_ps(&Matrices[4][Joint]);
+		const __m128 M12 = _mm_loadu_ps(&Matrices[5][Joint]);
+		const __m128 M20 = _mm_loadu_ps(&Matrices[6][Joint]);
+		const __m128 M21 = _mm_loadu_ps(&Matrices[7][Joint]);
+		const __m128 M22 = _mm_loadu_ps(&Matrices[8][Joint]);
+
+		const __m128 Trace = _mm_add_ps(_mm_add_ps(M00, M11), M22);
+		const __m128 IsW = _mm_cmpgt_ps(Trace, Zero);
+		const __m128 IsX = _mm_andnot_ps(IsW, _mm_and_ps(_mm_cmpgt_ps(M00, M11), _mm_cmpgt_ps(M00, M22)));
+		const __m128 IsY = _mm_andnot_ps(_mm_or_ps(IsW, IsX), _mm_cmpgt_ps(M11, M22));
+		const __m128 Diagonal = Select(IsW, Trace,
+			Select(IsX, _mm_sub_ps(_mm_sub_ps(M00, M11), M22),
+			Select(IsY, _mm_sub_ps(_mm_sub_ps(M11, M00), M22), _mm_sub_ps(_mm_sub_ps(M22, M00), M11))));
+
+		const __m128 S = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(One, Diagonal)), Two);
+		const __m128 InvS = _mm_div_ps(One, S);
+		const __m128 Largest = _mm_mul_ps(Quarter, S);
+		const __m128 WX = _mm_mul_ps(_mm_sub_ps(M21, M12), InvS);
+		const __m128 WY = _mm_mul_ps(_mm_sub_ps(M02, M20), InvS);
+		const __m128 WZ = _mm_mul_ps(_mm_sub_ps(M10, M01), InvS);
+		const __m128 XY = _mm_mul_ps(_mm_add_ps(M01, M10), InvS);
+		const __m128 XZ = _mm_mul_ps(_mm_add_ps(M02, M20), InvS);
+		const __m128 YZ = _mm_mul_ps(_mm_add_ps(M12, M21), InvS);
+
+		const __m128 Determinant = _mm_add_ps(
+			_mm_sub_ps(_mm_mul_ps(M00, _mm_sub_ps(_mm_mul_ps(M11, M22), _mm_mul_ps(M12, M21))), _mm_mul_ps(M01, _mm_sub_ps(_mm_mul_ps(M10, M22), _mm_mul_ps(M12, M20)))),
+			_mm_mul_ps(M02, _mm_sub_ps(_mm_mul_ps(M10, M21), _mm_mul_ps(M11, M20))));
+		const __m128 IsRotation = _mm_cmple_ps(_mm_andnot_ps(SignBit, _mm_sub_ps(Determinant, One)), Tolerance);
+
+		_mm_storeu_ps(&Frame.OrientationX[Joint], Select(IsRotation, Select(IsW, WX, Select(IsX, Largest, Select(IsY, XY, XZ))), Zero));
+		_mm_storeu_ps(&Frame.OrientationY[Joint], Select(IsRotation, Select(IsW, WY, Select(IsX, XY, Select(IsY, Largest, YZ))), Zero));
+		_mm_storeu_ps(&Frame.OrientationZ[Joint], Select(IsRotation, Select(IsW, WZ, Select(IsX, XZ, Select(IsY, YZ, Largest))), Zero));
+		_mm_storeu_ps(&Frame.OrientationW[Joint], Select(IsRotation, Select(IsW, Largest, Select(IsX, WX, Select(IsY, WY, WZ))), One));
+		InvalidJoints += 4 - FMath::CountBits((uint64)_mm_movemask_ps(IsRotation));
+	}
+#endif
+
+	for (; Joint < FSkeletonFrame::JointCount; Joint++) {
+		const bool bRotation = SkeletonOrientationKernels::MatrixToQuaternion(
+			Matrices[0][Joint], Matrices[1][Joint], Matrices[2][Joint],
+			Matrices[3][Joint], Matrices[4][Joint], Matrices[5][Joint],
+			Matrices[6][Joint], Matrices[7][Joint], Matrices[8][Joint],
+			Frame.OrientationX[Joint], Frame.OrientationY[Joint], Frame.OrientationZ[Joint], Frame.OrientationW[Joint]);
+		InvalidJoints += bRotation ? 0 : 1;
+	}
+	return InvalidJoints;
+}
+
+FQuat FSkeletonOrientationKernels::MatrixToQuaternion(const float Matrix[MatrixElements])
+{
+	float X, Y, Z, W;
+	SkeletonOrientationKernels::MatrixToQuaternion(Matrix[0], Matrix[1], Matrix[2], Matrix[3], Matrix[4], Matrix[5], Matrix[6], Matrix[7], Matrix[8], X, Y, Z, W);
+	return FQuat(X, Y, Z, W);
+}
+
+TAU_END_UNFUSED_MATH
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SkeletonFrame.h"
+
+/**
+ * Joint orientation matrices to quaternions for a whole skeleton in one pass.
+ * The input is Nuitrack's Orientation::matrix of every joint, a row-major 3x3 rotation
+ * (m[row * 3 + column]), gathered element by element so each step runs across the joints.
+ * The four cases of the trace method are all evaluated and picked with masks instead of
+ * branches, 4 joints per instruction on x86. A matrix whose determinant is not 1 is not a
+ * rotation, for example an untracked joint's zero matrix or a wrong layout, and its joint
+ * gets the identity.
+ */
+class FSkeletonOrientationKernels
+{
+public:
+	static constexpr int32 MatrixElements = 9;
+
+	// Matrices[Element][Joint] into the frame's orientation columns. Returns the joints whose matrix was not a rotation.
+	static int32 MatricesToQuaternions(const float Matrices[MatrixElements][FSkeletonFrame::JointCount], FSkeletonFrame& Frame);
+
+	// The same conversion for a single matrix
+	static FQuat MatrixToQuaternion(const float Matrix[MatrixElements]);
+};
@@ -0,0 +1,326 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TauAllocationAudit.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/ScopeLock.h"
+
+#if TAU_ALLOCATION_AUDIT
+
+namespace TauAllocationAudit
+{
+	// Open scopes and allocations counted on this thread
+	static thread_local int32 ActiveScopes = 0;
+	static thread_local int64 AllocationCount = 0;
+
+	// Open regions on this thread, and the allocations made inside regions on any thread while a session is open
+	static thread_local int32 ActiveRegions = 0;
+	static volatile int32 bSessionOpen = 0;
+	static volatile int64 SessionCount = 0;
+
+	FORCEINLINE void Count()
+	{
+		if (ActiveScopes > 0) {
+			AllocationCount++;
+		}
+		if (ActiveRegions > 0 && bSessionOpen) {
+			FPlatformAtomics::InterlockedIncrement(&SessionCount);
+		}
+	}
+
+	/**
+	 * Forwards everything to the allocator it replaced and counts Malloc and Realloc calls
+	 * on threads with an open audit scope or region.
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			TauAllocationAudit::Count();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			TauAllocationAudit::Count();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0) {
+				TauAllocationAudit::Count();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0) {
+				TauAllocationAudit::Count();
+			}
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override
+		{
+			Inner->Trim(bTrimThreadCaches);
+		}
+
+		virtual void SetupTLSCachesOnCurrentThread() override
+		{
+			Inner->SetupTLSCachesOnCurrentThread();
+		}
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			Inner->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual void InitializeStatsMetadata() override
+		{
+			Inner->InitializeStatsMetadata();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return Inner->GetDescriptiveName();
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual bool ValidateHeap() override
+		{
+			return Inner->ValidateHeap();
+		}
+
+		virtual void UpdateStats() override
+		{
+			Inner->UpdateStats();
+		}
+
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+		{
+			Inner->GetAllocatorStats(OutStats);
+		}
+
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override
+		{
+			Inner->DumpAllocatorStats(Ar);
+		}
+
+		virtual void OnMallocInitialized() override
+		{
+			Inner->OnMallocInitialized();
+		}
+
+		virtual void OnPreFork() override
+		{
+			Inner->OnPreFork();
+		}
+
+		virtual void OnPostFork() override
+		{
+			Inner->OnPostFork();
+		}
+
+		FMalloc* GetInner() const
+		{
+			return Inner;
+		}
+
+	private:
+		FMalloc* Inner;
+	};
+
+	static FCriticalSection InstallLock;
+	static bool bInstalled = false;
+
+	// Never deleted: a thread that read GMalloc just before Uninstall may still be inside it
+	static FCountingMalloc* Proxy = nullptr;
+}
+
+bool FTauAllocationAuditScope::Install()
+{
+	using namespace TauAllocationAudit;
+	FScopeLock Lock(&InstallLock);
+	if (bInstalled || GMalloc == nullptr) {
+		return false;
+	}
+	if (Proxy == nullptr || Proxy->GetInner() != GMalloc) {
+		Proxy = new FCountingMalloc(GMalloc);
+	}
+	// The proxy forwards every call to the allocator it wraps, so threads that are allocating while
+	// the pointer changes may free through either one
+	FPlatformMisc::MemoryBarrier();
+	GMalloc = Proxy;
+	bInstalled = true;
+	return true;
+}
+
+void FTauAllocationAuditScope::Uninstall()
+{
+	using namespace TauAllocationAudit;
+	FScopeLock Lock(&InstallLock);
+	if (!bInstalled) {
+		return;
+	}
+	if (GMalloc != Proxy) {
+		// Something wrapped GMalloc again after the proxy; unwinding it from under that would drop it
+		UE_LOG(LogTemp, Warning, TEXT("GMalloc was replaced after the allocation audit proxy, leaving the proxy in place"));
+		return;
+	}
+	GMalloc = Proxy->GetInner();
+	FPlatformMisc::MemoryBarrier();
+	bInstalled = false;
+}
+
+FTauAllocationAuditScope::FTauAllocationAuditScope()
+{
+	TauAllocationAudit::ActiveScopes++;
+	StartCount = TauAllocationAudit::AllocationCount;
+}
+
+FTauAllocationAuditScope::~FTauAllocationAuditScope()
+{
+	TauAllocationAudit::ActiveScopes--;
+}
+
+int32 FTauAllocationAuditScope::GetAllocationCount() const
+{
+	return (int32)(TauAllocationAudit::AllocationCount - StartCount);
+}
+
+bool FTauAllocationAuditScope::IsAvailable()
+{
+	return TauAllocationAudit::bInstalled;
+}
+
+FTauAllocationAuditRegion::FTauAllocationAuditRegion()
+{
+	TauAllocationAudit::ActiveRegions++;
+}
+
+FTauAllocationAuditRegion::~FTauAllocationAuditRegion()
+{
+	TauAllocationAudit::ActiveRegions--;
+}
+
+FTauAllocationAuditSession::FTauAllocationAuditSession()
+{
+	check(!TauAllocationAudit::bSessionOpen);
+	FPlatformAtomics::InterlockedExchange(&TauAllocationAudit::SessionCount, 0);
+	FPlatformAtomics::InterlockedExchange(&TauAllocationAudit::bSessionOpen, 1);
+}
+
+FTauAllocationAuditSession::~FTauAllocationAuditSession()
+{
+	FPlatformAtomics::InterlockedExchange(&TauAllocationAudit::bSessionOpen, 0);
+}
+
+int64 FTauAllocationAuditSession::GetAllocationCount() const
+{
+	return FPlatformAtomics::AtomicRead(&TauAllocationAudit::SessionCount);
+}
+
+FTauAllocationAuditPause::FTauAllocationAuditPause()
+	: PausedScopes(TauAllocationAudit::ActiveScopes)
+	, PausedRegions(TauAllocationAudit::ActiveRegions)
+{
+	TauAllocationAudit::ActiveScopes = 0;
+	TauAllocationAudit::ActiveRegions = 0;
+}
+
+FTauAllocationAuditPause::~FTauAllocationAuditPause()
+{
+	TauAllocationAudit::ActiveScopes = PausedScopes;
+	TauAllocationAudit::ActiveRegions = PausedRegions;
+}
+
+#else
+
+FTauAllocationAuditScope::FTauAllocationAuditScope()
+	: StartCount(0)
+{
+}
+
+FTauAllocationAuditScope::~FTauAllocationAuditScope()
+{
+}
+
+int32 FTauAllocationAuditScope::GetAllocationCount() const
+{
+	return 0;
+}
+
+bool FTauAllocationAuditScope::IsAvailable()
+{
+	return false;
+}
+
+bool FTauAllocationAuditScope::Install()
+{
+	return false;
+}
+
+void FTauAllocationAuditScope::Uninstall()
+{
+}
+
+FTauAllocationAuditRegion::FTauAllocationAuditRegion()
+{
+}
+
+FTauAllocationAuditRegion::~FTauAllocationAuditRegion()
+{
+}
+
+FTauAllocationAuditSession::FTauAllocationAuditSession()
+{
+}
+
+FTauAllocationAuditSession::~FTauAllocationAuditSession()
+{
+}
+
+int64 FTauAllocationAuditSession::GetAllocationCount() const
+{
+	return 0;
+}
+
+FTauAllocationAuditPause::FTauAllocationAuditPause()
+	: PausedScopes(0)
+	, PausedRegions(0)
+{
+}
+
+FTauAllocationAuditPause::~FTauAllocationAuditPause()
+{
+}
+
+#endif
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// The audit swaps GMalloc for a counting proxy, which shipping builds never do
+#define TAU_ALLOCATION_AUDIT !UE_BUILD_SHIPPING
+
+/**
+ * Counts the heap allocations the current thread makes while the scope is alive.
+ * Scopes nest; allocations made on other threads are never counted.
+ * In shipping builds the scope compiles to nothing and always reports 0.
+ */
+class TAUSKELETONVISUAL_API FTauAllocationAuditScope
+{
+public:
+	FTauAllocationAuditScope();
+	~FTauAllocationAuditScope();
+
+	// Mallocs and Reallocs made on this thread since the scope opened
+	int32 GetAllocationCount() const;
+
+	// False when the proxy could not be installed and nothing is being counted
+	static bool IsAvailable();
+
+	// Puts the counting proxy over GMalloc on demand: from the allocation automation test, or at startup
+	// with -TauAllocationAudit on the command line. Returns false when it was already installed or cannot be.
+	static bool Install();
+
+	// Puts the allocator the proxy replaced back. Called by whoever installed it, and from ShutdownModule.
+	static void Uninstall();
+
+private:
+	int64 StartCount;
+};
+
+/**
+ * Marks code on the frame path, on whichever thread runs it. Allocations made inside a region
+ * count toward the open FTauAllocationAuditSession. Regions nest.
+ */
+class TAUSKELETONVISUAL_API FTauAllocationAuditRegion
+{
+public:
+	FTauAllocationAuditRegion();
+	~FTauAllocationAuditRegion();
+};
+
+/**
+ * Counts the allocations made inside an FTauAllocationAuditRegion on every thread while alive,
+ * including worker threads and task graph tasks a scope on the game thread never sees.
+ * Only one session may be open at a time.
+ */
+class TAUSKELETONVISUAL_API FTauAllocationAuditSession
+{
+public:
+	FTauAllocationAuditSession();
+	~FTauAllocationAuditSession();
+
+	int64 GetAllocationCount() const;
+};
+
+/**
+ * Stops counting on this thread while alive. Wraps engine calls whose allocations the
+ * module cannot avoid, such as the render command UpdateTextureRegions enqueues.
+ */
+class TAUSKELETONVISUAL_API FTauAllocationAuditPause
+{
+public:
+	FTauAllocationAuditPause();
+	~FTauAllocationAuditPause();
+
+private:
+	int32 PausedScopes;
+	int32 PausedRegions;
+};
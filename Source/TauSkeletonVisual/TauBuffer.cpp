@@ -2,6 +2,7 @@
 
 
 #include "TauBuffer.h"
+#include "TauGestureKernels.h"
 #include "Kismet/KismetMathLibrary.h"
 
 // Sets default values for this component's properties
@@ -11,12 +12,16 @@ UTauBuffer::UTauBuffer()
 	// off to improve performance if you don't need them.
 	IsAngleGrowing = false;
 	IsPositionGrowing = false;
+	FullGestureIsGrowing = false;
 	MeasuringStick = FVector(0);
 	LastMeasuringStick = FVector(0);
 	BeginningPosition = FVector(0);
 	EndingPosition = FVector(0);
 
-	MotionPath.Emplace(BeginningPosition);
+	SampleCapacity = 0;
+	PositionStepSum = 0;
+	PositionPushesSinceResync = 0;
+	NonFiniteSamples = 0;
 
 	BeginningTime = FApp::GetCurrentTime();
 	LastReadingTime = FApp::GetCurrentTime();
@@ -26,6 +31,51 @@ UTauBuffer::UTauBuffer()
 	ElapsedSinceBeginningGestureTime = 0;
 }
 
+void UTauBuffer::Bind(float* FloatSamples, double* DoubleSamples, FVector4* VectorSamples, int32 InSampleCapacity)
+{
+	// A recycled state starts over as if it was just constructed
+	*this = UTauBuffer();
+	check(InSampleCapacity >= 2);
+	SampleCapacity = InSampleCapacity;
+
+	TTauRingBuffer<float>* FloatHistories[FloatHistoryCount - 1] = {
+		&FullGestureAngleChanges, &IncrementalAngleTauSamples, &IncrementalPositionTauSamples, &FullGestureTauSamples,
+		&IncrementalAngleTauDotSamples, &IncrementalPositionTauDotSamples, &FullGestureTauDotSamples,
+		&IncrementalAngleTauDotSmoothedDiffFromLastFrame, &IncrementalPositionTauDotSmoothedDiffFromLastFrame, &FullGestureTauDotSmoothedDiffFromLastFrame
+	};
+	for (int32 History = 0; History < FloatHistoryCount - 1; History++) {
+		FloatHistories[History]->Bind(FloatSamples + History * SampleCapacity, SampleCapacity);
+	}
+	// Summed histories are bound through their own type so their running sums start at zero
+	IncrementalGestureAngleChanges.Bind(FloatSamples + (FloatHistoryCount - 1) * SampleCapacity, SampleCapacity);
+	ElapsedTimeSamples.Bind(DoubleSamples, SampleCapacity);
+	MotionPath.Bind(VectorSamples, SampleCapacity);
+	IncrementalGesturePositionChanges.Bind(VectorSamples + SampleCapacity, SampleCapacity);
+
+	MotionPath.Emplace(BeginningPosition);
+}
+
+
+void UTauBuffer::PushPositionChange(const FVector4& PositionChange)
+{
+	TTauRingBuffer<FVector4>& Changes = IncrementalGesturePositionChanges;
+	if (Changes.IsFull() && Changes.Num() >= 2) {
+		PositionStepSum -= FVector::DistSquared(FVector(Changes[1]), FVector(Changes[0]));
+	}
+	if (Changes.Num() > 0) {
+		PositionStepSum += FVector::DistSquared(FVector(PositionChange), FVector(Changes.Last()));
+	}
+	Changes.Push(PositionChange);
+
+	// Rebuild the sum now and then so rounding from the add/remove pairs cannot build up
+	if (++PositionPushesSinceResync >= TTauSummedRingBuffer<float>::ResyncInterval) {
+		PositionStepSum = 0;
+		for (int32 ii = 1; ii < Changes.Num(); ii++) {
+			PositionStepSum += FVector::DistSquared(FVector(Changes[ii]), FVector(Changes[ii - 1]));
+		}
+		PositionPushesSinceResync = 0;
+	}
+}
 
 void UTauBuffer::CalculateIncrementalGestureChange(int index)
 {
@@ -38,7 +88,7 @@ void UTauBuffer::CalculateIncrementalGestureChange(int index)
 	FVector4 EndingNormal = MotionPath.Last();
 
 	FVector PositionChange = EndingNormal - BeginningNormal;
-	IncrementalGesturePositionChanges.Emplace(PositionChange);
+	PushPositionChange(PositionChange);
 	BeginningNormal = BeginningNormal.GetSafeNormal();
 	EndingNormal = EndingNormal.GetSafeNormal();
 
@@ -47,7 +97,8 @@ void UTauBuffer::CalculateIncrementalGestureChange(int index)
 		UE_LOG(LogTemp, Display, TEXT("Beginning Normal: X:%f Y:%f Z:%f W:%f"), BeginningNormal.X, BeginningNormal.Y, BeginningNormal.Z, BeginningNormal.W);
 	}
 	float CurrentGestureDotProduct = (BeginningNormal.X * EndingNormal.X) + (BeginningNormal.Y * EndingNormal.Y) + (BeginningNormal.Z * EndingNormal.Z);	
-	float AngleChange = UKismetMathLibrary::Acos(CurrentGestureDotProduct);
+	// Rounding can push the dot product of two unit vectors just past 1, where Acos returns NaN
+	float AngleChange = UKismetMathLibrary::Acos(FMath::Clamp(CurrentGestureDotProduct, -1.f, 1.f));
 	if (DebugLog) {
 		UE_LOG(LogTemp, Display, TEXT("Angle Change: %f"), AngleChange);
 	}
@@ -60,19 +111,9 @@ void UTauBuffer::CalculateIncrementalGestureChange(int index)
 
 		if (EndTime > 0) {
 
-			double AverageAngleChange = 0;
-			double AverageTimeElapsed = 0;
-			for (double IncrementalAngleChange : IncrementalGestureAngleChanges)
-			{
-				AverageAngleChange += IncrementalAngleChange;
-			}
-			for (double ElapsedTime : ElapsedTimeSamples)
-			{
-				AverageTimeElapsed += ElapsedTime;
-			}
-
-			AverageAngleChange = AverageAngleChange / IncrementalGestureAngleChanges.Num();
-			AverageTimeElapsed = AverageTimeElapsed / ElapsedTimeSamples.Num();
+			// Running window sums, so the cost does not grow with SampleCapacity
+			double AverageAngleChange = IncrementalGestureAngleChanges.Average();
+			double AverageTimeElapsed = ElapsedTimeSamples.Average();
 			double AverageVelocity = AverageAngleChange / AverageTimeElapsed;
 			if ((AverageVelocity >= 0.1 || AverageVelocity <= -0.1) && (AngleChange >= 0.1 || AngleChange <= -0.1)) {
 				double IncrementalTau = AngleChange / AverageVelocity;
@@ -110,22 +151,9 @@ void UTauBuffer::CalculateIncrementalGestureChange(int index)
 
 		if (EndTime > 0) {
 			double PositionChangeDistance = FVector::Distance(EndingNormal, BeginningNormal);
-			double AveragePositionChange = 0;
-			double AverageTimeElapsed = 0;
-			for (int ii = 1; ii < IncrementalGesturePositionChanges.Num(); ii++) {
-				FVector EndVector = IncrementalGesturePositionChanges[ii];
-				FVector StartVector = IncrementalGesturePositionChanges[ii - 1];
-				double ThisChangeDistance = FVector::DistSquared(EndVector, StartVector);
-				AveragePositionChange += ThisChangeDistance;
-			}
-			
-			for (double ElapsedTime : ElapsedTimeSamples)
-			{
-				AverageTimeElapsed += ElapsedTime;
-			}
-
-			AveragePositionChange = AveragePositionChange / IncrementalGesturePositionChanges.Num();
-			AverageTimeElapsed = AverageTimeElapsed / ElapsedTimeSamples.Num();
+			// Sum of squared steps between consecutive changes, divided by the change count as before
+			double AveragePositionChange = PositionStepSum / IncrementalGesturePositionChanges.Num();
+			double AverageTimeElapsed = ElapsedTimeSamples.Average();
 			double AverageVelocity = AveragePositionChange / AverageTimeElapsed;
 			if ((AverageVelocity >= 0.1 || AverageVelocity <= -0.1) && (PositionChangeDistance >= 0.1 || PositionChangeDistance <= -0.1)) {
 				double IncrementalTau = PositionChangeDistance / AverageVelocity;
@@ -217,4 +245,81 @@ void UTauBuffer::CalculateIncrementalGestureChange(int index)
 	}
 
 	*/
-}
\ No newline at end of file
+}
+
+void UTauBuffer::PrepareGestureChange(FTauGestureStore& Store, int32 Index)
+{
+	if (MotionPath.Num() < 2) {
+		Store.Deactivate(Index);
+		return;
+	}
+
+	const FVector4 PreviousPoint = MotionPath.Last(1);
+	const FVector4 LatestPoint = MotionPath.Last();
+	FVector PositionChange = LatestPoint - PreviousPoint;
+	PushPositionChange(PositionChange);
+
+	Store.BeginX[Index] = PreviousPoint.X;
+	Store.BeginY[Index] = PreviousPoint.Y;
+	Store.BeginZ[Index] = PreviousPoint.Z;
+	Store.EndX[Index] = LatestPoint.X;
+	Store.EndY[Index] = LatestPoint.Y;
+	Store.EndZ[Index] = LatestPoint.Z;
+
+	// The kernel averages the angle changes as they will be once this frame's change is pushed
+	const int32 AngleCount = FMath::Min(IncrementalGestureAngleChanges.Num() + 1, IncrementalGestureAngleChanges.Capacity());
+	Store.AngleSumBase[Index] = IncrementalGestureAngleChanges.SumBeforePush();
+	Store.AngleCount[Index] = AngleCount;
+	Store.TimeAverage[Index] = ElapsedTimeSamples.Average();
+	const double EndTime = ElapsedTimeSamples.Last();
+	Store.EndTime[Index] = EndTime;
+	Store.PositionStepSum[Index] = PositionStepSum;
+	Store.PositionCount[Index] = IncrementalGesturePositionChanges.Num();
+
+	// Which branches CalculateIncrementalGestureChange would take does not depend on the new values
+	uint8 Pushes = FTauGestureStore::PushAngleChange;
+	const bool bHasElapsedPair = ElapsedTimeSamples.Num() >= 2;
+	const bool bAngleTau = AngleCount >= 2 && bHasElapsedPair;
+	const bool bPositionTau = IncrementalGesturePositionChanges.Num() >= 2 && bHasElapsedPair && EndTime > 0;
+	Pushes |= bAngleTau ? FTauGestureStore::PushAngleTau : 0;
+	Pushes |= bPositionTau ? FTauGestureStore::PushPositionTau : 0;
+
+	// After a push the tau dot compares the new sample with the current newest one, otherwise the two newest ones
+	const TTauRingBuffer<float>& AngleTaus = IncrementalAngleTauSamples;
+	const int32 AngleTauCount = bAngleTau ? FMath::Min(AngleTaus.Num() + 1, AngleTaus.Capacity()) : AngleTaus.Num();
+	Store.AngleTauPushed[Index] = bAngleTau ? 1 : 0;
+	Store.AngleTauLast[Index] = !bAngleTau && AngleTaus.Num() > 0 ? AngleTaus.Last() : 0;
+	Store.AngleTauPrevious[Index] = AngleTaus.Num() > (bAngleTau ? 0 : 1) ? AngleTaus.Last(bAngleTau ? 0 : 1) : 0;
+	Pushes |= AngleTauCount > 2 && EndTime > 0 ? FTauGestureStore::PushAngleTauDot : 0;
+
+	const TTauRingBuffer<float>& PositionTaus = IncrementalPositionTauSamples;
+	const int32 PositionTauCount = bPositionTau ? FMath::Min(PositionTaus.Num() + 1, PositionTaus.Capacity()) : PositionTaus.Num();
+	Store.PositionTauPushed[Index] = bPositionTau ? 1 : 0;
+	Store.PositionTauLast[Index] = !bPositionTau && PositionTaus.Num() > 0 ? PositionTaus.Last() : 0;
+	Store.PositionTauPrevious[Index] = PositionTaus.Num() > (bPositionTau ? 0 : 1) ? PositionTaus.Last(bPositionTau ? 0 : 1) : 0;
+	Pushes |= PositionTauCount > 2 && EndTime > 0 ? FTauGestureStore::PushPositionTauDot : 0;
+
+	Store.Pushes[Index] = Pushes;
+}
+
+void UTauBuffer::ApplyGestureChange(const FTauGestureStore& Store, int32 Index)
+{
+	const uint8 Pushes = Store.Pushes[Index];
+	if (Pushes & FTauGestureStore::PushAngleChange) {
+		IncrementalGestureAngleChanges.Emplace(Store.AngleChange[Index]);
+	}
+	if (Pushes & FTauGestureStore::PushAngleTau) {
+		IncrementalAngleTauSamples.Emplace(Store.AngleTau[Index]);
+	}
+	if (Pushes & FTauGestureStore::PushPositionTau) {
+		IncrementalPositionTauSamples.Emplace(Store.PositionTau[Index]);
+	}
+	if (Pushes & FTauGestureStore::PushAngleTauDot) {
+		IncrementalAngleTauDotSamples.Emplace(Store.AngleTauDot[Index]);
+		IsAngleGrowing = (Store.Growing[Index] & FTauGestureStore::AngleGrowing) != 0;
+	}
+	if (Pushes & FTauGestureStore::PushPositionTauDot) {
+		IncrementalPositionTauDotSamples.Emplace(Store.PositionTauDot[Index]);
+		IsPositionGrowing = (Store.Growing[Index] & FTauGestureStore::PositionGrowing) != 0;
+	}
+}
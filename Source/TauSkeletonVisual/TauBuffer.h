@@ -5,7 +5,9 @@
 #include "CoreMinimal.h"
 #include "Math/Vector4.h"
 #include "Math/Vector.h"
+#include "TauRingBuffer.h"
 
+struct FTauGestureStore;
 
 class UTauBuffer 
 {
@@ -14,6 +16,17 @@ public:
 	// Sets default values for this component's properties
 	UTauBuffer();
 
+	// Sample storage each state needs, in runs of SampleCapacity elements
+	static const int32 FloatHistoryCount = 11;
+	static const int32 DoubleHistoryCount = 1;
+	static const int32 VectorHistoryCount = 2;
+
+	// Points the histories at the given runs of storage and starts a fresh gesture
+	void Bind(float* FloatSamples, double* DoubleSamples, FVector4* VectorSamples, int32 InSampleCapacity);
+
+	// Samples every history keeps, the newest one included
+	int32 SampleCapacity;
+
 	bool IsPositionGrowing;
 
 	bool IsAngleGrowing;
@@ -28,31 +41,39 @@ public:
 
 		FVector4 EndingPosition;
 
-		TArray<FVector4> MotionPath;
+		TTauRingBuffer<FVector4> MotionPath;
+
+		TTauRingBuffer<float> FullGestureAngleChanges;
+
+		TTauSummedRingBuffer<float> IncrementalGestureAngleChanges;
 
-		TArray<float> FullGestureAngleChanges;
+		TTauRingBuffer<FVector4> IncrementalGesturePositionChanges;
 
-		TArray<float> IncrementalGestureAngleChanges;
+		// Sum of DistSquared between consecutive IncrementalGesturePositionChanges
+		double PositionStepSum;
 
-		TArray<FVector4> IncrementalGesturePositionChanges;
+		int32 PositionPushesSinceResync;
 
-		TArray<float> IncrementalAngleTauSamples;
+		// Frames whose Euler line or newest tau sample was NaN or Inf since the gesture started
+		int32 NonFiniteSamples;
 
-		TArray<float> IncrementalPositionTauSamples;
+		TTauRingBuffer<float> IncrementalAngleTauSamples;
 
-		TArray<float> FullGestureTauSamples;
+		TTauRingBuffer<float> IncrementalPositionTauSamples;
 
-		TArray<float> IncrementalAngleTauDotSamples;
+		TTauRingBuffer<float> FullGestureTauSamples;
 
-		TArray<float> IncrementalPositionTauDotSamples;
+		TTauRingBuffer<float> IncrementalAngleTauDotSamples;
 
-		TArray<float> FullGestureTauDotSamples;
+		TTauRingBuffer<float> IncrementalPositionTauDotSamples;
 
-		TArray<float> IncrementalAngleTauDotSmoothedDiffFromLastFrame;
+		TTauRingBuffer<float> FullGestureTauDotSamples;
 
-		TArray<float> IncrementalPositionTauDotSmoothedDiffFromLastFrame;
+		TTauRingBuffer<float> IncrementalAngleTauDotSmoothedDiffFromLastFrame;
 
-		TArray<float> FullGestureTauDotSmoothedDiffFromLastFrame;
+		TTauRingBuffer<float> IncrementalPositionTauDotSmoothedDiffFromLastFrame;
+
+		TTauRingBuffer<float> FullGestureTauDotSmoothedDiffFromLastFrame;
 
 		double BeginningTime;
 
@@ -64,7 +85,17 @@ public:
 
 		double ElapsedSinceBeginningGestureTime;
 
-		TArray<double> ElapsedTimeSamples;
+		TTauSummedRingBuffer<double> ElapsedTimeSamples;
 
 		void CalculateIncrementalGestureChange(int index);
+
+		// CalculateIncrementalGestureChange split around FTauGestureKernels: Prepare does the position
+		// change push and gathers this state's windows into row Index of the store, Apply pushes the
+		// kernel's results. Together they update the histories exactly like the per-buffer call.
+		void PrepareGestureChange(FTauGestureStore& Store, int32 Index);
+
+		void ApplyGestureChange(const FTauGestureStore& Store, int32 Index);
+
+		// Pushes a position change and updates PositionStepSum for the pairs entering and leaving the window
+		void PushPositionChange(const FVector4& PositionChange);
 };
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <xmmintrin.h>
+#endif
+
+/**
+ * Sets flush-to-zero and denormals-are-zero on the current thread and restores the previous
+ * mode when it goes out of scope. Denormal operands cost up to a hundred cycles each on x86,
+ * and nothing the tau pipeline computes needs values that small. The scope is per chunk of
+ * work, so task graph threads shared with the engine get their mode back afterwards.
+ * A no-op on other CPUs.
+ */
+class FTauDenormalScope
+{
+public:
+	FORCEINLINE FTauDenormalScope()
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		SavedControl = _mm_getcsr();
+		_mm_setcsr(SavedControl | FlushToZero | DenormalsAreZero);
+#endif
+	}
+
+	FORCEINLINE ~FTauDenormalScope()
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		_mm_setcsr(SavedControl);
+#endif
+	}
+
+private:
+#if PLATFORM_CPU_X86_FAMILY
+	// MXCSR bits
+	static const uint32 FlushToZero = 0x8000;
+	static const uint32 DenormalsAreZero = 0x0040;
+
+	uint32 SavedControl;
+#endif
+};
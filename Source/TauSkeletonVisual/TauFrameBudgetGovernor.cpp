@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TauFrameBudgetGovernor.h"
+
+FTauFrameBudgetGovernor::FTauFrameBudgetGovernor()
+{
+	BudgetMs = 4.f;
+	RestoreFraction = 0.7f;
+	DegradeFrames = 10;
+	RestoreFrames = 90;
+	Reset();
+}
+
+void FTauFrameBudgetGovernor::Reset()
+{
+	Tier = ETauQualityTier::Full;
+	SmoothedCostMs = 0;
+	OverBudgetFrames = 0;
+	UnderBudgetFrames = 0;
+}
+
+bool FTauFrameBudgetGovernor::Update(float CostMs)
+{
+	// Smooth out single spikes, a hitch alone should not cost a tier
+	SmoothedCostMs = SmoothedCostMs > 0 ? FMath::Lerp(SmoothedCostMs, CostMs, 0.1f) : CostMs;
+
+	if (SmoothedCostMs > BudgetMs) {
+		OverBudgetFrames++;
+		UnderBudgetFrames = 0;
+	}
+	else if (SmoothedCostMs < BudgetMs * RestoreFraction) {
+		UnderBudgetFrames++;
+		OverBudgetFrames = 0;
+	}
+	else {
+		OverBudgetFrames = 0;
+		UnderBudgetFrames = 0;
+	}
+
+	if (OverBudgetFrames >= DegradeFrames && Tier != ETauQualityTier::NoDebugGeometry) {
+		Tier = ETauQualityTier((uint8)Tier + 1);
+		OverBudgetFrames = 0;
+		return true;
+	}
+	if (UnderBudgetFrames >= RestoreFrames && Tier != ETauQualityTier::Full) {
+		Tier = ETauQualityTier((uint8)Tier - 1);
+		UnderBudgetFrames = 0;
+		return true;
+	}
+	return false;
+}
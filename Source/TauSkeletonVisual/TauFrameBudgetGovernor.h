@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TauFrameBudgetGovernor.generated.h"
+
+/**
+ * Quality tiers, cheapest last. Every tier keeps the reductions of the tiers above it.
+ */
+UENUM(BlueprintType)
+enum class ETauQualityTier : uint8
+{
+	Full,
+	// Tau is updated on every other sensor frame
+	ReducedRate,
+	// Only the first triangles are tracked
+	ReducedTriangles,
+	// Only some texture slices are rebuilt per update
+	ReducedSlices,
+	// The per-triangle debug vectors are skipped
+	NoDebugGeometry
+};
+
+/**
+ * Steps the tau quality tier down when the measured cost stays over budget and back up
+ * once there is headroom again. Separate frame counts for both directions keep it from
+ * bouncing between two tiers.
+ */
+class FTauFrameBudgetGovernor
+{
+public:
+	FTauFrameBudgetGovernor();
+
+	// Milliseconds per frame the tau work may use
+	float BudgetMs;
+
+	// A tier is restored only while the cost stays below this fraction of the budget
+	float RestoreFraction;
+
+	// Consecutive over-budget frames before dropping a tier
+	int32 DegradeFrames;
+
+	// Consecutive frames with headroom before restoring a tier
+	int32 RestoreFrames;
+
+	// Feeds one frame's measured cost. Returns true when the tier changed.
+	bool Update(float CostMs);
+
+	void Reset();
+
+	ETauQualityTier GetTier() const { return Tier; }
+
+	float GetSmoothedCostMs() const { return SmoothedCostMs; }
+
+	int32 GetOverBudgetFrames() const { return OverBudgetFrames; }
+
+	int32 GetUnderBudgetFrames() const { return UnderBudgetFrames; }
+
+private:
+	ETauQualityTier Tier;
+
+	float SmoothedCostMs;
+
+	int32 OverBudgetFrames;
+
+	int32 UnderBudgetFrames;
+};
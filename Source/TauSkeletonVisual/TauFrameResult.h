@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SkeletonFrame.h"
+
+/**
+ * Everything the calculation thread produces for one skeleton frame.
+ * The worker fills one of these in place and publishes it as a whole, so readers
+ * never combine fields coming from different frames.
+ */
+struct FTauFrameResult
+{
+	// Increases by one for every published frame, 0 means nothing was published yet
+	uint64 Sequence = 0;
+
+	// Time the calculation thread spent computing this frame
+	double ComputeSeconds = 0;
+
+	// Circumcenters recomputed with exact predicates in this frame, see FEulerLineStats
+	int32 RobustCircumcenters = 0;
+
+	int32 ExactPredicates = 0;
+
+	// Triangles the area-ratio test flagged as degenerate, and NaN/Inf samples summed over every tau state
+	int32 DegenerateTriangles = 0;
+
+	int32 NonFiniteSamples = 0;
+
+	// The skeleton this frame was computed from; rotators are built from its quaternions on demand
+	FSkeletonFrame Skeleton;
+
+	TArray<int> TriangleIndexes;
+
+	TArray<FVector> TrianglePositions;
+
+	TArray<FVector> TriangleCentroids;
+
+	TArray<FVector> TriangleCircumcenters;
+
+	TArray<FVector> EulerLines;
+
+	// Per triangle: flagged degenerate this frame, and NaN/Inf samples since its tau state was bound
+	TArray<bool> TriangleDegenerate;
+
+	TArray<int32> TriangleNonFiniteCounts;
+
+	// Last incremental tau samples of every triangle that has one
+	TArray<float> AngleTauSamples;
+
+	TArray<float> AngleTauDotSamples;
+
+	TArray<float> PositionTauSamples;
+
+	TArray<float> PositionTauDotSamples;
+};
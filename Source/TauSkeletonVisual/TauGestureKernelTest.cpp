@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "TauGestureKernels.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauGestureKernelEquivalenceTest, "TauSkeletonVisual.TauKernel.BatchedMatchesPerBuffer",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTauGestureKernelEquivalenceTest::RunTest(const FString& Parameters)
+{
+	// The built-in topology, with ranges that leave every possible remainder behind the widest lane count
+	const int32 TriangleCount = 67;
+	const int32 FrameCount = 300;
+	const int32 SampleCapacity = 4;
+	const int32 RangeSizes[] = { 1, 3, 8, 16, 67 };
+
+	AddInfo(FString::Printf(TEXT("Batched tau path runs %i triangles per instruction"), FTauGestureKernels::GetLaneCount()));
+
+	for (int32 RangeSize : RangeSizes) {
+		// Compares every history and growing flag of the scalar per-buffer update with the SIMD sweep after each frame
+		const FTauGestureBenchmark Result = FTauGestureKernels::Benchmark(TriangleCount, FrameCount, SampleCapacity, RangeSize);
+		if (Result.ComparedSamples == 0) {
+			AddError(FString::Printf(TEXT("Ranges of %i: no samples were compared"), RangeSize));
+		}
+		else if (Result.MismatchedSamples > 0) {
+			AddError(FString::Printf(TEXT("Ranges of %i: %i of %i tau and tau dot samples differ from the per-buffer path"),
+				RangeSize, Result.MismatchedSamples, Result.ComparedSamples));
+		}
+	}
+
+	return !HasAnyErrors();
+}
+
+#endif
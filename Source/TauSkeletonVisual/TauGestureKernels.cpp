@@ -0,0 +1,636 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TauGestureKernels.h"
+#include "TriangleGeometryKernels.h"
+#include "TauStatePool.h"
+#include "Math/RandomStream.h"
+#include "TauSimd.h"
+
+TAU_BEGIN_UNFUSED_MATH
+
+namespace TauGestureKernels
+{
+	// Raw column pointers, so the kernels do not go through TArray bounds checks
+	struct FGestureColumns
+	{
+		const float* BeginX;
+		const float* BeginY;
+		const float* BeginZ;
+		const float* EndX;
+		const float* EndY;
+		const float* EndZ;
+		const double* AngleSumBase;
+		const double* AngleCount;
+		const double* TimeAverage;
+		const double* EndTime;
+		const double* PositionStepSum;
+		const double* PositionCount;
+		const double* AngleTauPushed;
+		const double* PositionTauPushed;
+		const float* AngleTauLast;
+		const float* AngleTauPrevious;
+		const float* PositionTauLast;
+		const float* PositionTauPrevious;
+		float* AngleChange;
+		float* AngleTau;
+		float* PositionTau;
+		float* AngleTauDot;
+		float* PositionTauDot;
+		uint8* Growing;
+
+		explicit FGestureColumns(FTauGestureStore& Store)
+			: BeginX(Store.BeginX.GetData()), BeginY(Store.BeginY.GetData()), BeginZ(Store.BeginZ.GetData())
+			, EndX(Store.EndX.GetData()), EndY(Store.EndY.GetData()), EndZ(Store.EndZ.GetData())
+			, AngleSumBase(Store.AngleSumBase.GetData()), AngleCount(Store.AngleCount.GetData())
+			, TimeAverage(Store.TimeAverage.GetData()), EndTime(Store.EndTime.GetData())
+			, PositionStepSum(Store.PositionStepSum.GetData()), PositionCount(Store.PositionCount.GetData())
+			, AngleTauPushed(Store.AngleTauPushed.GetData()), PositionTauPushed(Store.PositionTauPushed.GetData())
+			, AngleTauLast(Store.AngleTauLast.GetData()), AngleTauPrevious(Store.AngleTauPrevious.GetData())
+			, PositionTauLast(Store.PositionTauLast.GetData()), PositionTauPrevious(Store.PositionTauPrevious.GetData())
+			, AngleChange(Store.AngleChange.GetData()), AngleTau(Store.AngleTau.GetData()), PositionTau(Store.PositionTau.GetData())
+			, AngleTauDot(Store.AngleTauDot.GetData()), PositionTauDot(Store.PositionTauDot.GetData())
+			, Growing(Store.Growing.GetData())
+		{
+		}
+	};
+
+	typedef void (*FGestureKernel)(const FGestureColumns& Columns, int32 Begin, int32 End);
+
+	static constexpr int32 MathModeCount = 3;
+
+	// Thresholds of CalculateIncrementalGestureChange
+	static constexpr double MovingThreshold = 0.1;
+	static constexpr double GrowingThreshold = 0.5;
+
+	// acos(x) = sqrt(1 - x) * P(x) on [0, 1], Abramowitz and Stegun 4.4.46 and 4.4.45, highest degree first
+	static constexpr float AcosApproximateCoefficients[8] = { -0.0012624911f, 0.0066700901f, -0.0170881256f, 0.0308918810f, -0.0501743046f, 0.0889789874f, -0.2145988016f, 1.5707963050f };
+	static constexpr float AcosFastCoefficients[4] = { -0.0187293f, 0.0742610f, -0.2121144f, 1.5707288f };
+
+	template<ETauMathMode Mode>
+	FORCEINLINE float GestureInvSqrt(float X)
+	{
+		if (Mode == ETauMathMode::Precise) {
+			return FMath::InvSqrt(X);
+		}
+#if PLATFORM_CPU_X86_FAMILY
+		// The estimate the SIMD paths start from, so the scalar remainder matches their lanes
+		const float Estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(X)));
+#else
+		const float Estimate = 1.f / FMath::Sqrt(X);
+#endif
+		if (Mode == ETauMathMode::Fast) {
+			return Estimate;
+		}
+		return Estimate + Estimate * (0.5f - (X * 0.5f) * (Estimate * Estimate));
+	}
+
+	// X is already clamped to [-1, 1]. Negative inputs use acos(x) = pi - acos(-x), with the sign applied exactly.
+	template<ETauMathMode Mode>
+	FORCEINLINE float GestureAcos(float X)
+	{
+		if (Mode == ETauMathMode::Precise) {
+			return FMath::Acos(X);
+		}
+		const float* Coefficients = Mode == ETauMathMode::Fast ? AcosFastCoefficients : AcosApproximateCoefficients;
+		const int32 CoefficientCount = Mode == ETauMathMode::Fast ? UE_ARRAY_COUNT(AcosFastCoefficients) : UE_ARRAY_COUNT(AcosApproximateCoefficients);
+		const float Abs = FMath::Max(X, 0.f - X);
+		float Polynomial = Coefficients[0];
+		for (int32 k = 1; k < CoefficientCount; k++) {
+			Polynomial = Polynomial * Abs + Coefficients[k];
+		}
+		const float Root = FMath::Sqrt(1.f - Abs) * Polynomial;
+		const bool bNegative = 0.f > X;
+		return Root * (bNegative ? -1.f : 1.f) + (bNegative ? PI : 0.f);
+	}
+
+	// One triangle at a time, written like the per-buffer code so every path can be checked against it
+	template<ETauMathMode Mode>
+	static void GestureChangesScalar(const FGestureColumns& Columns, int32 Begin, int32 End)
+	{
+		for (int32 i = Begin; i < End; i++) {
+			// FVector4::GetSafeNormal
+			const float BeginSquareSum = Columns.BeginX[i] * Columns.BeginX[i] + Columns.BeginY[i] * Columns.BeginY[i] + Columns.BeginZ[i] * Columns.BeginZ[i];
+			const float BeginScale = BeginSquareSum > SMALL_NUMBER ? GestureInvSqrt<Mode>(BeginSquareSum) : 0.f;
+			const float EndSquareSum = Columns.EndX[i] * Columns.EndX[i] + Columns.EndY[i] * Columns.EndY[i] + Columns.EndZ[i] * Columns.EndZ[i];
+			const float EndScale = EndSquareSum > SMALL_NUMBER ? GestureInvSqrt<Mode>(EndSquareSum) : 0.f;
+			const FVector BeginNormal(Columns.BeginX[i] * BeginScale, Columns.BeginY[i] * BeginScale, Columns.BeginZ[i] * BeginScale);
+			const FVector EndNormal(Columns.EndX[i] * EndScale, Columns.EndY[i] * EndScale, Columns.EndZ[i] * EndScale);
+
+			const float Dot = (BeginNormal.X * EndNormal.X) + (BeginNormal.Y * EndNormal.Y) + (BeginNormal.Z * EndNormal.Z);
+			const float AngleChange = GestureAcos<Mode>(FMath::Clamp(Dot, -1.f, 1.f));
+			const double PositionChangeDistance = FVector::Distance(EndNormal, BeginNormal);
+			Columns.AngleChange[i] = AngleChange;
+
+			const double EndTime = Columns.EndTime[i];
+			const double AngleVelocity = ((Columns.AngleSumBase[i] + (double)AngleChange) / Columns.AngleCount[i]) / Columns.TimeAverage[i];
+			const bool bAngleMoving = EndTime > 0 && (AngleVelocity >= MovingThreshold || AngleVelocity <= -MovingThreshold) && (AngleChange >= MovingThreshold || AngleChange <= -MovingThreshold);
+			const float AngleTau = bAngleMoving ? (float)(AngleChange / AngleVelocity) : 0.f;
+			Columns.AngleTau[i] = AngleTau;
+
+			const double PositionVelocity = (Columns.PositionStepSum[i] / Columns.PositionCount[i]) / Columns.TimeAverage[i];
+			const bool bPositionMoving = (PositionVelocity >= MovingThreshold || PositionVelocity <= -MovingThreshold) && (PositionChangeDistance >= MovingThreshold || PositionChangeDistance <= -MovingThreshold);
+			const float PositionTau = bPositionMoving ? (float)(PositionChangeDistance / PositionVelocity) : 0.f;
+			Columns.PositionTau[i] = PositionTau;
+
+			const double AngleTauEnd = Columns.AngleTauPushed[i] > 0 ? AngleTau : Columns.AngleTauLast[i];
+			const double AngleTauDot = (AngleTauEnd - (double)Columns.AngleTauPrevious[i]) / EndTime;
+			const double PositionTauEnd = Columns.PositionTauPushed[i] > 0 ? PositionTau : Columns.PositionTauLast[i];
+			const double PositionTauDot = (PositionTauEnd - (double)Columns.PositionTauPrevious[i]) / EndTime;
+			Columns.AngleTauDot[i] = (float)AngleTauDot;
+			Columns.PositionTauDot[i] = (float)PositionTauDot;
+			Columns.Growing[i] = (AngleTauDot >= GrowingThreshold ? FTauGestureStore::AngleGrowing : 0) | (PositionTauDot >= GrowingThreshold ? FTauGestureStore::PositionGrowing : 0);
+		}
+	}
+
+#if PLATFORM_CPU_X86_FAMILY
+
+	// GestureChangesScalar over Width lanes at a time; the remainder goes through the scalar loop.
+	// Float lanes are converted to double lanes of the same count, so one iteration covers Width triangles
+	// in both precisions. The masks of the double compares are vectors, or a bit mask on AVX-512.
+	// Mode is a template parameter of the enclosing kernel, so the untaken branches compile away.
+#define TAU_GESTURE_BODY(Width, FVec, LoadF, StoreF, AddF, SubF, MulF, Set1F, MinF, MaxF, RsqrtF, SqrtF, AndF, GreaterF, \
+		DVec, LoadD, AddD, SubD, DivD, Set1D, ToDouble, ToFloat, GreaterEqualD, LessEqualD, GreaterD, AndM, OrM, SelectD, MaskBits) \
+	const FVec HalfF = Set1F(0.5f); \
+	const FVec OneF = Set1F(1.f); \
+	const FVec MinusOneF = Set1F(-1.f); \
+	const FVec Tolerance = Set1F(SMALL_NUMBER); \
+	const FVec ZeroF = Set1F(0.f); \
+	const FVec TwoF = Set1F(2.f); \
+	const FVec PiF = Set1F(PI); \
+	const DVec ZeroD = Set1D(0.0); \
+	const DVec Moving = Set1D(MovingThreshold); \
+	const DVec MinusMoving = Set1D(-MovingThreshold); \
+	const DVec GrowingD = Set1D(GrowingThreshold); \
+	float AcosLanes[Width]; \
+	int32 i = Begin; \
+	for (; i + Width <= End; i += Width) { \
+		const FVec Bx = LoadF(Columns.BeginX + i); \
+		const FVec By = LoadF(Columns.BeginY + i); \
+		const FVec Bz = LoadF(Columns.BeginZ + i); \
+		const FVec Ex = LoadF(Columns.EndX + i); \
+		const FVec Ey = LoadF(Columns.EndY + i); \
+		const FVec Ez = LoadF(Columns.EndZ + i); \
+		const FVec BeginSquareSum = AddF(AddF(MulF(Bx, Bx), MulF(By, By)), MulF(Bz, Bz)); \
+		const FVec EndSquareSum = AddF(AddF(MulF(Ex, Ex), MulF(Ey, Ey)), MulF(Ez, Ez)); \
+		const FVec BeginHalf = MulF(BeginSquareSum, HalfF); \
+		const FVec EndHalf = MulF(EndSquareSum, HalfF); \
+		FVec BeginStep = RsqrtF(BeginSquareSum); \
+		FVec EndStep = RsqrtF(EndSquareSum); \
+		for (int32 Step = Mode == ETauMathMode::Precise ? 2 : (Mode == ETauMathMode::Approximate ? 1 : 0); Step > 0; Step--) { \
+			BeginStep = AddF(BeginStep, MulF(BeginStep, SubF(HalfF, MulF(BeginHalf, MulF(BeginStep, BeginStep))))); \
+			EndStep = AddF(EndStep, MulF(EndStep, SubF(HalfF, MulF(EndHalf, MulF(EndStep, EndStep))))); \
+		} \
+		const FVec BeginScale = AndF(GreaterF(BeginSquareSum, Tolerance), BeginStep); \
+		const FVec EndScale = AndF(GreaterF(EndSquareSum, Tolerance), EndStep); \
+		const FVec Bnx = MulF(Bx, BeginScale); \
+		const FVec Bny = MulF(By, BeginScale); \
+		const FVec Bnz = MulF(Bz, BeginScale); \
+		const FVec Enx = MulF(Ex, EndScale); \
+		const FVec Eny = MulF(Ey, EndScale); \
+		const FVec Enz = MulF(Ez, EndScale); \
+		const FVec Dot = AddF(AddF(MulF(Bnx, Enx), MulF(Bny, Eny)), MulF(Bnz, Enz)); \
+		const FVec Clamped = MaxF(MinusOneF, MinF(Dot, OneF)); \
+		FVec AngleChangeF; \
+		if (Mode == ETauMathMode::Precise) { \
+			StoreF(AcosLanes, Clamped); \
+			for (int32 Lane = 0; Lane < Width; Lane++) { \
+				AcosLanes[Lane] = FMath::Acos(AcosLanes[Lane]); \
+			} \
+			AngleChangeF = LoadF(AcosLanes); \
+		} \
+		else { \
+			const float* Coefficients = Mode == ETauMathMode::Fast ? AcosFastCoefficients : AcosApproximateCoefficients; \
+			const int32 CoefficientCount = Mode == ETauMathMode::Fast ? UE_ARRAY_COUNT(AcosFastCoefficients) : UE_ARRAY_COUNT(AcosApproximateCoefficients); \
+			const FVec Abs = MaxF(Clamped, SubF(ZeroF, Clamped)); \
+			FVec Polynomial = Set1F(Coefficients[0]); \
+			for (int32 k = 1; k < CoefficientCount; k++) { \
+				Polynomial = AddF(MulF(Polynomial, Abs), Set1F(Coefficients[k])); \
+			} \
+			const FVec Root = MulF(SqrtF(SubF(OneF, Abs)), Polynomial); \
+			const FVec Negative = GreaterF(ZeroF, Clamped); \
+			AngleChangeF = AddF(MulF(Root, SubF(OneF, AndF(Negative, TwoF))), AndF(Negative, PiF)); \
+		} \
+		StoreF(Columns.AngleChange + i, AngleChangeF); \
+		const FVec Dx = SubF(Bnx, Enx); \
+		const FVec Dy = SubF(Bny, Eny); \
+		const FVec Dz = SubF(Bnz, Enz); \
+		const DVec PositionChangeDistance = ToDouble(SqrtF(AddF(AddF(MulF(Dx, Dx), MulF(Dy, Dy)), MulF(Dz, Dz)))); \
+		const DVec AngleChange = ToDouble(AngleChangeF); \
+		const DVec EndTime = LoadD(Columns.EndTime + i); \
+		const DVec TimeAverage = LoadD(Columns.TimeAverage + i); \
+		const DVec AngleVelocity = DivD(DivD(AddD(LoadD(Columns.AngleSumBase + i), AngleChange), LoadD(Columns.AngleCount + i)), TimeAverage); \
+		const auto AngleMoving = AndM(AndM(GreaterD(EndTime, ZeroD), OrM(GreaterEqualD(AngleVelocity, Moving), LessEqualD(AngleVelocity, MinusMoving))), \
+			OrM(GreaterEqualD(AngleChange, Moving), LessEqualD(AngleChange, MinusMoving))); \
+		const FVec AngleTau = ToFloat(SelectD(AngleMoving, DivD(AngleChange, AngleVelocity), ZeroD)); \
+		StoreF(Columns.AngleTau + i, AngleTau); \
+		const DVec PositionVelocity = DivD(DivD(LoadD(Columns.PositionStepSum + i), LoadD(Columns.PositionCount + i)), TimeAverage); \
+		const auto PositionMoving = AndM(OrM(GreaterEqualD(PositionVelocity, Moving), LessEqualD(PositionVelocity, MinusMoving)), \
+			OrM(GreaterEqualD(PositionChangeDistance, Moving), LessEqualD(PositionChangeDistance, MinusMoving))); \
+		const FVec PositionTau = ToFloat(SelectD(PositionMoving, DivD(PositionChangeDistance, PositionVelocity), ZeroD)); \
+		StoreF(Columns.PositionTau + i, PositionTau); \
+		const DVec AngleTauEnd = SelectD(GreaterD(LoadD(Columns.AngleTauPushed + i), ZeroD), ToDouble(AngleTau), ToDouble(LoadF(Columns.AngleTauLast + i))); \
+		const DVec AngleTauDot = DivD(SubD(AngleTauEnd, ToDouble(LoadF(Columns.AngleTauPrevious + i))), EndTime); \
+		const DVec PositionTauEnd = SelectD(GreaterD(LoadD(Columns.PositionTauPushed + i), ZeroD), ToDouble(PositionTau), ToDouble(LoadF(Columns.PositionTauLast + i))); \
+		const DVec PositionTauDot = DivD(SubD(PositionTauEnd, ToDouble(LoadF(Columns.PositionTauPrevious + i))), EndTime); \
+		StoreF(Columns.AngleTauDot + i, ToFloat(AngleTauDot)); \
+		StoreF(Columns.PositionTauDot + i, ToFloat(PositionTauDot)); \
+		const uint32 AngleGrowingLanes = MaskBits(GreaterEqualD(AngleTauDot, GrowingD)); \
+		const uint32 PositionGrowingLanes = MaskBits(GreaterEqualD(PositionTauDot, GrowingD)); \
+		for (int32 Lane = 0; Lane < Width; Lane++) { \
+			Columns.Growing[i + Lane] = (uint8)(((AngleGrowingLanes >> Lane) & 1) | (((PositionGrowingLanes >> Lane) & 1) << 1)); \
+		} \
+	} \
+	GestureChangesScalar<Mode>(Columns, i, End);
+
+	// Two floats per iteration on SSE4, moved as one 64-bit lane
+#define TAU_LOAD2_SSE(Pointer) _mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)(Pointer)))
+#define TAU_STORE2_SSE(Pointer, V) _mm_storel_epi64((__m128i*)(Pointer), _mm_castps_si128(V))
+#define TAU_AND_SSE(Mask, V) _mm_and_ps(Mask, V)
+#define TAU_AND_AVX(Mask, V) _mm256_and_ps(Mask, V)
+#define TAU_GREATER_AVX(A, B) _mm256_cmp_ps(A, B, _CMP_GT_OQ)
+	// blendv picks its second operand where the mask is set
+#define TAU_SELECT_SSE(Mask, IfTrue, IfFalse) _mm_blendv_pd(IfFalse, IfTrue, Mask)
+#define TAU_GE_AVX(A, B) _mm256_cmp_pd(A, B, _CMP_GE_OQ)
+#define TAU_LE_AVX(A, B) _mm256_cmp_pd(A, B, _CMP_LE_OQ)
+#define TAU_GT_AVX(A, B) _mm256_cmp_pd(A, B, _CMP_GT_OQ)
+#define TAU_SELECT_AVX(Mask, IfTrue, IfFalse) _mm256_blendv_pd(IfFalse, IfTrue, Mask)
+#define TAU_GE_AVX512(A, B) _mm512_cmp_pd_mask(A, B, _CMP_GE_OQ)
+#define TAU_LE_AVX512(A, B) _mm512_cmp_pd_mask(A, B, _CMP_LE_OQ)
+#define TAU_GT_AVX512(A, B) _mm512_cmp_pd_mask(A, B, _CMP_GT_OQ)
+#define TAU_AND_AVX512(A, B) (__mmask8)((A) & (B))
+#define TAU_OR_AVX512(A, B) (__mmask8)((A) | (B))
+#define TAU_SELECT_AVX512(Mask, IfTrue, IfFalse) _mm512_mask_blend_pd(Mask, IfFalse, IfTrue)
+#define TAU_BITS_AVX512(Mask) (uint32)(Mask)
+
+	template<ETauMathMode Mode>
+	TAU_TARGET("sse4.1")
+	static void GestureChangesSSE4(const FGestureColumns& Columns, int32 Begin, int32 End)
+	{
+		TAU_GESTURE_BODY(2, __m128, TAU_LOAD2_SSE, TAU_STORE2_SSE, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_set1_ps, _mm_min_ps, _mm_max_ps, _mm_rsqrt_ps, _mm_sqrt_ps, TAU_AND_SSE, _mm_cmpgt_ps,
+			__m128d, _mm_loadu_pd, _mm_add_pd, _mm_sub_pd, _mm_div_pd, _mm_set1_pd, _mm_cvtps_pd, _mm_cvtpd_ps, _mm_cmpge_pd, _mm_cmple_pd, _mm_cmpgt_pd, _mm_and_pd, _mm_or_pd, TAU_SELECT_SSE, _mm_movemask_pd)
+	}
+
+	// The float half stays on 128-bit registers, so rsqrt rounds exactly like the SSE InvSqrt
+	template<ETauMathMode Mode>
+	TAU_TARGET("avx2")
+	static void GestureChangesAVX2(const FGestureColumns& Columns, int32 Begin, int32 End)
+	{
+		TAU_GESTURE_BODY(4, __m128, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_set1_ps, _mm_min_ps, _mm_max_ps, _mm_rsqrt_ps, _mm_sqrt_ps, TAU_AND_SSE, _mm_cmpgt_ps,
+			__m256d, _mm256_loadu_pd, _mm256_add_pd, _mm256_sub_pd, _mm256_div_pd, _mm256_set1_pd, _mm256_cvtps_pd, _mm256_cvtpd_ps, TAU_GE_AVX, TAU_LE_AVX, TAU_GT_AVX, _mm256_and_pd, _mm256_or_pd, TAU_SELECT_AVX, _mm256_movemask_pd)
+	}
+
+	// Uses the 256-bit rsqrt rather than rsqrt14, which would round differently from FMath::InvSqrt
+	template<ETauMathMode Mode>
+	TAU_TARGET("avx512f")
+	static void GestureChangesAVX512(const FGestureColumns& Columns, int32 Begin, int32 End)
+	{
+		TAU_GESTURE_BODY(8, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_set1_ps, _mm256_min_ps, _mm256_max_ps, _mm256_rsqrt_ps, _mm256_sqrt_ps, TAU_AND_AVX, TAU_GREATER_AVX,
+			__m512d, _mm512_loadu_pd, _mm512_add_pd, _mm512_sub_pd, _mm512_div_pd, _mm512_set1_pd, _mm512_cvtps_pd, _mm512_cvtpd_ps, TAU_GE_AVX512, TAU_LE_AVX512, TAU_GT_AVX512, TAU_AND_AVX512, TAU_OR_AVX512, TAU_SELECT_AVX512, TAU_BITS_AVX512)
+	}
+
+#undef TAU_LOAD2_SSE
+#undef TAU_STORE2_SSE
+#undef TAU_AND_SSE
+#undef TAU_AND_AVX
+#undef TAU_GREATER_AVX
+#undef TAU_SELECT_SSE
+#undef TAU_GE_AVX
+#undef TAU_LE_AVX
+#undef TAU_GT_AVX
+#undef TAU_SELECT_AVX
+#undef TAU_GE_AVX512
+#undef TAU_LE_AVX512
+#undef TAU_GT_AVX512
+#undef TAU_AND_AVX512
+#undef TAU_OR_AVX512
+#undef TAU_SELECT_AVX512
+#undef TAU_BITS_AVX512
+
+#undef TAU_GESTURE_BODY
+
+#endif
+
+	// Follows the instruction set the triangle geometry kernels detected
+	struct FKernelSelection
+	{
+		// Indexed by ETauMathMode
+		FGestureKernel GestureChanges[MathModeCount];
+		int32 LaneCount;
+
+		FKernelSelection()
+		{
+			const ETriangleKernelPath Path = FTriangleGeometryKernels::GetPath();
+			switch (Path) {
+#if PLATFORM_CPU_X86_FAMILY
+			case ETriangleKernelPath::AVX512:
+				SetKernels(&GestureChangesAVX512<ETauMathMode::Precise>, &GestureChangesAVX512<ETauMathMode::Approximate>, &GestureChangesAVX512<ETauMathMode::Fast>);
+				LaneCount = 8;
+				break;
+			case ETriangleKernelPath::AVX2:
+				SetKernels(&GestureChangesAVX2<ETauMathMode::Precise>, &GestureChangesAVX2<ETauMathMode::Approximate>, &GestureChangesAVX2<ETauMathMode::Fast>);
+				LaneCount = 4;
+				break;
+			case ETriangleKernelPath::SSE4:
+				SetKernels(&GestureChangesSSE4<ETauMathMode::Precise>, &GestureChangesSSE4<ETauMathMode::Approximate>, &GestureChangesSSE4<ETauMathMode::Fast>);
+				LaneCount = 2;
+				break;
+#endif
+			default:
+				SetKernels(&GestureChangesScalar<ETauMathMode::Precise>, &GestureChangesScalar<ETauMathMode::Approximate>, &GestureChangesScalar<ETauMathMode::Fast>);
+				LaneCount = 1;
+				break;
+			}
+			UE_LOG(LogTemp, Display, TEXT("Tau gesture kernel uses the %s path (%i triangles per instruction)"), FTriangleGeometryKernels::GetPathName(Path), LaneCount);
+		}
+
+		void SetKernels(FGestureKernel Precise, FGestureKernel Approximate, FGestureKernel Fast)
+		{
+			GestureChanges[(int32)ETauMathMode::Precise] = Precise;
+			GestureChanges[(int32)ETauMathMode::Approximate] = Approximate;
+			GestureChanges[(int32)ETauMathMode::Fast] = Fast;
+		}
+	};
+
+	static const FKernelSelection& GetSelection()
+	{
+		static const FKernelSelection Selection;
+		return Selection;
+	}
+
+	// Bitwise, so NaN samples compare equal to themselves and -0 differs from 0
+	static void CompareHistories(const TTauRingBuffer<float>& A, const TTauRingBuffer<float>& B, FTauGestureBenchmark& Result)
+	{
+		Result.ComparedSamples += FMath::Max(A.Num(), B.Num());
+		if (A.Num() != B.Num()) {
+			Result.MismatchedSamples += FMath::Max(A.Num(), B.Num());
+			return;
+		}
+		for (int32 ii = 0; ii < A.Num(); ii++) {
+			if (FMemory::Memcmp(&A[ii], &B[ii], sizeof(float)) != 0) {
+				Result.MismatchedSamples++;
+			}
+		}
+	}
+}
+
+void FTauGestureKernels::UpdateGestureChanges(FTauGestureStore& Store, int32 Begin, int32 End, ETauMathMode Mode)
+{
+	check(Begin >= 0 && End <= Store.Num());
+	check((int32)Mode < TauGestureKernels::MathModeCount);
+	if (Begin >= End) {
+		return;
+	}
+	TauGestureKernels::FGestureColumns Columns(Store);
+	TauGestureKernels::GetSelection().GestureChanges[(int32)Mode](Columns, Begin, End);
+}
+
+int32 FTauGestureKernels::GetLaneCount()
+{
+	return TauGestureKernels::GetSelection().LaneCount;
+}
+
+FTauGestureBenchmark FTauGestureKernels::Benchmark(int32 TriangleCount, int32 FrameCount, int32 SampleCapacity, int32 RangeSize)
+{
+	FTauGestureBenchmark Result;
+	Result.Triangles = TriangleCount = FMath::Max(TriangleCount, 1);
+	Result.Frames = FrameCount = FMath::Max(FrameCount, 1);
+	RangeSize = FMath::Max(RangeSize, 1);
+
+	FTauStateBlock PerBuffer;
+	PerBuffer.Allocate(TriangleCount, FMath::Max(SampleCapacity, 2));
+	PerBuffer.ResetStates();
+	FTauStateBlock Batched;
+	Batched.Allocate(TriangleCount, FMath::Max(SampleCapacity, 2));
+	Batched.ResetStates();
+	FTauGestureStore Store;
+	Store.SetNum(TriangleCount);
+	FTauMotionRecording Motion;
+	SynthesizeMotion(Motion, TriangleCount, FrameCount);
+
+	uint64 PerBufferCycles = 0;
+	uint64 BatchedCycles = 0;
+	uint64 SweepCycles = 0;
+	double Time = 0;
+	for (int32 Frame = 0; Frame < FrameCount; Frame++) {
+		const float Elapsed = Motion.ElapsedTimes[Frame];
+		Time += Elapsed;
+		for (int32 i = 0; i < TriangleCount; i++) {
+			const FVector4 Point(Motion.EulerLines[Frame * TriangleCount + i], (float)Time);
+			for (UTauBuffer* Buffer : { &PerBuffer.States[i], &Batched.States[i] }) {
+				Buffer->ElapsedTimeSamples.Emplace(Elapsed);
+				Buffer->MotionPath.Emplace(Point);
+			}
+		}
+
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 i = 0; i < TriangleCount; i++) {
+			PerBuffer.States[i].CalculateIncrementalGestureChange(i);
+		}
+		PerBufferCycles += FPlatformTime::Cycles64() - StartCycles;
+
+		// In ranges like the worker, so a range's states are still in cache when the results are applied
+		StartCycles = FPlatformTime::Cycles64();
+		for (int32 RangeBegin = 0; RangeBegin < TriangleCount; RangeBegin += RangeSize) {
+			const int32 RangeEnd = FMath::Min(RangeBegin + RangeSize, TriangleCount);
+			for (int32 i = RangeBegin; i < RangeEnd; i++) {
+				Batched.States[i].PrepareGestureChange(Store, i);
+			}
+			const uint64 SweepStartCycles = FPlatformTime::Cycles64();
+			UpdateGestureChanges(Store, RangeBegin, RangeEnd);
+			SweepCycles += FPlatformTime::Cycles64() - SweepStartCycles;
+			for (int32 i = RangeBegin; i < RangeEnd; i++) {
+				Batched.States[i].ApplyGestureChange(Store, i);
+			}
+		}
+		BatchedCycles += FPlatformTime::Cycles64() - StartCycles;
+
+		// Every frame, so a difference is caught even when it later leaves the windows
+		for (int32 i = 0; i < TriangleCount; i++) {
+			const UTauBuffer& A = PerBuffer.States[i];
+			const UTauBuffer& B = Batched.States[i];
+			TauGestureKernels::CompareHistories(A.IncrementalGestureAngleChanges, B.IncrementalGestureAngleChanges, Result);
+			TauGestureKernels::CompareHistories(A.IncrementalAngleTauSamples, B.IncrementalAngleTauSamples, Result);
+			TauGestureKernels::CompareHistories(A.IncrementalPositionTauSamples, B.IncrementalPositionTauSamples, Result);
+			TauGestureKernels::CompareHistories(A.IncrementalAngleTauDotSamples, B.IncrementalAngleTauDotSamples, Result);
+			TauGestureKernels::CompareHistories(A.IncrementalPositionTauDotSamples, B.IncrementalPositionTauDotSamples, Result);
+			Result.ComparedSamples += 2;
+			Result.MismatchedSamples += (A.IsAngleGrowing != B.IsAngleGrowing ? 1 : 0) + (A.IsPositionGrowing != B.IsPositionGrowing ? 1 : 0);
+		}
+	}
+	Result.PerBufferSeconds = FPlatformTime::ToSeconds64(PerBufferCycles);
+	Result.BatchedSeconds = FPlatformTime::ToSeconds64(BatchedCycles);
+	Result.SweepSeconds = FPlatformTime::ToSeconds64(SweepCycles);
+	return Result;
+}
+
+void FTauGestureKernels::SynthesizeMotion(FTauMotionRecording& Recording, int32 TriangleCount, int32 FrameCount)
+{
+	Recording.Reserve(TriangleCount, FrameCount);
+	FRandomStream Random(0x7A5);
+	TArray<FVector> Positions;
+	Positions.SetNumUninitialized(Recording.Triangles);
+	for (FVector& Position : Positions) {
+		Position = Random.GetUnitVector() * Random.FRandRange(1.f, 60.f);
+	}
+	for (int32 Frame = 0; Frame < Recording.FrameCapacity; Frame++) {
+		// A zero delta now and then takes the branches for a frame without elapsed time
+		Recording.ElapsedTimes.Add(Frame % 97 == 5 ? 0.f : Random.FRandRange(0.012f, 0.022f));
+		for (FVector& Position : Positions) {
+			const float Step = Random.FRand() < 0.2f ? 0.f : Random.FRandRange(0.f, 8.f);
+			Position += Random.GetUnitVector() * Step;
+			Recording.EulerLines.Add(Position);
+		}
+	}
+	Recording.RecordedFrames.Set(Recording.Num());
+}
+
+FColor FTauGestureKernels::SampleColor(float Sample, float ClampMin, float ClampMax)
+{
+	// Negative samples fade from blue to green, positive ones from blue to red
+	if (Sample < 0) {
+		const float Value = FMath::Clamp(255.f * ((Sample - ClampMin) / (0.f - ClampMin)), 0.f, 255.f);
+		return FColor(0, uint8(Value), 255 - uint8(Value), 255);
+	}
+	const float Value = FMath::Clamp(255.f * (Sample / ClampMax), 0.f, 255.f);
+	return FColor(uint8(Value), 0, 255 - uint8(Value), 255);
+}
+
+namespace TauGestureKernels
+{
+	// Largest and root mean square difference of a series of samples
+	struct FErrorAccumulator
+	{
+		double Max = 0;
+		double SquareSum = 0;
+		int64 Count = 0;
+
+		void Add(double Difference)
+		{
+			Max = FMath::Max(Max, FMath::Abs(Difference));
+			SquareSum += Difference * Difference;
+			Count++;
+		}
+
+		float Rms() const
+		{
+			return Count > 0 ? (float)FMath::Sqrt(SquareSum / Count) : 0.f;
+		}
+	};
+
+	struct FValidationErrors
+	{
+		FErrorAccumulator Tau;
+		FErrorAccumulator TauDot;
+		FErrorAccumulator Color;
+		int32 ColorTolerance = 0;
+		int32 ColorOutliers = 0;
+		int32 NonFiniteMismatches = 0;
+
+		void AddSample(FErrorAccumulator& Accumulator, float Precise, float Approximated, float ClampMin, float ClampMax)
+		{
+			const bool bPreciseFinite = FMath::IsFinite(Precise);
+			if (bPreciseFinite != FMath::IsFinite(Approximated)) {
+				NonFiniteMismatches++;
+				return;
+			}
+			if (!bPreciseFinite) {
+				return;
+			}
+			Accumulator.Add((double)Approximated - (double)Precise);
+			const FColor PreciseColor = FTauGestureKernels::SampleColor(Precise, ClampMin, ClampMax);
+			const FColor ApproximatedColor = FTauGestureKernels::SampleColor(Approximated, ClampMin, ClampMax);
+			const int32 ColorDifference = FMath::Max3(FMath::Abs(PreciseColor.R - ApproximatedColor.R), FMath::Abs(PreciseColor.G - ApproximatedColor.G), FMath::Abs(PreciseColor.B - ApproximatedColor.B));
+			Color.Add(ColorDifference);
+			ColorOutliers += ColorDifference > ColorTolerance ? 1 : 0;
+		}
+	};
+}
+
+FTauMathValidation FTauGestureKernels::ValidateMathMode(ETauMathMode Mode, const FTauMotionRecording& Motion, int32 SampleCapacity, float ClampMin, float ClampMax, int32 ColorTolerance, float OutlierFraction)
+{
+	FTauMathValidation Result;
+	Result.Mode = Mode;
+	const int32 TriangleCount = Motion.Triangles;
+	const int32 FrameCount = Motion.Num();
+	Result.Frames = FrameCount;
+	if (TriangleCount == 0 || FrameCount == 0) {
+		return Result;
+	}
+
+	FTauStateBlock PreciseStates;
+	PreciseStates.Allocate(TriangleCount, FMath::Max(SampleCapacity, 2));
+	PreciseStates.ResetStates();
+	FTauStateBlock ModeStates;
+	ModeStates.Allocate(TriangleCount, FMath::Max(SampleCapacity, 2));
+	ModeStates.ResetStates();
+	FTauGestureStore PreciseStore;
+	PreciseStore.SetNum(TriangleCount);
+	FTauGestureStore ModeStore;
+	ModeStore.SetNum(TriangleCount);
+
+	// Each path keeps its own state, so differences that carry over through the windows are measured too
+	TauGestureKernels::FValidationErrors Errors;
+	Errors.ColorTolerance = ColorTolerance;
+	double Time = 0;
+	for (int32 Frame = 0; Frame < FrameCount; Frame++) {
+		const float Elapsed = Motion.ElapsedTimes[Frame];
+		Time += Elapsed;
+		for (int32 i = 0; i < TriangleCount; i++) {
+			const FVector& EulerLine = Motion.EulerLines[Frame * TriangleCount + i];
+			UTauBuffer& Precise = PreciseStates.States[i];
+			UTauBuffer& Approximated = ModeStates.States[i];
+			Precise.ElapsedTimeSamples.Emplace(Elapsed);
+			Approximated.ElapsedTimeSamples.Emplace(Elapsed);
+			// Skipped like the calculation thread skips them
+			if (EulerLine.ContainsNaN()) {
+				PreciseStore.Deactivate(i);
+				ModeStore.Deactivate(i);
+				continue;
+			}
+			const FVector4 Point(EulerLine, (float)Time);
+			Precise.MotionPath.Emplace(Point);
+			Approximated.MotionPath.Emplace(Point);
+			Precise.PrepareGestureChange(PreciseStore, i);
+			Approximated.PrepareGestureChange(ModeStore, i);
+		}
+
+		UpdateGestureChanges(PreciseStore, 0, TriangleCount, ETauMathMode::Precise);
+		UpdateGestureChanges(ModeStore, 0, TriangleCount, Mode);
+
+		// Which samples are pushed depends only on the sample counts, so both stores push the same ones
+		for (int32 i = 0; i < TriangleCount; i++) {
+			const uint8 Pushes = PreciseStore.Pushes[i];
+			if (Pushes & FTauGestureStore::PushAngleTau) {
+				Errors.AddSample(Errors.Tau, PreciseStore.AngleTau[i], ModeStore.AngleTau[i], ClampMin, ClampMax);
+			}
+			if (Pushes & FTauGestureStore::PushPositionTau) {
+				Errors.AddSample(Errors.Tau, PreciseStore.PositionTau[i], ModeStore.PositionTau[i], ClampMin, ClampMax);
+			}
+			if (Pushes & FTauGestureStore::PushAngleTauDot) {
+				Errors.AddSample(Errors.TauDot, PreciseStore.AngleTauDot[i], ModeStore.AngleTauDot[i], ClampMin, ClampMax);
+				Result.GrowingMismatches += (PreciseStore.Growing[i] ^ ModeStore.Growing[i]) & FTauGestureStore::AngleGrowing ? 1 : 0;
+			}
+			if (Pushes & FTauGestureStore::PushPositionTauDot) {
+				Errors.AddSample(Errors.TauDot, PreciseStore.PositionTauDot[i], ModeStore.PositionTauDot[i], ClampMin, ClampMax);
+				Result.GrowingMismatches += (PreciseStore.Growing[i] ^ ModeStore.Growing[i]) & FTauGestureStore::PositionGrowing ? 1 : 0;
+			}
+			PreciseStates.States[i].ApplyGestureChange(PreciseStore, i);
+			ModeStates.States[i].ApplyGestureChange(ModeStore, i);
+		}
+	}
+
+	Result.ComparedSamples = (int32)(Errors.Tau.Count + Errors.TauDot.Count) + Errors.NonFiniteMismatches;
+	Result.MaxTauError = (float)Errors.Tau.Max;
+	Result.RmsTauError = Errors.Tau.Rms();
+	Result.MaxTauDotError = (float)Errors.TauDot.Max;
+	Result.RmsTauDotError = Errors.TauDot.Rms();
+	Result.MaxColorError = (int32)Errors.Color.Max;
+	Result.RmsColorError = Errors.Color.Rms();
+	Result.ColorOutliers = Errors.ColorOutliers;
+	Result.NonFiniteMismatches = Errors.NonFiniteMismatches;
+	Result.bSafe = Result.ColorOutliers <= OutlierFraction * Result.ComparedSamples && Result.NonFiniteMismatches == 0;
+	return Result;
+}
+
+TAU_END_UNFUSED_MATH
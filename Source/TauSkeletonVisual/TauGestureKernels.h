@@ -0,0 +1,289 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TriangleGeometryStore.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "TauGestureKernels.generated.h"
+
+/**
+ * Arithmetic the tau kernel uses for the unit vectors and the angle between them.
+ * The approximations only run on the batched path.
+ */
+UENUM(BlueprintType)
+enum class ETauMathMode : uint8
+{
+	// Same bits as the per-buffer code: FMath::InvSqrt and libm acos
+	Precise,
+	// rsqrt with one Newton step (relative error below 3e-7) and an 8 term acos polynomial (below 5e-7 rad)
+	Approximate,
+	// The bare rsqrt estimate (relative error below 4e-4) and a 4 term acos polynomial (below 7e-5 rad)
+	Fast
+};
+
+/**
+ * Inputs and outputs of one incremental gesture update per triangle, stored column-wise.
+ * UTauBuffer::PrepareGestureChange gathers everything that lives in the ring buffers,
+ * the kernel does the arithmetic for a whole range at once, and
+ * UTauBuffer::ApplyGestureChange pushes the results back. Owned by the worker and reused
+ * every frame.
+ */
+struct FTauGestureStore
+{
+	// Bits of Pushes: which histories ApplyGestureChange writes for the triangle
+	static const uint8 PushAngleChange = 1 << 0;
+	static const uint8 PushAngleTau = 1 << 1;
+	static const uint8 PushPositionTau = 1 << 2;
+	static const uint8 PushAngleTauDot = 1 << 3;
+	static const uint8 PushPositionTauDot = 1 << 4;
+
+	// Bits of Growing
+	static const uint8 AngleGrowing = 1 << 0;
+	static const uint8 PositionGrowing = 1 << 1;
+
+	// Previous and newest motion path point
+	FTriangleFloatArray BeginX;
+	FTriangleFloatArray BeginY;
+	FTriangleFloatArray BeginZ;
+	FTriangleFloatArray EndX;
+	FTriangleFloatArray EndY;
+	FTriangleFloatArray EndZ;
+
+	// Angle change window sum before this frame's change is added, and its count after
+	FTriangleDoubleArray AngleSumBase;
+	FTriangleDoubleArray AngleCount;
+
+	// Elapsed time window average and newest sample
+	FTriangleDoubleArray TimeAverage;
+	FTriangleDoubleArray EndTime;
+
+	FTriangleDoubleArray PositionStepSum;
+	FTriangleDoubleArray PositionCount;
+
+	// 1 when this frame pushes an angle tau sample, whose value then becomes the newest one for the tau dot
+	FTriangleDoubleArray AngleTauPushed;
+	FTriangleDoubleArray PositionTauPushed;
+
+	// Newest tau sample and the one the tau dot subtracts, as the history will look after this frame's push
+	FTriangleFloatArray AngleTauLast;
+	FTriangleFloatArray AngleTauPrevious;
+	FTriangleFloatArray PositionTauLast;
+	FTriangleFloatArray PositionTauPrevious;
+
+	FTriangleFlagArray Pushes;
+
+	// Kernel outputs
+	FTriangleFloatArray AngleChange;
+	FTriangleFloatArray AngleTau;
+	FTriangleFloatArray PositionTau;
+	FTriangleFloatArray AngleTauDot;
+	FTriangleFloatArray PositionTauDot;
+	FTriangleFlagArray Growing;
+
+	int32 Num() const
+	{
+		return Pushes.Num();
+	}
+
+	// Keeps the allocations when the count does not grow
+	void SetNum(int32 Count)
+	{
+		FTriangleFloatArray* FloatColumns[] = {
+			&BeginX, &BeginY, &BeginZ, &EndX, &EndY, &EndZ,
+			&AngleTauLast, &AngleTauPrevious, &PositionTauLast, &PositionTauPrevious,
+			&AngleChange, &AngleTau, &PositionTau, &AngleTauDot, &PositionTauDot
+		};
+		for (FTriangleFloatArray* Column : FloatColumns) {
+			Column->SetNumUninitialized(Count, false);
+		}
+		FTriangleDoubleArray* DoubleColumns[] = {
+			&AngleSumBase, &AngleCount, &TimeAverage, &EndTime, &PositionStepSum, &PositionCount, &AngleTauPushed, &PositionTauPushed
+		};
+		for (FTriangleDoubleArray* Column : DoubleColumns) {
+			Column->SetNumUninitialized(Count, false);
+		}
+		Pushes.SetNumUninitialized(Count, false);
+		Growing.SetNumUninitialized(Count, false);
+	}
+
+	// Fills the triangle's inputs with harmless values and pushes nothing for it
+	void Deactivate(int32 Index)
+	{
+		BeginX[Index] = BeginY[Index] = BeginZ[Index] = 0;
+		EndX[Index] = EndY[Index] = EndZ[Index] = 0;
+		AngleSumBase[Index] = 0;
+		AngleCount[Index] = 1;
+		TimeAverage[Index] = 1;
+		EndTime[Index] = 1;
+		PositionStepSum[Index] = 0;
+		PositionCount[Index] = 1;
+		AngleTauPushed[Index] = PositionTauPushed[Index] = 0;
+		AngleTauLast[Index] = AngleTauPrevious[Index] = 0;
+		PositionTauLast[Index] = PositionTauPrevious[Index] = 0;
+		Pushes[Index] = 0;
+	}
+};
+
+/**
+ * Euler lines of every triangle over consecutive frames, for replaying the tau update offline.
+ * The calculation thread fills it up to its frame capacity, after which it no longer changes
+ * and can be read from other threads.
+ */
+struct FTauMotionRecording
+{
+	int32 Triangles = 0;
+
+	int32 FrameCapacity = 0;
+
+	// Frame after frame, Triangles entries each
+	TArray<FVector> EulerLines;
+
+	TArray<float> ElapsedTimes;
+
+	FThreadSafeCounter RecordedFrames;
+
+	// Allocates everything up front, so recording never allocates on the calculation thread
+	void Reserve(int32 InTriangles, int32 InFrameCapacity)
+	{
+		Triangles = FMath::Max(InTriangles, 0);
+		FrameCapacity = FMath::Max(InFrameCapacity, 0);
+		EulerLines.Reset(Triangles * FrameCapacity);
+		ElapsedTimes.Reset(FrameCapacity);
+		RecordedFrames.Reset();
+	}
+
+	bool IsComplete() const
+	{
+		return FrameCapacity > 0 && RecordedFrames.GetValue() == FrameCapacity;
+	}
+
+	int32 Num() const
+	{
+		return ElapsedTimes.Num();
+	}
+
+	// Calculation thread only. Frames with a different triangle count are skipped.
+	void AddFrame(const FTriangleGeometryStore& Geometry, float ElapsedTime)
+	{
+		if (Num() >= FrameCapacity || Geometry.Num() != Triangles) {
+			return;
+		}
+		for (int32 i = 0; i < Triangles; i++) {
+			EulerLines.Add(Geometry.EulerLines.Get(i));
+		}
+		ElapsedTimes.Add(ElapsedTime);
+		RecordedFrames.Set(Num());
+	}
+};
+
+// Differences between the precise tau update and one math mode over the same motion
+USTRUCT(BlueprintType)
+struct FTauMathValidation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		ETauMathMode Mode = ETauMathMode::Precise;
+
+	// False when the motion was synthetic because there was no complete recording
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		bool bRecordedMotion = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 Frames = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 ComparedSamples = 0;
+
+	// Angle and position tau together
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float MaxTauError = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float RmsTauError = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float MaxTauDotError = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float RmsTauDotError = 0;
+
+	// In 8-bit levels of the largest channel difference of the texture colors
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 MaxColorError = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		float RmsColorError = 0;
+
+	// Samples whose color moved by more than the tolerance. A sample that crosses 0 jumps from green
+	// to blue, so any approximation has a few of these and the maximum alone says little.
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 ColorOutliers = 0;
+
+	// Growing flags that differ, and samples finite on one path only
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 GrowingMismatches = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		int32 NonFiniteMismatches = 0;
+
+	// Outliers stayed within the allowed share of the compared samples and no sample became non-finite
+	UPROPERTY(BlueprintReadOnly, Category = "NuitrackSkeletonJointBuffer")
+		bool bSafe = false;
+};
+
+// Timings of the two tau paths over the same synthetic motion
+struct FTauGestureBenchmark
+{
+	int32 Triangles = 0;
+
+	int32 Frames = 0;
+
+	double PerBufferSeconds = 0;
+
+	// Prepare, sweep and apply together, and the kernel sweep alone
+	double BatchedSeconds = 0;
+
+	double SweepSeconds = 0;
+
+	// History samples and growing flags compared after each frame, and those that differ between the paths
+	int32 ComparedSamples = 0;
+
+	int32 MismatchedSamples = 0;
+};
+
+/**
+ * Batched form of UTauBuffer::CalculateIncrementalGestureChange: angle change, angle and
+ * position tau, both tau dots and the growing flags for a range of triangles per sweep.
+ * The float part runs as wide as the double part on the same path: 2 triangles per
+ * instruction on SSE4, 4 on AVX2 and 8 on AVX-512. In the precise mode every step rounds
+ * like the per-buffer code, including the two Newton steps of FMath::InvSqrt on x86, and
+ * Acos stays the libm call per lane, so both paths produce the same bits. The other modes
+ * keep the whole sweep in registers; the scalar path computes them the same way, so every
+ * instruction set still agrees.
+ */
+class FTauGestureKernels
+{
+public:
+	static void UpdateGestureChanges(FTauGestureStore& Store, int32 Begin, int32 End, ETauMathMode Mode = ETauMathMode::Precise);
+
+	// Triangles one instruction handles on the selected path
+	static int32 GetLaneCount();
+
+	// Feeds TriangleCount random walks through both paths for FrameCount frames, the batched one in
+	// ranges of RangeSize triangles, and compares every history after each frame
+	static FTauGestureBenchmark Benchmark(int32 TriangleCount, int32 FrameCount, int32 SampleCapacity, int32 RangeSize);
+
+	// Random walks with pauses and jumps, so every threshold of the tau update is crossed both ways
+	static void SynthesizeMotion(FTauMotionRecording& Recording, int32 TriangleCount, int32 FrameCount);
+
+	// Replays the motion through the precise update and through Mode, each with its own tau state, and compares
+	// every pushed sample and its texture color. Mode is safe when at most OutlierFraction of the samples change
+	// color by more than ColorTolerance levels.
+	static FTauMathValidation ValidateMathMode(ETauMathMode Mode, const FTauMotionRecording& Motion, int32 SampleCapacity,
+		float ClampMin, float ClampMax, int32 ColorTolerance, float OutlierFraction);
+
+	// The texture color UNuitrackSkeletonJointBuffer::FillColors gives a sample
+	static FColor SampleColor(float Sample, float ClampMin, float ClampMax);
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+#include "NuitrackSkeletonJointBuffer.h"
+#include "TauGestureKernels.h"
+#include "TauTriangleTopology.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauMathModeValidationTest, "TauSkeletonVisual.TauKernel.MathModeValidation",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTauMathModeValidationTest::RunTest(const FString& Parameters)
+{
+	const int32 TriangleCount = FTauCompiledTopology::GetDefault()->TriangleCount;
+	const int32 SampleCapacity = 4;
+
+	FTauMotionRecording Motion;
+	FTauGestureKernels::SynthesizeMotion(Motion, TriangleCount, 600);
+
+	// The precise mode against itself must agree to the bit, even with no tolerance at all
+	const FTauMathValidation Precise = FTauGestureKernels::ValidateMathMode(ETauMathMode::Precise, Motion, SampleCapacity, -1, 1, 0, 0.f);
+	TestTrue(TEXT("Precise mode compared samples"), Precise.ComparedSamples > 0);
+	TestEqual(TEXT("Precise mode color outliers"), Precise.ColorOutliers, 0);
+	TestEqual(TEXT("Precise mode non-finite mismatches"), Precise.NonFiniteMismatches, 0);
+	TestTrue(TEXT("Precise mode is safe"), Precise.bSafe);
+
+	// The bare rsqrt estimate moves some samples by at least one color level, so a zero tolerance rejects it
+	const FTauMathValidation Fast = FTauGestureKernels::ValidateMathMode(ETauMathMode::Fast, Motion, SampleCapacity, -1, 1, 0, 0.f);
+	TestTrue(TEXT("Fast mode compared samples"), Fast.ComparedSamples > 0);
+	TestTrue(TEXT("Fast mode changes colors"), Fast.ColorOutliers > 0);
+	TestFalse(TEXT("Fast mode is safe with no tolerance"), Fast.bSafe);
+
+	// The joint buffer must keep running the precise update whenever the selected mode has not passed
+	UNuitrackSkeletonJointBuffer* Buffer = NewObject<UNuitrackSkeletonJointBuffer>(GetTransientPackage());
+	Buffer->AddToRoot();
+
+	Buffer->TauMathMode = ETauMathMode::Fast;
+	TestEqual(TEXT("Unvalidated mode falls back"), Buffer->GetSafeTauMathMode(), ETauMathMode::Precise);
+
+	Buffer->TauMathColorTolerance = 0;
+	Buffer->TauMathOutlierFraction = 0.f;
+	TestFalse(TEXT("Fast mode validates with no tolerance"), Buffer->ValidateTauMathMode());
+	TestEqual(TEXT("Rejected mode falls back"), Buffer->GetSafeTauMathMode(), ETauMathMode::Precise);
+
+	// Any color may change, so validation only fails on a non-finite mismatch
+	Buffer->TauMathMode = ETauMathMode::Approximate;
+	Buffer->TauMathColorTolerance = 255;
+	Buffer->TauMathOutlierFraction = 1.f;
+	TestTrue(TEXT("Approximate mode validates with full tolerance"), Buffer->ValidateTauMathMode());
+	TestEqual(TEXT("Validated mode is used"), Buffer->GetSafeTauMathMode(), ETauMathMode::Approximate);
+
+	// The validation belongs to the mode it ran for, switching without running it again goes back to precise
+	Buffer->TauMathMode = ETauMathMode::Fast;
+	TestEqual(TEXT("Mode switched after validation falls back"), Buffer->GetSafeTauMathMode(), ETauMathMode::Precise);
+
+	Buffer->RemoveFromRoot();
+
+	return !HasAnyErrors();
+}
+
+#endif
@@ -0,0 +1,380 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TauPredicates.h"
+#include "TauSimd.h"
+
+// The error-free transformations below rely on every operation being rounded on its own
+TAU_BEGIN_UNFUSED_MATH
+
+namespace TauPredicates
+{
+	// 2^ceil(53 / 2) + 1, splits a double into two non-overlapping 26-bit halves
+	static constexpr double Splitter = 134217729.0;
+
+	static constexpr double CcwErrBoundA = (3.0 + 16.0 * DoubleEpsilon) * DoubleEpsilon;
+	static constexpr double O3dErrBoundA = (7.0 + 56.0 * DoubleEpsilon) * DoubleEpsilon;
+
+	// Shewchuk's bounds only certify the sign. Requiring the result to clear them by this factor
+	// also keeps its relative error below 2^-20, which the circumcenter needs from its denominator.
+	static constexpr double AccuracyMargin = 1048576.0;
+
+	// x + y == a + b exactly, given |a| >= |b|
+	static FORCEINLINE void FastTwoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		const double bvirt = x - a;
+		y = b - bvirt;
+	}
+
+	// x + y == a + b exactly
+	static FORCEINLINE void TwoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		const double bvirt = x - a;
+		const double avirt = x - bvirt;
+		const double bround = b - bvirt;
+		const double around = a - avirt;
+		y = around + bround;
+	}
+
+	// Roundoff y of an already computed x = a - b
+	static FORCEINLINE void TwoDiffTail(double a, double b, double x, double& y)
+	{
+		const double bvirt = a - x;
+		const double avirt = x + bvirt;
+		const double bround = bvirt - b;
+		const double around = a - avirt;
+		y = around + bround;
+	}
+
+	// x + y == a - b exactly
+	static FORCEINLINE void TwoDiff(double a, double b, double& x, double& y)
+	{
+		x = a - b;
+		TwoDiffTail(a, b, x, y);
+	}
+
+	static FORCEINLINE void Split(double a, double& hi, double& lo)
+	{
+		const double c = Splitter * a;
+		const double abig = c - a;
+		hi = c - abig;
+		lo = a - hi;
+	}
+
+	// x + y == a * b exactly, with b already split
+	static FORCEINLINE void TwoProductPresplit(double a, double b, double bhi, double blo, double& x, double& y)
+	{
+		x = a * b;
+		double ahi, alo;
+		Split(a, ahi, alo);
+		const double err1 = x - (ahi * bhi);
+		const double err2 = err1 - (alo * bhi);
+		const double err3 = err2 - (ahi * blo);
+		y = (alo * blo) - err3;
+	}
+
+	// x + y == a * b exactly
+	static FORCEINLINE void TwoProduct(double a, double b, double& x, double& y)
+	{
+		double bhi, blo;
+		Split(b, bhi, blo);
+		TwoProductPresplit(a, b, bhi, blo, x, y);
+	}
+
+	// (a1 + a0) - (b1 + b0) as the four-component expansion x, smallest component first
+	static FORCEINLINE void TwoTwoDiff(double a1, double a0, double b1, double b0, double x[4])
+	{
+		double i, j, k;
+		TwoDiff(a0, b0, i, x[0]);
+		TwoSum(a1, i, j, k);
+		double l;
+		TwoDiff(k, b1, l, x[1]);
+		TwoSum(j, l, x[3], x[2]);
+	}
+
+	// h = e + f for nonoverlapping expansions, dropping zero components. Returns the length of h.
+	static int32 FastExpansionSumZeroElim(int32 elen, const double* e, int32 flen, const double* f, double* h)
+	{
+		int32 eindex = 0;
+		int32 findex = 0;
+		double enow = e[0];
+		double fnow = f[0];
+		double Q;
+		if ((fnow > enow) == (fnow > -enow)) {
+			Q = enow;
+			eindex++;
+		}
+		else {
+			Q = fnow;
+			findex++;
+		}
+
+		int32 hindex = 0;
+		double Qnew, hh;
+		if (eindex < elen && findex < flen) {
+			enow = e[eindex];
+			fnow = f[findex];
+			if ((fnow > enow) == (fnow > -enow)) {
+				FastTwoSum(enow, Q, Qnew, hh);
+				eindex++;
+			}
+			else {
+				FastTwoSum(fnow, Q, Qnew, hh);
+				findex++;
+			}
+			Q = Qnew;
+			if (hh != 0.0) {
+				h[hindex++] = hh;
+			}
+			while (eindex < elen && findex < flen) {
+				enow = e[eindex];
+				fnow = f[findex];
+				if ((fnow > enow) == (fnow > -enow)) {
+					TwoSum(Q, enow, Qnew, hh);
+					eindex++;
+				}
+				else {
+					TwoSum(Q, fnow, Qnew, hh);
+					findex++;
+				}
+				Q = Qnew;
+				if (hh != 0.0) {
+					h[hindex++] = hh;
+				}
+			}
+		}
+		while (eindex < elen) {
+			TwoSum(Q, e[eindex++], Qnew, hh);
+			Q = Qnew;
+			if (hh != 0.0) {
+				h[hindex++] = hh;
+			}
+		}
+		while (findex < flen) {
+			TwoSum(Q, f[findex++], Qnew, hh);
+			Q = Qnew;
+			if (hh != 0.0) {
+				h[hindex++] = hh;
+			}
+		}
+		if (Q != 0.0 || hindex == 0) {
+			h[hindex++] = Q;
+		}
+		return hindex;
+	}
+
+	// h = e * b, dropping zero components. Returns the length of h.
+	static int32 ScaleExpansionZeroElim(int32 elen, const double* e, double b, double* h)
+	{
+		double bhi, blo;
+		Split(b, bhi, blo);
+		double Q, hh;
+		TwoProductPresplit(e[0], b, bhi, blo, Q, hh);
+		int32 hindex = 0;
+		if (hh != 0.0) {
+			h[hindex++] = hh;
+		}
+		for (int32 eindex = 1; eindex < elen; eindex++) {
+			double product1, product0, sum;
+			TwoProductPresplit(e[eindex], b, bhi, blo, product1, product0);
+			TwoSum(Q, product0, sum, hh);
+			if (hh != 0.0) {
+				h[hindex++] = hh;
+			}
+			FastTwoSum(product1, sum, Q, hh);
+			if (hh != 0.0) {
+				h[hindex++] = hh;
+			}
+		}
+		if (Q != 0.0 || hindex == 0) {
+			h[hindex++] = Q;
+		}
+		return hindex;
+	}
+
+	static double Estimate(int32 elen, const double* e)
+	{
+		double Q = e[0];
+		for (int32 eindex = 1; eindex < elen; eindex++) {
+			Q += e[eindex];
+		}
+		return Q;
+	}
+
+	// Exact (a - c) x (b - c), including the roundoff of the coordinate differences
+	static double Orient2DExact(const double* pa, const double* pb, const double* pc)
+	{
+		const double acx = pa[0] - pc[0];
+		const double bcx = pb[0] - pc[0];
+		const double acy = pa[1] - pc[1];
+		const double bcy = pb[1] - pc[1];
+
+		double detleft, detlefttail, detright, detrighttail;
+		TwoProduct(acx, bcy, detleft, detlefttail);
+		TwoProduct(acy, bcx, detright, detrighttail);
+
+		double B[4];
+		TwoTwoDiff(detleft, detlefttail, detright, detrighttail, B);
+
+		double acxtail, bcxtail, acytail, bcytail;
+		TwoDiffTail(pa[0], pc[0], acx, acxtail);
+		TwoDiffTail(pb[0], pc[0], bcx, bcxtail);
+		TwoDiffTail(pa[1], pc[1], acy, acytail);
+		TwoDiffTail(pb[1], pc[1], bcy, bcytail);
+
+		// The differences were exact, so B already is the exact determinant
+		if (acxtail == 0.0 && acytail == 0.0 && bcxtail == 0.0 && bcytail == 0.0) {
+			return Estimate(4, B);
+		}
+
+		double s1, s0, t1, t0;
+		double u[4];
+		double C1[8], C2[12], D[16];
+
+		TwoProduct(acxtail, bcy, s1, s0);
+		TwoProduct(acytail, bcx, t1, t0);
+		TwoTwoDiff(s1, s0, t1, t0, u);
+		const int32 C1Length = FastExpansionSumZeroElim(4, B, 4, u, C1);
+
+		TwoProduct(acx, bcytail, s1, s0);
+		TwoProduct(acy, bcxtail, t1, t0);
+		TwoTwoDiff(s1, s0, t1, t0, u);
+		const int32 C2Length = FastExpansionSumZeroElim(C1Length, C1, 4, u, C2);
+
+		TwoProduct(acxtail, bcytail, s1, s0);
+		TwoProduct(acytail, bcxtail, t1, t0);
+		TwoTwoDiff(s1, s0, t1, t0, u);
+		const int32 DLength = FastExpansionSumZeroElim(C2Length, C2, 4, u, D);
+
+		return Estimate(DLength, D);
+	}
+
+	double Orient2D(const double* pa, const double* pb, const double* pc, bool* bOutExact)
+	{
+		if (bOutExact) {
+			*bOutExact = false;
+		}
+
+		const double detleft = (pa[0] - pc[0]) * (pb[1] - pc[1]);
+		const double detright = (pa[1] - pc[1]) * (pb[0] - pc[0]);
+		const double det = detleft - detright;
+
+		// Products of opposite sign cannot cancel, so the plain result is already accurate
+		double detsum;
+		if (detleft > 0.0) {
+			if (detright <= 0.0) {
+				return det;
+			}
+			detsum = detleft + detright;
+		}
+		else if (detleft < 0.0) {
+			if (detright >= 0.0) {
+				return det;
+			}
+			detsum = -detleft - detright;
+		}
+		else {
+			return det;
+		}
+
+		const double errbound = CcwErrBoundA * AccuracyMargin * detsum;
+		if (det >= errbound || -det >= errbound) {
+			return det;
+		}
+
+		if (bOutExact) {
+			*bOutExact = true;
+		}
+		return Orient2DExact(pa, pb, pc);
+	}
+
+	// Exact determinant from 2x2 minors of the absolute coordinates
+	static double Orient3DExact(const double* pa, const double* pb, const double* pc, const double* pd)
+	{
+		auto Minor = [](const double* p, const double* q, double Out[4]) {
+			double pxqy1, pxqy0, qxpy1, qxpy0;
+			TwoProduct(p[0], q[1], pxqy1, pxqy0);
+			TwoProduct(q[0], p[1], qxpy1, qxpy0);
+			TwoTwoDiff(pxqy1, pxqy0, qxpy1, qxpy0, Out);
+		};
+
+		double ab[4], bc[4], cd[4], da[4], ac[4], bd[4];
+		Minor(pa, pb, ab);
+		Minor(pb, pc, bc);
+		Minor(pc, pd, cd);
+		Minor(pd, pa, da);
+		Minor(pa, pc, ac);
+		Minor(pb, pd, bd);
+
+		double temp8[8];
+		double cda[12], dab[12], abc[12], bcd[12];
+		int32 templen = FastExpansionSumZeroElim(4, cd, 4, da, temp8);
+		const int32 cdalen = FastExpansionSumZeroElim(templen, temp8, 4, ac, cda);
+		templen = FastExpansionSumZeroElim(4, da, 4, ab, temp8);
+		const int32 dablen = FastExpansionSumZeroElim(templen, temp8, 4, bd, dab);
+		for (int32 i = 0; i < 4; i++) {
+			bd[i] = -bd[i];
+			ac[i] = -ac[i];
+		}
+		templen = FastExpansionSumZeroElim(4, ab, 4, bc, temp8);
+		const int32 abclen = FastExpansionSumZeroElim(templen, temp8, 4, ac, abc);
+		templen = FastExpansionSumZeroElim(4, bc, 4, cd, temp8);
+		const int32 bcdlen = FastExpansionSumZeroElim(templen, temp8, 4, bd, bcd);
+
+		double adet[24], bdet[24], cdet[24], ddet[24];
+		const int32 alen = ScaleExpansionZeroElim(bcdlen, bcd, pa[2], adet);
+		const int32 blen = ScaleExpansionZeroElim(cdalen, cda, -pb[2], bdet);
+		const int32 clen = ScaleExpansionZeroElim(dablen, dab, pc[2], cdet);
+		const int32 dlen = ScaleExpansionZeroElim(abclen, abc, -pd[2], ddet);
+
+		double abdet[48], cddet[48], deter[96];
+		const int32 ablen = FastExpansionSumZeroElim(alen, adet, blen, bdet, abdet);
+		const int32 cdlen = FastExpansionSumZeroElim(clen, cdet, dlen, ddet, cddet);
+		const int32 deterlen = FastExpansionSumZeroElim(ablen, abdet, cdlen, cddet, deter);
+
+		return Estimate(deterlen, deter);
+	}
+
+	double Orient3D(const double* pa, const double* pb, const double* pc, const double* pd, bool* bOutExact)
+	{
+		if (bOutExact) {
+			*bOutExact = false;
+		}
+
+		const double adx = pa[0] - pd[0];
+		const double bdx = pb[0] - pd[0];
+		const double cdx = pc[0] - pd[0];
+		const double ady = pa[1] - pd[1];
+		const double bdy = pb[1] - pd[1];
+		const double cdy = pc[1] - pd[1];
+		const double adz = pa[2] - pd[2];
+		const double bdz = pb[2] - pd[2];
+		const double cdz = pc[2] - pd[2];
+
+		const double bdxcdy = bdx * cdy;
+		const double cdxbdy = cdx * bdy;
+		const double cdxady = cdx * ady;
+		const double adxcdy = adx * cdy;
+		const double adxbdy = adx * bdy;
+		const double bdxady = bdx * ady;
+
+		const double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+
+		const double permanent = (FMath::Abs(bdxcdy) + FMath::Abs(cdxbdy)) * FMath::Abs(adz)
+			+ (FMath::Abs(cdxady) + FMath::Abs(adxcdy)) * FMath::Abs(bdz)
+			+ (FMath::Abs(adxbdy) + FMath::Abs(bdxady)) * FMath::Abs(cdz);
+		const double errbound = O3dErrBoundA * AccuracyMargin * permanent;
+		if (det > errbound || -det > errbound) {
+			return det;
+		}
+
+		if (bOutExact) {
+			*bOutExact = true;
+		}
+		return Orient3DExact(pa, pb, pc, pd);
+	}
+}
+
+TAU_END_UNFUSED_MATH
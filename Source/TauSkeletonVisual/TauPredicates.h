@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Adaptive-precision geometric predicates after Shewchuk, "Adaptive Precision Floating-Point
+ * Arithmetic and Fast Robust Geometric Predicates" (http://www.cs.cmu.edu/~quake/robust.html).
+ * Each one evaluates the determinant in plain doubles first and only falls back to exact
+ * expansion arithmetic when the rounding error bound is not far enough below the result.
+ * Either way the value is correct in sign and has a relative error below 2^-20.
+ */
+namespace TauPredicates
+{
+	// (a - c) x (b - c): positive when a, b, c run counterclockwise, 0 when collinear.
+	// bOutExact is set when the fast filter failed and the exact evaluation ran.
+	double Orient2D(const double* pa, const double* pb, const double* pc, bool* bOutExact = nullptr);
+
+	// Determinant of (a - d, b - d, c - d): positive when d lies below the plane through a, b, c
+	// as seen with a, b, c counterclockwise.
+	double Orient3D(const double* pa, const double* pb, const double* pc, const double* pd, bool* bOutExact = nullptr);
+
+	// Half an ulp of 1, the rounding unit the error bounds are expressed in
+	constexpr double DoubleEpsilon = 1.1102230246251565e-16;	// 2^-53
+	constexpr float FloatEpsilon = 5.9604644775390625e-8f;		// 2^-24
+
+	// Rounding error bound of a 2x2 determinant evaluated directly in float: its sign is certain
+	// once |det| exceeds this times (|left product| + |right product|)
+	constexpr float FloatOrient2DErrorBound = (3.f + 16.f * FloatEpsilon) * FloatEpsilon;
+}
@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-capacity sample history over storage owned elsewhere, normally a FTauStateBlock slab.
+ * Once the history is full every Push overwrites the oldest sample, so pushing never moves or
+ * allocates memory, and the buffer itself is a trivially copyable header.
+ * Indexing and iteration go from the oldest sample to the newest one, like the TArray
+ * histories this replaces.
+ */
+template<typename T>
+class TTauRingBuffer
+{
+public:
+	// Points the history at InCapacity elements of InStorage and drops all samples
+	void Bind(T* InStorage, int32 InCapacity)
+	{
+		check(InStorage != nullptr && InCapacity > 0);
+		Storage = InStorage;
+		StorageSize = InCapacity;
+		Reset();
+	}
+
+	void Reset()
+	{
+		Head = 0;
+		Count = 0;
+	}
+
+	FORCEINLINE int32 Num() const
+	{
+		return Count;
+	}
+
+	FORCEINLINE int32 Capacity() const
+	{
+		return StorageSize;
+	}
+
+	FORCEINLINE bool IsFull() const
+	{
+		return Count == StorageSize;
+	}
+
+	// Appends a sample, overwriting the oldest one when full
+	FORCEINLINE void Push(const T& Value)
+	{
+		checkSlow(StorageSize > 0);
+		Storage[Head] = Value;
+		Head = (Head + 1 == StorageSize) ? 0 : Head + 1;
+		if (Count < StorageSize) {
+			Count++;
+		}
+	}
+
+	// Same as Push, keeps call sites that used TArray::Emplace readable
+	FORCEINLINE void Emplace(const T& Value)
+	{
+		Push(Value);
+	}
+
+	// Index 0 is the oldest sample
+	FORCEINLINE const T& operator[](int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < Count);
+		return Storage[WrapIndex(Head - Count + Index)];
+	}
+
+	FORCEINLINE T& operator[](int32 Index)
+	{
+		checkSlow(Index >= 0 && Index < Count);
+		return Storage[WrapIndex(Head - Count + Index)];
+	}
+
+	// Last() is the newest sample, Last(1) the one before it
+	FORCEINLINE const T& Last(int32 IndexFromTheEnd = 0) const
+	{
+		checkSlow(IndexFromTheEnd >= 0 && IndexFromTheEnd < Count);
+		return Storage[WrapIndex(Head - 1 - IndexFromTheEnd)];
+	}
+
+	template<typename BufferType, typename ElementType>
+	class TIterator
+	{
+	public:
+		TIterator(BufferType& InBuffer, int32 InIndex)
+			: Buffer(InBuffer)
+			, Index(InIndex)
+		{
+		}
+
+		FORCEINLINE ElementType& operator*() const
+		{
+			return Buffer[Index];
+		}
+
+		FORCEINLINE TIterator& operator++()
+		{
+			Index++;
+			return *this;
+		}
+
+		FORCEINLINE bool operator!=(const TIterator& Other) const
+		{
+			return Index != Other.Index;
+		}
+
+	private:
+		BufferType& Buffer;
+		int32 Index;
+	};
+
+	typedef TIterator<TTauRingBuffer, T> FIterator;
+	typedef TIterator<const TTauRingBuffer, const T> FConstIterator;
+
+	FORCEINLINE FIterator begin() { return FIterator(*this, 0); }
+	FORCEINLINE FIterator end() { return FIterator(*this, Count); }
+	FORCEINLINE FConstIterator begin() const { return FConstIterator(*this, 0); }
+	FORCEINLINE FConstIterator end() const { return FConstIterator(*this, Count); }
+
+private:
+	FORCEINLINE int32 WrapIndex(int32 Index) const
+	{
+		return Index < 0 ? Index + StorageSize : (Index >= StorageSize ? Index - StorageSize : Index);
+	}
+
+	T* Storage = nullptr;
+
+	int32 StorageSize = 0;
+
+	// Slot the next Push writes
+	int32 Head = 0;
+
+	int32 Count = 0;
+};
+
+/**
+ * Ring buffer that keeps the sum of its samples, so averages over the window cost O(1)
+ * regardless of capacity. The sum is kept in double and rebuilt from the samples every
+ * ResyncInterval pushes, which bounds the drift from adding and removing samples to
+ * about 1e-12 of the sum for non-negative samples such as times and angle changes.
+ */
+template<typename T>
+class TTauSummedRingBuffer : public TTauRingBuffer<T>
+{
+	typedef TTauRingBuffer<T> Super;
+
+public:
+	static const int32 ResyncInterval = 1024;
+
+	void Bind(T* InStorage, int32 InCapacity)
+	{
+		Super::Bind(InStorage, InCapacity);
+		RunningSum = 0;
+		PushesSinceResync = 0;
+	}
+
+	void Reset()
+	{
+		Super::Reset();
+		RunningSum = 0;
+		PushesSinceResync = 0;
+	}
+
+	FORCEINLINE void Push(const T& Value)
+	{
+		if (Super::IsFull()) {
+			RunningSum -= (double)(*this)[0];
+		}
+		Super::Push(Value);
+		RunningSum += (double)Value;
+		if (++PushesSinceResync >= ResyncInterval) {
+			Resync();
+		}
+	}
+
+	FORCEINLINE void Emplace(const T& Value)
+	{
+		Push(Value);
+	}
+
+	FORCEINLINE double Sum() const
+	{
+		return RunningSum;
+	}
+
+	// Mean of the samples in the window, 0 when empty
+	FORCEINLINE double Average() const
+	{
+		return Super::Num() > 0 ? RunningSum / Super::Num() : 0;
+	}
+
+	// The sum the next Push adds its value to: the running sum without the sample it evicts,
+	// or the rebuilt sum of the kept samples when that Push resyncs. Lets a batched update
+	// compute the average after a push, bit for bit, before the push happens.
+	double SumBeforePush() const
+	{
+		if (PushesSinceResync + 1 >= ResyncInterval) {
+			double Sum = 0;
+			for (int32 ii = Super::IsFull() ? 1 : 0; ii < Super::Num(); ii++) {
+				Sum += (double)(*this)[ii];
+			}
+			return Sum;
+		}
+		return Super::IsFull() ? RunningSum - (double)(*this)[0] : RunningSum;
+	}
+
+	// Rebuilds the sum from the stored samples
+	void Resync()
+	{
+		RunningSum = 0;
+		for (const T& Value : *this) {
+			RunningSum += (double)Value;
+		}
+		PushesSinceResync = 0;
+	}
+
+private:
+	double RunningSum = 0;
+
+	int32 PushesSinceResync = 0;
+};
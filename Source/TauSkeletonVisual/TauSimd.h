@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Shared setup of the batched kernel translation units
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC emits any intrinsic without per-function target flags
+#define TAU_TARGET(Features)
+#else
+#include <cpuid.h>
+#define TAU_TARGET(Features) __attribute__((target(Features)))
+#endif
+#endif
+
+// Keep multiply-adds unfused, so every path rounds like the scalar one. A kernel .cpp opens the
+// region after its includes and closes it at its end, so in a unity build the setting does not
+// carry over into the files appended after it.
+#if defined(__clang__)
+#define TAU_BEGIN_UNFUSED_MATH _Pragma("float_control(push)") _Pragma("clang fp contract(off)")
+#define TAU_END_UNFUSED_MATH _Pragma("float_control(pop)")
+#elif defined(__GNUC__)
+#define TAU_BEGIN_UNFUSED_MATH _Pragma("GCC push_options") _Pragma("GCC optimize(\"fp-contract=off\")")
+#define TAU_END_UNFUSED_MATH _Pragma("GCC pop_options")
+#elif defined(_MSC_VER)
+// fp_contract has no push, and on is the default under the engine's /fp:fast
+#define TAU_BEGIN_UNFUSED_MATH __pragma(fp_contract(off))
+#define TAU_END_UNFUSED_MATH __pragma(fp_contract(on))
+#else
+#define TAU_BEGIN_UNFUSED_MATH
+#define TAU_END_UNFUSED_MATH
+#endif
@@ -2,5 +2,26 @@
 
 #include "TauSkeletonVisual.h"
 #include "Modules/ModuleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "TauAllocationAudit.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, TauSkeletonVisual, "TauSkeletonVisual" );
+class FTauSkeletonVisualModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// Opt-in, so normal runs and the editor keep the engine's allocator untouched
+		if (FParse::Param(FCommandLine::Get(), TEXT("TauAllocationAudit"))) {
+			FTauAllocationAuditScope::Install();
+		}
+	}
+
+	virtual void ShutdownModule() override
+	{
+		// The proxy's code goes away with the module, so GMalloc must not point at it after hot reload or unload
+		FTauAllocationAuditScope::Uninstall();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FTauSkeletonVisualModule, TauSkeletonVisual, "TauSkeletonVisual" );
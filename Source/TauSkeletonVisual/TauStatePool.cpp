@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TauStatePool.h"
+#include "Misc/ScopeLock.h"
+
+void FTauStateBlock::Allocate(int32 InTriangleCount, int32 InSampleCapacity)
+{
+	TriangleCount = InTriangleCount;
+	SampleCapacity = InSampleCapacity;
+	States.SetNum(TriangleCount);
+	FloatSamples.SetNumZeroed(TriangleCount * SampleCapacity * UTauBuffer::FloatHistoryCount);
+	DoubleSamples.SetNumZeroed(TriangleCount * SampleCapacity * UTauBuffer::DoubleHistoryCount);
+	VectorSamples.SetNumZeroed(TriangleCount * SampleCapacity * UTauBuffer::VectorHistoryCount);
+}
+
+void FTauStateBlock::ResetStates()
+{
+	for (int32 i = 0; i < TriangleCount; i++) {
+		States[i].Bind(
+			FloatSamples.GetData() + i * SampleCapacity * UTauBuffer::FloatHistoryCount,
+			DoubleSamples.GetData() + i * SampleCapacity * UTauBuffer::DoubleHistoryCount,
+			VectorSamples.GetData() + i * SampleCapacity * UTauBuffer::VectorHistoryCount,
+			SampleCapacity);
+	}
+}
+
+SIZE_T FTauStateBlock::GetAllocatedSize() const
+{
+	return States.GetAllocatedSize() + FloatSamples.GetAllocatedSize() + DoubleSamples.GetAllocatedSize() + VectorSamples.GetAllocatedSize();
+}
+
+FTauStateHandle FTauStatePool::Acquire(int32 TriangleCount, int32 SampleCapacity)
+{
+	SampleCapacity = FMath::Max(SampleCapacity, 2);
+	FTauStateHandle Handle;
+	FTauStateBlock* Block = nullptr;
+	{
+		FScopeLock Lock(&PoolLock);
+		int32 EmptySlot = INDEX_NONE;
+		int32 MismatchedSlot = INDEX_NONE;
+		for (int32 Index = 0; Index < Slots.Num() && Block == nullptr; Index++) {
+			FSlot& Slot = Slots[Index];
+			if (Slot.bLeased) {
+				continue;
+			}
+			if (Slot.Block.IsValid() && Slot.Block->TriangleCount == TriangleCount && Slot.Block->SampleCapacity == SampleCapacity) {
+				Handle.Index = Index;
+				Block = Slot.Block.Get();
+			}
+			else if (!Slot.Block.IsValid()) {
+				EmptySlot = EmptySlot == INDEX_NONE ? Index : EmptySlot;
+			}
+			else {
+				MismatchedSlot = MismatchedSlot == INDEX_NONE ? Index : MismatchedSlot;
+			}
+		}
+
+		if (Block == nullptr) {
+			// A free block of another layout is replaced before the pool grows
+			Handle.Index = EmptySlot != INDEX_NONE ? EmptySlot : (MismatchedSlot != INDEX_NONE ? MismatchedSlot : Slots.AddDefaulted());
+			Slots[Handle.Index].Block = MakeUnique<FTauStateBlock>();
+			Block = Slots[Handle.Index].Block.Get();
+			Block->Allocate(TriangleCount, SampleCapacity);
+			UE_LOG(LogTemp, Display, TEXT("Tau state pool: allocated block %i for %i triangles, %i samples (%llu bytes)"),
+				Handle.Index, TriangleCount, SampleCapacity, (uint64)Block->GetAllocatedSize());
+		}
+		Slots[Handle.Index].bLeased = true;
+		Handle.Generation = Slots[Handle.Index].Generation;
+	}
+
+	// The block is leased now, so it can be reset outside the lock
+	Block->ResetStates();
+	return Handle;
+}
+
+void FTauStatePool::Release(FTauStateHandle& Handle)
+{
+	if (!Handle.IsValid()) {
+		return;
+	}
+	FScopeLock Lock(&PoolLock);
+	if (Slots.IsValidIndex(Handle.Index) && Slots[Handle.Index].Generation == Handle.Generation) {
+		Slots[Handle.Index].bLeased = false;
+		Slots[Handle.Index].Generation++;
+	}
+	Handle = FTauStateHandle();
+}
+
+FTauStateBlock* FTauStatePool::Resolve(const FTauStateHandle& Handle)
+{
+	FScopeLock Lock(&PoolLock);
+	if (!Handle.IsValid() || !Slots.IsValidIndex(Handle.Index)) {
+		return nullptr;
+	}
+	FSlot& Slot = Slots[Handle.Index];
+	return (Slot.bLeased && Slot.Generation == Handle.Generation) ? Slot.Block.Get() : nullptr;
+}
+
+void FTauStatePool::Trim()
+{
+	FScopeLock Lock(&PoolLock);
+	for (FSlot& Slot : Slots) {
+		if (!Slot.bLeased) {
+			Slot.Block.Reset();
+		}
+	}
+}
+
+int32 FTauStatePool::GetBlockCount()
+{
+	FScopeLock Lock(&PoolLock);
+	int32 Count = 0;
+	for (const FSlot& Slot : Slots) {
+		Count += Slot.Block.IsValid() ? 1 : 0;
+	}
+	return Count;
+}
+
+int32 FTauStatePool::GetLeasedBlockCount()
+{
+	FScopeLock Lock(&PoolLock);
+	int32 Count = 0;
+	for (const FSlot& Slot : Slots) {
+		Count += Slot.bLeased ? 1 : 0;
+	}
+	return Count;
+}
+
+SIZE_T FTauStatePool::GetAllocatedSize()
+{
+	FScopeLock Lock(&PoolLock);
+	SIZE_T Size = 0;
+	for (const FSlot& Slot : Slots) {
+		Size += Slot.Block.IsValid() ? Slot.Block->GetAllocatedSize() : 0;
+	}
+	return Size;
+}
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+#include "Templates/IsTriviallyDestructible.h"
+#include "HAL/CriticalSection.h"
+#include "TauBuffer.h"
+
+static_assert(TIsTriviallyDestructible<UTauBuffer>::Value, "Pooled tau state must not own memory");
+
+/**
+ * Tau state of every triangle one user tracks, in a single contiguous array.
+ * The histories point into the block's sample slabs, so the whole block is allocated once
+ * and recycled as a unit.
+ */
+struct FTauStateBlock
+{
+	int32 TriangleCount = 0;
+
+	int32 SampleCapacity = 0;
+
+	TArray<UTauBuffer> States;
+
+	TArray<float> FloatSamples;
+
+	TArray<double> DoubleSamples;
+
+	TArray<FVector4> VectorSamples;
+
+	// Allocates the slabs for the given layout
+	void Allocate(int32 InTriangleCount, int32 InSampleCapacity);
+
+	// Rebinds every state to its slab runs, dropping all samples
+	void ResetStates();
+
+	SIZE_T GetAllocatedSize() const;
+};
+
+/**
+ * Identifies a leased block. The generation changes on every release, so a stale handle
+ * resolves to nothing instead of another user's state.
+ */
+struct FTauStateHandle
+{
+	int32 Index = INDEX_NONE;
+
+	uint32 Generation = 0;
+
+	bool IsValid() const
+	{
+		return Index != INDEX_NONE;
+	}
+};
+
+/**
+ * Owns the tau state blocks of all tracked users. Blocks are allocated when a user starts
+ * tracking, go back to the free list when the user is lost, and are handed to the next user
+ * with the same layout instead of being reallocated. All memory is freed with the pool.
+ * Acquire, Release and Resolve are thread safe; a leased block belongs to its holder only.
+ */
+class FTauStatePool
+{
+public:
+	// Leases a block with every state reset, reusing a free block of the same layout when there is one
+	FTauStateHandle Acquire(int32 TriangleCount, int32 SampleCapacity);
+
+	void Release(FTauStateHandle& Handle);
+
+	// Blocks never move while leased, so the pointer stays valid until Release
+	FTauStateBlock* Resolve(const FTauStateHandle& Handle);
+
+	// Frees the blocks nobody holds
+	void Trim();
+
+	int32 GetBlockCount();
+
+	int32 GetLeasedBlockCount();
+
+	SIZE_T GetAllocatedSize();
+
+private:
+	struct FSlot
+	{
+		TUniquePtr<FTauStateBlock> Block;
+
+		uint32 Generation = 1;
+
+		bool bLeased = false;
+	};
+
+	TArray<FSlot> Slots;
+
+	FCriticalSection PoolLock;
+};
+
+typedef TSharedPtr<FTauStatePool, ESPMode::ThreadSafe> FTauStatePoolPtr;
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeExit.h"
+#include "NuitrackSkeletonJointBuffer.h"
+#include "TauAllocationAudit.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauSteadyStateAllocationTest, "TauSkeletonVisual.SteadyStateAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+namespace TauSteadyStateAllocationTest
+{
+	// Enough for the tau windows, handoff slots, frame slots and the task graph's recycled memory to fill up
+	static const int32 WarmupFrames = 120;
+	static const int32 MeasuredFrames = 240;
+
+	// How long one frame may take to come out of the worker before the test gives up
+	static const double FrameTimeoutSeconds = 5.0;
+
+	struct FMode
+	{
+		const TCHAR* Name;
+		bool bUseSharedWorkerPool;
+		bool bPipelinedStages;
+	};
+
+	// Every joint moves on its own slow circle, so the tau histories see real motion
+	static void MakeSkeletonFrame(int32 FrameIndex, FSkeletonFrame& OutFrame)
+	{
+		const double Time = FrameIndex / 30.0;
+		OutFrame.UserId = 1;
+		OutFrame.bHasJoints = true;
+		OutFrame.Timestamp = Time;
+		for (int32 Joint = 0; Joint < FSkeletonFrame::JointCount; Joint++) {
+			const float Phase = Time * (1.f + 0.1f * Joint);
+			OutFrame.Positions[Joint] = FVector(Joint * 10.f + 5.f * FMath::Cos(Phase), (Joint % 4) * 20.f + 5.f * FMath::Sin(Phase), Joint * 7.f);
+			OutFrame.SetOrientation(Joint, FQuat(FVector::UpVector, Phase));
+			OutFrame.Confidences[Joint] = 1.f;
+		}
+	}
+
+	// Posts one frame, waits for the worker to publish it and consumes it the way the actor's Tick does.
+	// Every posted frame runs the whole path, so none is coalesced away inside the worker.
+	static bool RunFrame(UNuitrackSkeletonJointBuffer* Buffer, int32 FrameIndex)
+	{
+		FSkeletonFrame Frame;
+		MakeSkeletonFrame(FrameIndex, Frame);
+
+		const uint64 Produced = Buffer->FrameResults.GetStats().Produced;
+		{
+			FTauAllocationAuditRegion AuditRegion;
+			Buffer->UpdateSocketFrame(Frame);
+			Buffer->PostCalculationFrame(Frame);
+		}
+
+		const double Deadline = FPlatformTime::Seconds() + FrameTimeoutSeconds;
+		while (Buffer->FrameResults.GetStats().Produced == Produced) {
+			if (FPlatformTime::Seconds() > Deadline) {
+				return false;
+			}
+			FPlatformProcess::YieldThread();
+		}
+
+		FTauAllocationAuditRegion AuditRegion;
+		Buffer->ProcessSocketRawData(1.f / 30.f);
+		Buffer->UpdateTrackingRenderTargets();
+		return true;
+	}
+}
+
+bool FTauSteadyStateAllocationTest::RunTest(const FString& Parameters)
+{
+	using namespace TauSteadyStateAllocationTest;
+
+	// Only for the duration of the test, unless -TauAllocationAudit already installed it for the session
+	const bool bInstalledHere = FTauAllocationAuditScope::Install();
+	ON_SCOPE_EXIT{
+		if (bInstalledHere) {
+			FTauAllocationAuditScope::Uninstall();
+		}
+	};
+	if (!FTauAllocationAuditScope::IsAvailable()) {
+		AddError(TEXT("The allocation audit proxy could not be installed, so nothing would be counted"));
+		return false;
+	}
+
+	const FMode Modes[] = {
+		{ TEXT("serial"), false, false },
+		{ TEXT("pipelined"), false, true },
+		{ TEXT("pool"), true, false },
+		{ TEXT("pool pipelined"), true, true },
+	};
+
+	for (const FMode& Mode : Modes) {
+		UNuitrackSkeletonJointBuffer* Buffer = NewObject<UNuitrackSkeletonJointBuffer>(GetTransientPackage());
+		Buffer->AddToRoot();
+		Buffer->bUseSharedWorkerPool = Mode.bUseSharedWorkerPool;
+		Buffer->bPipelinedStages = Mode.bPipelinedStages;
+		Buffer->bParallelTriangles = true;
+		Buffer->CreateTrackingTextures();
+		Buffer->StartCalculations();
+
+		bool bFramesArrived = true;
+		int32 FrameIndex = 0;
+		while (FrameIndex < WarmupFrames && bFramesArrived) {
+			bFramesArrived = RunFrame(Buffer, FrameIndex);
+			FrameIndex += bFramesArrived ? 1 : 0;
+		}
+
+		// Recording keeps filling a reserved FTauMotionRecording during the measured frames, which must not grow it
+		Buffer->RecordTauFrames(MeasuredFrames);
+
+		int64 Allocations = 0;
+		if (bFramesArrived) {
+			FTauAllocationAuditSession AuditSession;
+			while (FrameIndex < WarmupFrames + MeasuredFrames && bFramesArrived) {
+				bFramesArrived = RunFrame(Buffer, FrameIndex);
+				FrameIndex += bFramesArrived ? 1 : 0;
+			}
+			Allocations = AuditSession.GetAllocationCount();
+		}
+
+		Buffer->ShutdownCalculations();
+		Buffer->RemoveFromRoot();
+
+		if (!bFramesArrived) {
+			AddError(FString::Printf(TEXT("%s: frame %i never came out of the calculation worker"), Mode.Name, FrameIndex));
+		}
+		else if (Allocations > 0) {
+			AddError(FString::Printf(TEXT("%s: %lld heap allocations over %i steady-state frames"), Mode.Name, Allocations, MeasuredFrames));
+		}
+	}
+
+	return !HasAnyErrors();
+}
+
+#endif
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TauTriangleTopology.h"
+#include "TriangleTopology.h"
+#include "SkeletonFrame.h"
+#include "Misc/ScopeLock.h"
+
+FName FTauCompiledTopology::GetDisplayName(FTauTriangleId Triangle) const
+{
+	if (Triangle >= TriangleCount) {
+		return NAME_None;
+	}
+
+	FScopeLock Lock(&DisplayNamesLock);
+	if (DisplayNames.Num() == 0) {
+		DisplayNames.SetNum(TriangleCount);
+		for (int32 Index = 0; Index < TriangleCount; Index++) {
+			if (!Labels[Index].IsNone()) {
+				DisplayNames[Index] = Labels[Index];
+				continue;
+			}
+			FString Name;
+			for (int32 Corner = 0; Corner < 3; Corner++) {
+				int32 Joint = TriangleJoints[Index * 3 + Corner];
+				if (Corner > 0) {
+					Name += TEXT("_");
+				}
+				if (Joint < FSkeletonFrame::JointCount) {
+					Name += FSkeletonFrame::GetJointName(Joint).ToString();
+				}
+				else {
+					Name += FString::Printf(TEXT("Joint%i"), Joint);
+				}
+			}
+			DisplayNames[Index] = FName(*Name);
+		}
+	}
+	return DisplayNames[Triangle];
+}
+
+TSharedRef<const FTauCompiledTopology, ESPMode::ThreadSafe> FTauCompiledTopology::GetDefault()
+{
+	static TSharedRef<const FTauCompiledTopology, ESPMode::ThreadSafe> Default = []() {
+		TSharedRef<FTauCompiledTopology, ESPMode::ThreadSafe> Topology = MakeShared<FTauCompiledTopology, ESPMode::ThreadSafe>();
+		Topology->JointCount = TauTopology::JointCount;
+		Topology->TriangleCount = TauTopology::TriangleCount;
+		Topology->TriangleJoints.Reserve(TauTopology::IndexCount);
+		for (int32 Triangle = 0; Triangle < TauTopology::TriangleCount; Triangle++) {
+			Topology->TriangleJoints.Append(TauTopology::TriangleJoints[Triangle], 3);
+		}
+		Topology->Labels.SetNum(TauTopology::TriangleCount);
+		return TSharedRef<const FTauCompiledTopology, ESPMode::ThreadSafe>(Topology);
+	}();
+	return Default;
+}
+
+TSharedRef<const FTauCompiledTopology, ESPMode::ThreadSafe> FTauCompiledTopology::MakeAllTriples(int32 JointCount)
+{
+	TSharedRef<FTauCompiledTopology, ESPMode::ThreadSafe> Topology = MakeShared<FTauCompiledTopology, ESPMode::ThreadSafe>();
+	// C(74, 3) is the largest triple count that still fits FTauTriangleId
+	Topology->JointCount = FMath::Clamp(JointCount, 3, 74);
+	Topology->bAllTriples = true;
+	for (int32 i = 0; i < Topology->JointCount; i++) {
+		for (int32 j = i + 1; j < Topology->JointCount; j++) {
+			for (int32 k = j + 1; k < Topology->JointCount; k++) {
+				Topology->TriangleJoints.Add((uint8)i);
+				Topology->TriangleJoints.Add((uint8)j);
+				Topology->TriangleJoints.Add((uint8)k);
+			}
+		}
+	}
+	Topology->TriangleCount = Topology->TriangleJoints.Num() / 3;
+	Topology->Labels.SetNum(Topology->TriangleCount);
+	return Topology;
+}
+
+FTauTopologyPtr UTauTriangleTopology::Compile() const
+{
+	if (Triangles.Num() == 0) {
+		UE_LOG(LogTemp, Warning, TEXT("Topology %s has no triangles"), *GetName());
+		return nullptr;
+	}
+	if (Triangles.Num() > FTauCompiledTopology::MaxTriangleCount) {
+		UE_LOG(LogTemp, Warning, TEXT("Topology %s has %i triangles, at most %i are supported"), *GetName(), Triangles.Num(), FTauCompiledTopology::MaxTriangleCount);
+		return nullptr;
+	}
+	// The worker gathers corners from FSkeletonFrame, so joints past its count would never be filled
+	if (JointCount > FSkeletonFrame::JointCount) {
+		UE_LOG(LogTemp, Warning, TEXT("Topology %s uses %i joints, skeleton frames carry %i"), *GetName(), JointCount, FSkeletonFrame::JointCount);
+		return nullptr;
+	}
+
+	TSharedRef<FTauCompiledTopology, ESPMode::ThreadSafe> Topology = MakeShared<FTauCompiledTopology, ESPMode::ThreadSafe>();
+	Topology->JointCount = FMath::Max(JointCount, 3);
+	Topology->TriangleCount = Triangles.Num();
+	Topology->TriangleJoints.Reserve(Triangles.Num() * 3);
+	Topology->Labels.Reserve(Triangles.Num());
+
+	for (int32 Triangle = 0; Triangle < Triangles.Num(); Triangle++) {
+		const FTauTriangleDefinition& Definition = Triangles[Triangle];
+		for (int32 Joint : { Definition.JointA, Definition.JointB, Definition.JointC }) {
+			if (Joint < 0 || Joint >= Topology->JointCount) {
+				UE_LOG(LogTemp, Warning, TEXT("Topology %s: triangle %i uses joint %i, expected 0 to %i"), *GetName(), Triangle, Joint, Topology->JointCount - 1);
+				return nullptr;
+			}
+			Topology->TriangleJoints.Add((uint8)Joint);
+		}
+		Topology->Labels.Add(Definition.Label);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Compiled topology %s: %i triangles over %i joints"), *GetName(), Topology->TriangleCount, Topology->JointCount);
+	return Topology;
+}
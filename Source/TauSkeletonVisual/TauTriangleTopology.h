@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Templates/SharedPointer.h"
+#include "HAL/CriticalSection.h"
+#include "TauTriangleTopology.generated.h"
+
+/**
+ * One tracked triangle, as indexes into the socket arrays.
+ */
+USTRUCT(BlueprintType)
+struct FTauTriangleDefinition
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauTopology")
+		int32 JointA = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauTopology")
+		int32 JointB = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauTopology")
+		int32 JointC = 0;
+
+	// Optional, shows up in logs and through GetTriangleLabel
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauTopology")
+		FName Label;
+};
+
+// Dense triangle id, the triangle's position in its compiled topology
+typedef uint16 FTauTriangleId;
+
+/**
+ * Topology in the compact form the calculation thread reads every frame. Immutable once built,
+ * so every pipeline frame and worker can share it.
+ */
+struct FTauCompiledTopology
+{
+	// Sockets per skeleton, also the edge length of the tau texture volume
+	int32 JointCount = 0;
+
+	int32 TriangleCount = 0;
+
+	// Three joint indexes per triangle
+	TArray<uint8> TriangleJoints;
+
+	// One per triangle, None where the asset has no label
+	TArray<FName> Labels;
+
+	// Every distinct joint triple, in ascending order, so a triple's permutations all map to it
+	bool bAllTriples = false;
+
+	// Triangle ids have to fit FTauTriangleId
+	static constexpr int32 MaxTriangleCount = MAX_uint16;
+
+	int32 GetIndexCount() const
+	{
+		return TriangleCount * 3;
+	}
+
+	// Label, or the three joint names when there is none. Built on the first call, off the per-frame path.
+	FName GetDisplayName(FTauTriangleId Triangle) const;
+
+	// The built-in 67-triangle table from TriangleTopology.h
+	static TSharedRef<const FTauCompiledTopology, ESPMode::ThreadSafe> GetDefault();
+
+	// All C(JointCount, 3) triples, 816 for the 18 Nuitrack joints
+	static TSharedRef<const FTauCompiledTopology, ESPMode::ThreadSafe> MakeAllTriples(int32 JointCount);
+
+private:
+	mutable FCriticalSection DisplayNamesLock;
+
+	mutable TArray<FName> DisplayNames;
+};
+
+typedef TSharedPtr<const FTauCompiledTopology, ESPMode::ThreadSafe> FTauTopologyPtr;
+
+/**
+ * Triangle set tracked by a joint buffer. Lets a session track a small subset at a high rate,
+ * or a much larger set offline, without recompiling.
+ */
+UCLASS(BlueprintType)
+class TAUSKELETONVISUAL_API UTauTriangleTopology : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// At most FSkeletonFrame::JointCount
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "TauTopology", meta = (ClampMin = "3", ClampMax = "18"))
+		int32 JointCount = 18;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "TauTopology")
+		TArray<FTauTriangleDefinition> Triangles;
+
+	// Returns an invalid pointer, and logs why, when the asset is empty, has more than MaxTriangleCount triangles,
+	// has more joints than a skeleton frame or refers to a joint outside JointCount
+	FTauTopologyPtr Compile() const;
+};
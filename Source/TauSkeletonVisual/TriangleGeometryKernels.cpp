@@ -0,0 +1,477 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TriangleGeometryKernels.h"
+#include "TauPredicates.h"
+#include "TauSimd.h"
+
+TAU_BEGIN_UNFUSED_MATH
+
+namespace TriangleGeometryKernels
+{
+	// Raw column pointers, so the kernels do not go through TArray bounds checks
+	struct FEulerLineColumns
+	{
+		const float* AX;
+		const float* AY;
+		const float* AZ;
+		const float* BX;
+		const float* BY;
+		const float* BZ;
+		const float* CX;
+		const float* CY;
+		const float* CZ;
+		float* CentroidX;
+		float* CentroidY;
+		float* CentroidZ;
+		float* CircumX;
+		float* CircumY;
+		float* CircumZ;
+		float* EulerX;
+		float* EulerY;
+		float* EulerZ;
+		uint8* Degenerate;
+
+		// Area ratio threshold squared and divided by 12, so the test needs no square root
+		float QualityScale;
+
+		explicit FEulerLineColumns(FTriangleGeometryStore& Geometry)
+			: AX(Geometry.A.X.GetData()), AY(Geometry.A.Y.GetData()), AZ(Geometry.A.Z.GetData())
+			, BX(Geometry.B.X.GetData()), BY(Geometry.B.Y.GetData()), BZ(Geometry.B.Z.GetData())
+			, CX(Geometry.C.X.GetData()), CY(Geometry.C.Y.GetData()), CZ(Geometry.C.Z.GetData())
+			, CentroidX(Geometry.Centroids.X.GetData()), CentroidY(Geometry.Centroids.Y.GetData()), CentroidZ(Geometry.Centroids.Z.GetData())
+			, CircumX(Geometry.Circumcenters.X.GetData()), CircumY(Geometry.Circumcenters.Y.GetData()), CircumZ(Geometry.Circumcenters.Z.GetData())
+			, EulerX(Geometry.EulerLines.X.GetData()), EulerY(Geometry.EulerLines.Y.GetData()), EulerZ(Geometry.EulerLines.Z.GetData())
+			, Degenerate(Geometry.Degenerate.GetData())
+			, QualityScale(0)
+		{
+		}
+	};
+
+	typedef void (*FEulerLineKernel)(const FEulerLineColumns& Columns, int32 Begin, int32 End, FEulerLineStats& Stats);
+
+	// The float cross product n is used as long as its rounding error bound stays below 2^-16 of
+	// |n| (L1 norm). That is the case unless the triangle is within about a degree of collinear.
+	static constexpr float CrossFilterBound = TauPredicates::FloatOrient2DErrorBound * 65536.f;
+
+	// Degenerate triangles have no finite circumcenter. The midpoint of the longest edge, the
+	// center of the smallest circle around the triangle, stands in for it and keeps the Euler
+	// line finite, also for triangles that repeat a joint.
+	static void EulerLineDegenerate(const FEulerLineColumns& Columns, int32 i, FEulerLineStats& Stats)
+	{
+		const FVector A(Columns.AX[i], Columns.AY[i], Columns.AZ[i]);
+		const FVector B(Columns.BX[i], Columns.BY[i], Columns.BZ[i]);
+		const FVector C(Columns.CX[i], Columns.CY[i], Columns.CZ[i]);
+		const float BaLength = FVector::DistSquared(A, B);
+		const float CaLength = FVector::DistSquared(A, C);
+		const float CbLength = FVector::DistSquared(B, C);
+
+		FVector Circumcenter;
+		if (BaLength >= CaLength && BaLength >= CbLength) {
+			Circumcenter = (A + B) * 0.5f;
+		}
+		else if (CaLength >= CbLength) {
+			Circumcenter = (A + C) * 0.5f;
+		}
+		else {
+			Circumcenter = (B + C) * 0.5f;
+		}
+
+		Columns.CircumX[i] = Circumcenter.X;
+		Columns.CircumY[i] = Circumcenter.Y;
+		Columns.CircumZ[i] = Circumcenter.Z;
+		Columns.EulerX[i] = Columns.CentroidX[i] - Circumcenter.X;
+		Columns.EulerY[i] = Columns.CentroidY[i] - Circumcenter.Y;
+		Columns.EulerZ[i] = Columns.CentroidZ[i] - Circumcenter.Z;
+
+		Stats.DegenerateTriangles++;
+	}
+
+	// Double-precision circumcenter with each cross product component evaluated by the adaptive
+	// predicate, for the triangles the float filter rejected
+	static void EulerLineRobust(const FEulerLineColumns& Columns, int32 i, FEulerLineStats& Stats)
+	{
+		const double a[3] = { Columns.AX[i], Columns.AY[i], Columns.AZ[i] };
+		const double b[3] = { Columns.BX[i], Columns.BY[i], Columns.BZ[i] };
+		const double c[3] = { Columns.CX[i], Columns.CY[i], Columns.CZ[i] };
+
+		// Each component of (b - a) x (c - a) is an orient2d of the triangle projected on a plane
+		bool bExact[3];
+		const double ByzA[2] = { b[1], b[2] }, CyzA[2] = { c[1], c[2] }, AyzA[2] = { a[1], a[2] };
+		const double XCross = TauPredicates::Orient2D(ByzA, CyzA, AyzA, &bExact[0]);
+		const double CxzA[2] = { c[0], c[2] }, BxzA[2] = { b[0], b[2] }, AxzA[2] = { a[0], a[2] };
+		const double YCross = TauPredicates::Orient2D(CxzA, BxzA, AxzA, &bExact[1]);
+		const double BxyA[2] = { b[0], b[1] }, CxyA[2] = { c[0], c[1] }, AxyA[2] = { a[0], a[1] };
+		const double ZCross = TauPredicates::Orient2D(BxyA, CxyA, AxyA, &bExact[2]);
+
+		// Differences of floats are exact in double
+		const double Xba = b[0] - a[0];
+		const double Yba = b[1] - a[1];
+		const double Zba = b[2] - a[2];
+		const double Xca = c[0] - a[0];
+		const double Yca = c[1] - a[1];
+		const double Zca = c[2] - a[2];
+		const double BaLength = Xba * Xba + Yba * Yba + Zba * Zba;
+		const double CaLength = Xca * Xca + Yca * Yca + Zca * Zca;
+
+		const double Denominator = 0.5 / (XCross * XCross + YCross * YCross + ZCross * ZCross);
+		const double Mx = BaLength * Xca - CaLength * Xba;
+		const double My = BaLength * Yca - CaLength * Yba;
+		const double Mz = BaLength * Zca - CaLength * Zba;
+
+		const float CircumX = float(a[0] + (My * ZCross - Mz * YCross) * Denominator);
+		const float CircumY = float(a[1] + (Mz * XCross - Mx * ZCross) * Denominator);
+		const float CircumZ = float(a[2] + (Mx * YCross - My * XCross) * Denominator);
+
+		Columns.CircumX[i] = CircumX;
+		Columns.CircumY[i] = CircumY;
+		Columns.CircumZ[i] = CircumZ;
+		Columns.EulerX[i] = Columns.CentroidX[i] - CircumX;
+		Columns.EulerY[i] = Columns.CentroidY[i] - CircumY;
+		Columns.EulerZ[i] = Columns.CentroidZ[i] - CircumZ;
+
+		Stats.RobustTriangles++;
+		Stats.ExactPredicates += int32(bExact[0]) + int32(bExact[1]) + int32(bExact[2]);
+	}
+
+	/**
+	 * Circumcenter of the triangle relative to `a', from tricircumcenter3d in MeshKit:
+	 *
+	 *   ba = b - a, ca = c - a, n = ba x ca
+	 *   m = |ba|^2 ca - |ca|^2 ba
+	 *   circumcenter = a + (m x n) / (2 |n|^2)
+	 *
+	 * Every path below evaluates these operations in the same order, so a triangle gets the
+	 * same floats whichever path or lane handles it.
+	 */
+	static void EulerLinesScalar(const FEulerLineColumns& Columns, int32 Begin, int32 End, FEulerLineStats& Stats)
+	{
+		for (int32 i = Begin; i < End; i++) {
+			const float Ax = Columns.AX[i];
+			const float Ay = Columns.AY[i];
+			const float Az = Columns.AZ[i];
+
+			const float CentroidX = (Ax + Columns.BX[i] + Columns.CX[i]) / 3.f;
+			const float CentroidY = (Ay + Columns.BY[i] + Columns.CY[i]) / 3.f;
+			const float CentroidZ = (Az + Columns.BZ[i] + Columns.CZ[i]) / 3.f;
+
+			const float Xba = Columns.BX[i] - Ax;
+			const float Yba = Columns.BY[i] - Ay;
+			const float Zba = Columns.BZ[i] - Az;
+			const float Xca = Columns.CX[i] - Ax;
+			const float Yca = Columns.CY[i] - Ay;
+			const float Zca = Columns.CZ[i] - Az;
+
+			const float Xcb = Columns.CX[i] - Columns.BX[i];
+			const float Ycb = Columns.CY[i] - Columns.BY[i];
+			const float Zcb = Columns.CZ[i] - Columns.BZ[i];
+
+			const float BaLength = Xba * Xba + Yba * Yba + Zba * Zba;
+			const float CaLength = Xca * Xca + Yca * Yca + Zca * Zca;
+			const float CbLength = Xcb * Xcb + Ycb * Ycb + Zcb * Zcb;
+			const float EdgeSum = BaLength + CaLength + CbLength;
+
+			const float XCross = Yba * Zca - Yca * Zba;
+			const float YCross = Zba * Xca - Zca * Xba;
+			const float ZCross = Xba * Yca - Xca * Yba;
+			const float CrossLength = XCross * XCross + YCross * YCross + ZCross * ZCross;
+
+			const float Denominator = 0.5f / CrossLength;
+
+			const float Mx = BaLength * Xca - CaLength * Xba;
+			const float My = BaLength * Yca - CaLength * Yba;
+			const float Mz = BaLength * Zca - CaLength * Zba;
+
+			const float CircumX = Ax + (My * ZCross - Mz * YCross) * Denominator;
+			const float CircumY = Ay + (Mz * XCross - Mx * ZCross) * Denominator;
+			const float CircumZ = Az + (Mx * YCross - My * XCross) * Denominator;
+
+			Columns.CentroidX[i] = CentroidX;
+			Columns.CentroidY[i] = CentroidY;
+			Columns.CentroidZ[i] = CentroidZ;
+			Columns.CircumX[i] = CircumX;
+			Columns.CircumY[i] = CircumY;
+			Columns.CircumZ[i] = CircumZ;
+			Columns.EulerX[i] = CentroidX - CircumX;
+			Columns.EulerY[i] = CentroidY - CircumY;
+			Columns.EulerZ[i] = CentroidZ - CircumZ;
+
+			// Written as "not above" so NaN coordinates are caught as well
+			const bool bDegenerate = !(CrossLength > Columns.QualityScale * (EdgeSum * EdgeSum));
+			Columns.Degenerate[i] = bDegenerate ? 1 : 0;
+			if (bDegenerate) {
+				EulerLineDegenerate(Columns, i, Stats);
+				continue;
+			}
+
+			const float ErrorSum = (FMath::Abs(Yba * Zca) + FMath::Abs(Yca * Zba)) + (FMath::Abs(Zba * Xca) + FMath::Abs(Zca * Xba)) + (FMath::Abs(Xba * Yca) + FMath::Abs(Xca * Yba));
+			const float CrossSum = FMath::Abs(XCross) + FMath::Abs(YCross) + FMath::Abs(ZCross);
+			if (ErrorSum * CrossFilterBound > CrossSum) {
+				EulerLineRobust(Columns, i, Stats);
+			}
+		}
+	}
+
+#if PLATFORM_CPU_X86_FAMILY
+
+	// EulerLinesScalar over Width lanes at a time; the remainder goes through the scalar loop
+#define TAU_EULER_LINES_BODY(Vec, Width, Load, Store, Add, Sub, Mul, Div, Set1, Abs, GreaterMask) \
+	const Vec Third = Set1(3.f); \
+	const Vec Half = Set1(0.5f); \
+	const Vec FilterBound = Set1(CrossFilterBound); \
+	const Vec QualityScale = Set1(Columns.QualityScale); \
+	const uint32 AllLanes = (1u << Width) - 1; \
+	int32 i = Begin; \
+	for (; i + Width <= End; i += Width) { \
+		const Vec Ax = Load(Columns.AX + i); \
+		const Vec Ay = Load(Columns.AY + i); \
+		const Vec Az = Load(Columns.AZ + i); \
+		const Vec Bx = Load(Columns.BX + i); \
+		const Vec By = Load(Columns.BY + i); \
+		const Vec Bz = Load(Columns.BZ + i); \
+		const Vec Cx = Load(Columns.CX + i); \
+		const Vec Cy = Load(Columns.CY + i); \
+		const Vec Cz = Load(Columns.CZ + i); \
+		const Vec CentroidX = Div(Add(Add(Ax, Bx), Cx), Third); \
+		const Vec CentroidY = Div(Add(Add(Ay, By), Cy), Third); \
+		const Vec CentroidZ = Div(Add(Add(Az, Bz), Cz), Third); \
+		const Vec Xba = Sub(Bx, Ax); \
+		const Vec Yba = Sub(By, Ay); \
+		const Vec Zba = Sub(Bz, Az); \
+		const Vec Xca = Sub(Cx, Ax); \
+		const Vec Yca = Sub(Cy, Ay); \
+		const Vec Zca = Sub(Cz, Az); \
+		const Vec Xcb = Sub(Cx, Bx); \
+		const Vec Ycb = Sub(Cy, By); \
+		const Vec Zcb = Sub(Cz, Bz); \
+		const Vec BaLength = Add(Add(Mul(Xba, Xba), Mul(Yba, Yba)), Mul(Zba, Zba)); \
+		const Vec CaLength = Add(Add(Mul(Xca, Xca), Mul(Yca, Yca)), Mul(Zca, Zca)); \
+		const Vec CbLength = Add(Add(Mul(Xcb, Xcb), Mul(Ycb, Ycb)), Mul(Zcb, Zcb)); \
+		const Vec EdgeSum = Add(Add(BaLength, CaLength), CbLength); \
+		const Vec XCross = Sub(Mul(Yba, Zca), Mul(Yca, Zba)); \
+		const Vec YCross = Sub(Mul(Zba, Xca), Mul(Zca, Xba)); \
+		const Vec ZCross = Sub(Mul(Xba, Yca), Mul(Xca, Yba)); \
+		const Vec CrossLength = Add(Add(Mul(XCross, XCross), Mul(YCross, YCross)), Mul(ZCross, ZCross)); \
+		const Vec Denominator = Div(Half, CrossLength); \
+		const Vec Mx = Sub(Mul(BaLength, Xca), Mul(CaLength, Xba)); \
+		const Vec My = Sub(Mul(BaLength, Yca), Mul(CaLength, Yba)); \
+		const Vec Mz = Sub(Mul(BaLength, Zca), Mul(CaLength, Zba)); \
+		const Vec CircumX = Add(Ax, Mul(Sub(Mul(My, ZCross), Mul(Mz, YCross)), Denominator)); \
+		const Vec CircumY = Add(Ay, Mul(Sub(Mul(Mz, XCross), Mul(Mx, ZCross)), Denominator)); \
+		const Vec CircumZ = Add(Az, Mul(Sub(Mul(Mx, YCross), Mul(My, XCross)), Denominator)); \
+		Store(Columns.CentroidX + i, CentroidX); \
+		Store(Columns.CentroidY + i, CentroidY); \
+		Store(Columns.CentroidZ + i, CentroidZ); \
+		Store(Columns.CircumX + i, CircumX); \
+		Store(Columns.CircumY + i, CircumY); \
+		Store(Columns.CircumZ + i, CircumZ); \
+		Store(Columns.EulerX + i, Sub(CentroidX, CircumX)); \
+		Store(Columns.EulerY + i, Sub(CentroidY, CircumY)); \
+		Store(Columns.EulerZ + i, Sub(CentroidZ, CircumZ)); \
+		const Vec ErrorSum = Add(Add(Add(Abs(Mul(Yba, Zca)), Abs(Mul(Yca, Zba))), Add(Abs(Mul(Zba, Xca)), Abs(Mul(Zca, Xba)))), Add(Abs(Mul(Xba, Yca)), Abs(Mul(Xca, Yba)))); \
+		const Vec CrossSum = Add(Add(Abs(XCross), Abs(YCross)), Abs(ZCross)); \
+		uint32 DegenerateLanes = ~GreaterMask(CrossLength, Mul(QualityScale, Mul(EdgeSum, EdgeSum))) & AllLanes; \
+		uint32 RobustLanes = GreaterMask(Mul(ErrorSum, FilterBound), CrossSum) & ~DegenerateLanes; \
+		for (int32 Lane = 0; Lane < Width; Lane++) { \
+			Columns.Degenerate[i + Lane] = (uint8)((DegenerateLanes >> Lane) & 1); \
+		} \
+		while (DegenerateLanes != 0) { \
+			EulerLineDegenerate(Columns, i + (int32)FMath::CountTrailingZeros(DegenerateLanes), Stats); \
+			DegenerateLanes &= DegenerateLanes - 1; \
+		} \
+		while (RobustLanes != 0) { \
+			EulerLineRobust(Columns, i + (int32)FMath::CountTrailingZeros(RobustLanes), Stats); \
+			RobustLanes &= RobustLanes - 1; \
+		} \
+	} \
+	EulerLinesScalar(Columns, i, End, Stats);
+
+	// Ranges start anywhere in the columns, so every path uses unaligned loads and stores
+	// Sign bit cleared by and-not, and lane masks of A > B with NaN lanes left out
+#define TAU_ABS_SSE(V) _mm_andnot_ps(_mm_set1_ps(-0.f), V)
+#define TAU_GREATER_SSE(A, B) (uint32)_mm_movemask_ps(_mm_cmpgt_ps(A, B))
+#define TAU_ABS_AVX(V) _mm256_andnot_ps(_mm256_set1_ps(-0.f), V)
+#define TAU_GREATER_AVX(A, B) (uint32)_mm256_movemask_ps(_mm256_cmp_ps(A, B, _CMP_GT_OQ))
+#define TAU_GREATER_AVX512(A, B) (uint32)_mm512_cmp_ps_mask(A, B, _CMP_GT_OQ)
+
+	TAU_TARGET("sse4.1")
+	static void EulerLinesSSE4(const FEulerLineColumns& Columns, int32 Begin, int32 End, FEulerLineStats& Stats)
+	{
+		TAU_EULER_LINES_BODY(__m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_div_ps, _mm_set1_ps, TAU_ABS_SSE, TAU_GREATER_SSE)
+	}
+
+	TAU_TARGET("avx2")
+	static void EulerLinesAVX2(const FEulerLineColumns& Columns, int32 Begin, int32 End, FEulerLineStats& Stats)
+	{
+		TAU_EULER_LINES_BODY(__m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_div_ps, _mm256_set1_ps, TAU_ABS_AVX, TAU_GREATER_AVX)
+	}
+
+	TAU_TARGET("avx512f")
+	static void EulerLinesAVX512(const FEulerLineColumns& Columns, int32 Begin, int32 End, FEulerLineStats& Stats)
+	{
+		TAU_EULER_LINES_BODY(__m512, 16, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_add_ps, _mm512_sub_ps, _mm512_mul_ps, _mm512_div_ps, _mm512_set1_ps, _mm512_abs_ps, TAU_GREATER_AVX512)
+	}
+
+#undef TAU_ABS_SSE
+#undef TAU_GREATER_SSE
+#undef TAU_ABS_AVX
+#undef TAU_GREATER_AVX
+#undef TAU_GREATER_AVX512
+
+#undef TAU_EULER_LINES_BODY
+
+	static void CpuId(int32 Leaf, int32 SubLeaf, uint32 Registers[4])
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int32 Values[4];
+		__cpuidex(Values, Leaf, SubLeaf);
+		for (int32 ii = 0; ii < 4; ii++) {
+			Registers[ii] = (uint32)Values[ii];
+		}
+#else
+		__cpuid_count(Leaf, SubLeaf, Registers[0], Registers[1], Registers[2], Registers[3]);
+#endif
+	}
+
+	// Register state the OS saves on context switches
+	static uint64 ReadXCR0()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		return _xgetbv(0);
+#else
+		uint32 Low, High;
+		__asm__ volatile("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+		return ((uint64)High << 32) | Low;
+#endif
+	}
+
+	static ETriangleKernelPath DetectPath()
+	{
+		uint32 Registers[4];
+		CpuId(0, 0, Registers);
+		const uint32 MaxLeaf = Registers[0];
+		if (MaxLeaf < 1) {
+			return ETriangleKernelPath::Scalar;
+		}
+
+		CpuId(1, 0, Registers);
+		const bool bSSE41 = (Registers[2] & (1u << 19)) != 0;
+		const bool bOSXSave = (Registers[2] & (1u << 27)) != 0;
+		const bool bAVX = (Registers[2] & (1u << 28)) != 0;
+		if (!bSSE41) {
+			return ETriangleKernelPath::Scalar;
+		}
+		if (!bOSXSave || !bAVX || MaxLeaf < 7) {
+			return ETriangleKernelPath::SSE4;
+		}
+
+		// The CPU having AVX is not enough, the OS must also save the wider registers
+		const uint64 XCR0 = ReadXCR0();
+		const bool bYmmState = (XCR0 & 0x6) == 0x6;
+		const bool bZmmState = (XCR0 & 0xE6) == 0xE6;
+
+		CpuId(7, 0, Registers);
+		const bool bAVX2 = (Registers[1] & (1u << 5)) != 0;
+		const bool bAVX512F = (Registers[1] & (1u << 16)) != 0;
+
+		if (bAVX512F && bZmmState) {
+			return ETriangleKernelPath::AVX512;
+		}
+		if (bAVX2 && bYmmState) {
+			return ETriangleKernelPath::AVX2;
+		}
+		return ETriangleKernelPath::SSE4;
+	}
+
+#else
+
+	static ETriangleKernelPath DetectPath()
+	{
+		return ETriangleKernelPath::Scalar;
+	}
+
+#endif
+
+	struct FKernelSelection
+	{
+		ETriangleKernelPath Path;
+		FEulerLineKernel EulerLines;
+
+		FKernelSelection()
+		{
+			Path = DetectPath();
+			switch (Path) {
+#if PLATFORM_CPU_X86_FAMILY
+			case ETriangleKernelPath::AVX512:
+				EulerLines = &EulerLinesAVX512;
+				break;
+			case ETriangleKernelPath::AVX2:
+				EulerLines = &EulerLinesAVX2;
+				break;
+			case ETriangleKernelPath::SSE4:
+				EulerLines = &EulerLinesSSE4;
+				break;
+#endif
+			default:
+				EulerLines = &EulerLinesScalar;
+				break;
+			}
+			UE_LOG(LogTemp, Display, TEXT("Triangle geometry kernels use the %s path (%i triangles per instruction)"), FTriangleGeometryKernels::GetPathName(Path), FTriangleGeometryKernels::GetLaneCount(Path));
+		}
+	};
+
+	// Picked once; function-local statics are initialized thread-safely
+	static const FKernelSelection& GetSelection()
+	{
+		static const FKernelSelection Selection;
+		return Selection;
+	}
+}
+
+FEulerLineStats FTriangleGeometryKernels::UpdateEulerLines(FTriangleGeometryStore& Geometry, int32 Begin, int32 End, float DegenerateQuality)
+{
+	check(Begin >= 0 && End <= Geometry.Num());
+	FEulerLineStats Stats;
+	if (Begin >= End) {
+		return Stats;
+	}
+	TriangleGeometryKernels::FEulerLineColumns Columns(Geometry);
+	Columns.QualityScale = DegenerateQuality * DegenerateQuality / 12.f;
+	TriangleGeometryKernels::GetSelection().EulerLines(Columns, Begin, End, Stats);
+	return Stats;
+}
+
+ETriangleKernelPath FTriangleGeometryKernels::GetPath()
+{
+	return TriangleGeometryKernels::GetSelection().Path;
+}
+
+const TCHAR* FTriangleGeometryKernels::GetPathName(ETriangleKernelPath Path)
+{
+	switch (Path) {
+	case ETriangleKernelPath::SSE4:
+		return TEXT("SSE4");
+	case ETriangleKernelPath::AVX2:
+		return TEXT("AVX2");
+	case ETriangleKernelPath::AVX512:
+		return TEXT("AVX-512");
+	default:
+		return TEXT("scalar");
+	}
+}
+
+int32 FTriangleGeometryKernels::GetLaneCount(ETriangleKernelPath Path)
+{
+	switch (Path) {
+	case ETriangleKernelPath::SSE4:
+		return 4;
+	case ETriangleKernelPath::AVX2:
+		return 8;
+	case ETriangleKernelPath::AVX512:
+		return 16;
+	default:
+		return 1;
+	}
+}
+
+TAU_END_UNFUSED_MATH
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TriangleGeometryStore.h"
+
+// Instruction sets the batched kernels are built for, narrowest first
+enum class ETriangleKernelPath : uint8
+{
+	Scalar,
+	SSE4,
+	AVX2,
+	AVX512
+};
+
+// How often the Euler line kernel left its float fast path
+struct FEulerLineStats
+{
+	// Triangles flatter than the quality threshold, which got the fallback circumcenter
+	int32 DegenerateTriangles = 0;
+
+	// Triangles recomputed in double because the float cross product was not accurate enough
+	int32 RobustTriangles = 0;
+
+	// Cross product components among those that also needed exact arithmetic
+	int32 ExactPredicates = 0;
+};
+
+/**
+ * Batched per-triangle geometry over the SoA columns of a FTriangleGeometryStore.
+ * Each path runs 1, 4, 8 or 16 triangles per instruction with the same operation order,
+ * so all of them produce the same floats. The widest path the CPU and OS support is
+ * picked on first use.
+ *
+ * Triangles are first classified by their area ratio 2*sqrt(3)*|n| / (|ab|^2 + |bc|^2 + |ca|^2),
+ * 1 for an equilateral triangle and 0 for a collinear one. Below the quality threshold the
+ * circumcenter has no useful value, so it is replaced by the midpoint of the longest edge and
+ * the triangle is flagged in Geometry.Degenerate. Of the rest, triangles whose float cross
+ * product could be off by more than 2^-16 are recomputed in double with adaptive exact
+ * predicates, so their circumcenters stay stable.
+ */
+class FTriangleGeometryKernels
+{
+public:
+	// Centroid, circumcenter, Euler line (centroid - circumcenter) and degenerate flag of triangles [Begin, End)
+	static FEulerLineStats UpdateEulerLines(FTriangleGeometryStore& Geometry, int32 Begin, int32 End, float DegenerateQuality);
+
+	static ETriangleKernelPath GetPath();
+
+	static const TCHAR* GetPathName(ETriangleKernelPath Path);
+
+	// Triangles one instruction handles on Path
+	static int32 GetLaneCount(ETriangleKernelPath Path);
+};
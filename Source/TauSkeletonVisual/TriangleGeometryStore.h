@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ContainerAllocationPolicies.h"
+
+// Every component array starts on its own cache line
+typedef TArray<float, TAlignedHeapAllocator<PLATFORM_CACHE_LINE_SIZE>> FTriangleFloatArray;
+typedef TArray<double, TAlignedHeapAllocator<PLATFORM_CACHE_LINE_SIZE>> FTriangleDoubleArray;
+typedef TArray<uint8, TAlignedHeapAllocator<PLATFORM_CACHE_LINE_SIZE>> FTriangleFlagArray;
+
+/**
+ * One vector per triangle, stored as separate X, Y and Z arrays.
+ */
+struct FTriangleVectorArray
+{
+	FTriangleFloatArray X;
+	FTriangleFloatArray Y;
+	FTriangleFloatArray Z;
+
+	void SetNum(int32 Count)
+	{
+		X.SetNumUninitialized(Count, false);
+		Y.SetNumUninitialized(Count, false);
+		Z.SetNumUninitialized(Count, false);
+	}
+
+	FORCEINLINE FVector Get(int32 Index) const
+	{
+		return FVector(X[Index], Y[Index], Z[Index]);
+	}
+
+	FORCEINLINE void Set(int32 Index, const FVector& Value)
+	{
+		X[Index] = Value.X;
+		Y[Index] = Value.Y;
+		Z[Index] = Value.Z;
+	}
+};
+
+/**
+ * Per-triangle geometry of one pipeline frame, indexed by triangle id.
+ * Sized from the topology on the first frame and reused afterwards, so steady-state frames
+ * do not allocate and the geometry loops walk contiguous float arrays.
+ */
+struct FTriangleGeometryStore
+{
+	// Triangle vertices
+	FTriangleVectorArray A;
+	FTriangleVectorArray B;
+	FTriangleVectorArray C;
+
+	FTriangleVectorArray Centroids;
+	FTriangleVectorArray Circumcenters;
+	FTriangleVectorArray EulerLines;
+
+	// 1 for triangles classified as degenerate this frame; their circumcenter is the fallback
+	FTriangleFlagArray Degenerate;
+
+	// Debug vectors, only filled while debug geometry is on
+	FTriangleVectorArray AB;
+	FTriangleVectorArray ABmid;
+	FTriangleVectorArray BC;
+	FTriangleVectorArray BCmid;
+	FTriangleVectorArray CA;
+	FTriangleVectorArray CAmid;
+	FTriangleVectorArray V;
+	FTriangleVectorArray D1;
+	FTriangleVectorArray D2;
+	FTriangleVectorArray D3;
+	FTriangleVectorArray ABBC;
+
+	int32 Num() const
+	{
+		return TriangleCount;
+	}
+
+	// Reallocates only when the topology changes size
+	void Resize(int32 InTriangleCount)
+	{
+		if (InTriangleCount == TriangleCount) {
+			return;
+		}
+		TriangleCount = InTriangleCount;
+		for (FTriangleVectorArray* Component : { &A, &B, &C, &Centroids, &Circumcenters, &EulerLines, &AB, &ABmid, &BC, &BCmid, &CA, &CAmid, &V, &D1, &D2, &D3, &ABBC }) {
+			Component->SetNum(TriangleCount);
+		}
+		Degenerate.SetNumZeroed(TriangleCount);
+	}
+
+private:
+	int32 TriangleCount = 0;
+};
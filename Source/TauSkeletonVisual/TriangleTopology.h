@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Joint triples the tau pipeline tracks, as indexes into the socket arrays:
+ *
+ * [0] Head, [1] Neck, [2] Torso, [3] Waist,
+ * [4] Left Shoulder, [5] Left Elbow, [6] Left Wrist, [7] Left Hand,
+ * [8] Right Shoulder, [9] Right Elbow, [10] Right Wrist, [11] Right Hand,
+ * [12] Left Hip, [13] Left Knee, [14] Left Ankle,
+ * [15] Right Hip, [16] Right Knee, [17] Right Ankle
+ *
+ * The per-triangle comments keep the rig names the list was originally written with.
+ */
+namespace TauTopology
+{
+	constexpr int32 JointCount = 18;
+
+	constexpr int32 TriangleCount = 67;
+
+	constexpr int32 IndexCount = TriangleCount * 3;
+
+	constexpr uint8 TriangleJoints[][3] =
+	{
+		// Center Symmetrical
+		{ 1, 12, 15 },	// Head, Left Up Leg, Right Up Leg
+		{ 1, 14, 17 },	// Head, Left Top Base, Right Toe Base
+		{ 3, 4, 8 },	// Spine 1, Left Shoulder, Right Shoulder
+		{ 3, 7, 11 },	// Spine 1, Left Hand, Right Hand
+		{ 3, 12, 15 },	// Spine 1, Left Up Leg, Right Up Leg
+
+		// Right Side Head
+		{ 1, 8, 2 },	// Head, Right Shoulder, Neck
+		{ 1, 8, 3 },	// Head, Right Shoulder, Spine 1
+		{ 1, 9, 10 },	// Head, Right Arm, Right Wrist
+		{ 1, 9, 17 },	// Head, Right Arm, Right Foot
+
+		// Right Side Chest
+		{ 3, 8, 1 },	// Spine 1, Right Shoulder, Neck
+		{ 3, 8, 10 },	// Spine 1, Right Shoulder, Right Wrist
+		{ 3, 15, 17 },	// Spine 1, Right Up Leg, Right Foot
+		{ 3, 9, 10 },	// Spine 1, Right Arm, Right Hand
+
+		// Right Side Hip
+		{ 15, 8, 12 },	// Right Up Leg, Right Shoulder, Left Up Leg
+		{ 15, 8, 9 },	// Right Up Leg, Right Shoulder, Right Arm
+		{ 15, 8, 10 },	// Right Up Leg, Right Shoulder, Right Wrist
+		{ 15, 1, 8 },	// Right Up Leg, Neck, Right Shoulder
+		{ 15, 9, 10 },	// Right Up Leg, Right Arm, Right Wrist
+		{ 15, 16, 13 },	// Right Up Leg, Right Leg, Left Knee
+		{ 15, 16, 17 },	// Right Up Leg, Right Leg, Right Foot
+
+		// Right Side Knee
+		{ 16, 7, 9 },	// Right Leg, Right Shoulder, Right Elbow
+		{ 16, 8, 13 },	// Right Leg, Right Shoulder, Left Leg
+		{ 16, 15, 12 },	// Right Leg, Right Hip, Left Hip
+		{ 16, 17, 14 },	// Right Leg, Right Foot, Left Foot
+
+		// Right Side Ankle
+		{ 17, 8, 4 },	// Right Foot, Right Shoulder, Left Shoulder
+		{ 17, 16, 13 },	// Right Foot, Right Leg, Left Leg
+
+		// Left Side Head
+		{ 1, 4, 2 },	// Head, Left Shoulder, Neck
+		{ 1, 4, 3 },	// Head, Left Shoulder, Spine 1
+		{ 1, 5, 6 },	// Head, Left Arm, Left  Wrist
+		{ 1, 5, 14 },	// Head, Left Arm, Left Foot
+
+		// Left Side Chest
+		{ 3, 4, 5 },	// Spine 1, Left Shoulder, Left Arm
+		{ 3, 4, 6 },	// Spine 1, Left Shoulder, Left Wrist
+		{ 3, 12, 14 },	// Spine 1, Left Leg Up, Left Foot
+		{ 3, 5, 6 },	// Spine 1, Left Arm, Left Hand
+
+		// Left Side Hip
+		{ 12, 4, 15 },	// Left Leg Up, Left Shoulder, Right Leg Up
+		{ 12, 4, 5 },	// Left Leg Up, Left Shoulder, Left Arm
+		{ 12, 4, 6 },	// Left Leg Up, Left Shoulder, Left Wrist
+		{ 12, 2, 4 },	// Left Leg Up, Neck, Left Shoulder
+		{ 12, 5, 6 },	// Left Leg Up, Left Arm, Left Wrist
+		{ 12, 13, 14 },	// Left Leg Up, Left Leg, Right Leg
+		{ 12, 12, 13 },	// Left Leg Up, Left Leg, Left Foot
+
+		// Left Side Leg
+		{ 13, 4, 5 },	// Left Leg, Left Shoulder, Left Arm
+		{ 13, 4, 16 },	// Left Leg, Left Shoulder, Right Leg
+		{ 13, 12, 15 },	// Left Leg, Left Leg Up, Right Leg Up
+		{ 13, 14, 17 },	// Left Leg, Left Foot, Right Foot
+
+		// Left Side Ankle
+		{ 14, 4, 8 },	// Left Foot, Left Shoulder, Right Shoulder
+		{ 14, 13, 16 },	// Left Foot, Left Leg, Right Leg
+
+		// Cross Center
+		{ 1, 9, 14 },	// Head, Right Elbow, Left Foot
+		{ 1, 5, 17 },	// Head, Left Elbow, Right Foot
+		{ 1, 9, 6 },	// Head, Right Elbow, Left Wrist
+		{ 1, 5, 10 },	// Head, Left Elbow, Right WRist
+		{ 3, 15, 6 },	// Spine 1, Right Hip, Left Wrist
+		{ 3, 12, 10 },	// Spine 1, Left Hip, Right Wrist
+		{ 3, 8, 6 },	// Spine 1, Right Shoulder, Left Wrist
+		{ 3, 4, 10 },	// Spine 1, Left Shoulder, Right Wrist
+		{ 15, 4, 9 },	// Right Up Leg, Left Shoulder, Right Arm
+		{ 12, 8, 5 },	// Left Leg Up, Right Shoulder, Left Arm
+		{ 15, 4, 10 },	// Right Up Leg, Left Shoulder, Right Wrist
+		{ 12, 8, 6 },	// Left Leg Up, Right Shoulder, Left Wrist
+		{ 15, 5, 10 },	// Right Up Leg, Left Arm, Right Wrist
+		{ 12, 9, 6 },	// Left Leg Up, Right Arm, Left Wrist
+		{ 15, 13, 10 },	// Right Up Leg, Left Leg, Right Wrist
+		{ 12, 16, 6 },	// Left Leg Up, Right Leg, Left Wrist
+		{ 15, 14, 16 },	// Right Up Leg, Left Foot, Right Leg
+		{ 12, 17, 13 },	// Left Leg Up, Right Root, Left Leg
+		{ 16, 4, 9 },	// Right Leg, Left Shoulder, Right Arm
+		{ 13, 8, 5 },	// Left Leg, Right Shoulder, Left Arm
+	};
+
+	constexpr bool AreJointIndexesInRange()
+	{
+		for (int32 Triangle = 0; Triangle < TriangleCount; Triangle++) {
+			for (int32 Corner = 0; Corner < 3; Corner++) {
+				if (TriangleJoints[Triangle][Corner] >= JointCount) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	static_assert(UE_ARRAY_COUNT(TriangleJoints) == TriangleCount, "TriangleCount does not match the TriangleJoints table");
+	static_assert(AreJointIndexesInRange(), "TriangleJoints refers to a joint outside the socket arrays");
+}